@@ -0,0 +1,254 @@
+/*  Filename:  bigfix.c
+ *
+ *  Author:    mandex contributors
+ *  Copyright: (c) 2026 mandex contributors. All rights reserved.
+ *             This work is licensed under the terms of the MIT license.
+ */
+
+#include <string.h>
+#include <float.h>
+#include <math.h>
+#include "bigfix.h"
+
+int bigfixLimbs(double spacing)
+{
+    // two guard limbs for the rounding errors accumulated while iterating
+    int limbs = 3;
+    while (spacing < 1.0 && limbs < BIGFIX_LIMBS) {
+        spacing *= 4294967296.0;    // 2^32
+        ++limbs;
+    }
+    return limbs;
+}
+
+static inline int isNegative(const BigFix* a)
+{
+    return (int32_t)a->limb[0] < 0;
+}
+
+static void negate(BigFix* r, const BigFix* a, int limbs)
+{
+    uint64_t carry = 1;
+    for (int i = limbs - 1; i >= 0; --i) {
+        carry += (uint32_t)~a->limb[i];
+        r->limb[i] = (uint32_t)carry;
+        carry >>= 32;
+    }
+}
+
+BigFix bigfixFromDouble(double a)
+{
+    BigFix r;
+    memset(&r, 0, sizeof(r));
+    int negative = a < 0.0;
+    if (negative)
+        a = -a;
+
+    // the integer part must fit into the first limb
+    if (a >= 2147483648.0)
+        a = 2147483647.0;
+
+    double part = (double)(uint32_t)a;
+    r.limb[0] = (uint32_t)part;
+    a -= part;
+    for (int i = 1; i < BIGFIX_LIMBS && a != 0.0; ++i) {
+        a *= 4294967296.0;
+        part = (double)(uint32_t)a;
+        r.limb[i] = (uint32_t)part;
+        a -= part;
+    }
+    if (negative)
+        negate(&r, &r, BIGFIX_LIMBS);
+    return r;
+}
+
+double bigfixToDouble(const BigFix* a)
+{
+    BigFix tmp;
+    double sign = 1.0;
+    if (isNegative(a)) {
+        negate(&tmp, a, BIGFIX_LIMBS);
+        a = &tmp;
+        sign = -1.0;
+    }
+
+    // three limbs hold more bits than a double, but start at the first nonzero one
+    int first = 0;
+    while (first < BIGFIX_LIMBS - 1 && a->limb[first] == 0)
+        ++first;
+
+    double scale = 1.0;
+    for (int i = 0; i < first; ++i)
+        scale *= 1.0 / 4294967296.0;
+
+    double r = 0.0;
+    for (int i = first; i < first + 3 && i < BIGFIX_LIMBS; ++i) {
+        r += a->limb[i] * scale;
+        scale *= 1.0 / 4294967296.0;
+    }
+    return sign * r;
+}
+
+qd_real bigfixToQD(const BigFix* a)
+{
+    BigFix rest = *a;
+    qd_real r;
+    for (int i = 0; i < 4; ++i) {
+        r.x[i] = bigfixToDouble(&rest);
+        BigFix part = bigfixFromDouble(r.x[i]);
+        bigfixSub(&rest, &rest, &part, BIGFIX_LIMBS);
+    }
+    return r;
+}
+
+void bigfixAdd(BigFix* r, const BigFix* a, const BigFix* b, int limbs)
+{
+    uint64_t carry = 0;
+    for (int i = limbs - 1; i >= 0; --i) {
+        carry += (uint64_t)a->limb[i] + b->limb[i];
+        r->limb[i] = (uint32_t)carry;
+        carry >>= 32;
+    }
+}
+
+void bigfixSub(BigFix* r, const BigFix* a, const BigFix* b, int limbs)
+{
+    BigFix nb;
+    negate(&nb, b, limbs);
+    bigfixAdd(r, a, &nb, limbs);
+}
+
+void bigfixMul(BigFix* r, const BigFix* a, const BigFix* b, int limbs)
+{
+    BigFix ta, tb;
+    int negative = 0;
+    if (isNegative(a)) {
+        negate(&ta, a, limbs);
+        a = &ta;
+        negative = !negative;
+    }
+    if (isNegative(b)) {
+        negate(&tb, b, limbs);
+        b = &tb;
+        negative = !negative;
+    }
+
+    // Column k of the product collects the terms a[i] * b[k - i]. Columns
+    // beyond the last limb are only needed for the carry into it, one guard
+    // column is enough for the precision the iterations need.
+    int columns = limbs + 1;
+    uint64_t low[BIGFIX_LIMBS + 1];
+    uint64_t high[BIGFIX_LIMBS + 1];
+    for (int k = 0; k < columns; ++k) {
+        uint64_t lo = 0;
+        uint64_t hi = 0;
+        int start = k - limbs + 1 > 0 ? k - limbs + 1 : 0;
+        int end = k < limbs - 1 ? k : limbs - 1;
+        for (int i = start; i <= end; ++i) {
+            uint64_t p = (uint64_t)a->limb[i] * b->limb[k - i];
+            lo += (uint32_t)p;
+            hi += p >> 32;
+        }
+        low[k] = lo;
+        high[k] = hi;
+    }
+
+    // The high half of column k belongs to column k - 1. What carries
+    // out of the integer part is dropped, like any two's complement overflow.
+    uint64_t carry = 0;
+    for (int k = columns - 1; k >= 0; --k) {
+        carry += low[k] + (k + 1 < columns ? high[k + 1] : 0);
+        if (k < limbs)
+            r->limb[k] = (uint32_t)carry;
+        carry >>= 32;
+    }
+    if (negative)
+        negate(r, r, limbs);
+}
+
+void bigfixAddDouble(BigFix* r, const BigFix* a, double b)
+{
+    BigFix tb = bigfixFromDouble(b);
+    bigfixAdd(r, a, &tb, BIGFIX_LIMBS);
+}
+
+// Value of the bits of the integer a below bit shift, as a fraction of 2^shift
+static double lowBits(const uint32_t* a, int shift)
+{
+    double low = 0.0;
+    for (int i = 0; i < BIGFIX_LIMBS; ++i) {
+        int base = 32 * (BIGFIX_LIMBS - 1 - i);
+        if (base >= shift)
+            continue;
+        uint32_t bits = base + 32 <= shift ? a[i] : a[i] & ((1u << (shift - base)) - 1);
+        low += ldexp(bits, base - shift);
+    }
+    return low;
+}
+
+int bigfixRoundToMultiple(BigFix* r, const BigFix* a, double step, uint32_t* multiple, double* distance)
+{
+    // step = m * 2^e with m odd and below 2^47
+    int exponent;
+    uint64_t m = (uint64_t)ldexp(frexp(step, &exponent), 47);
+    int e = exponent - 47;
+    while (m && !(m & 1)) {
+        m >>= 1;
+        ++e;
+    }
+
+    // The limbs of a are the integer a * 2^fractionBits, 2^e is bit shift of it
+    int fractionBits = 32 * (BIGFIX_LIMBS - 1);
+    int shift = fractionBits + e;
+    if (!m || shift < 0)
+        return 0;
+
+    BigFix abs = *a;
+    int negative = isNegative(a);
+    if (negative)
+        negate(&abs, a, BIGFIX_LIMBS);
+
+    // u = abs / 2^e without the bits below, divided by m 16 bits at a time
+    int words = shift / 32;
+    int bits = shift % 32;
+    uint64_t rest = 0;
+    for (int i = 0; i < BIGFIX_LIMBS; ++i) {
+        uint32_t u = i >= words ? abs.limb[i - words] >> bits : 0;
+        if (bits && i > words)
+            u |= abs.limb[i - words - 1] << (32 - bits);
+        uint64_t high = rest << 16 | u >> 16;
+        rest = high % m;
+        uint64_t low = rest << 16 | (u & 0xffff);
+        rest = low % m;
+        multiple[i] = (uint32_t)(high / m) << 16 | (uint32_t)(low / m);
+    }
+    double remainder = rest + lowBits(abs.limb, shift);
+
+    // abs = multiple * step + remainder * 2^e, the multiple is rounded to the nearest
+    int up = 2.0 * remainder >= (double)m;
+    for (int i = 0; i < BIGFIX_LIMBS; ++i) {
+        int base = 32 * (BIGFIX_LIMBS - 1 - i);
+        if (base + 32 <= shift)
+            abs.limb[i] = 0;
+        else if (base < shift)
+            abs.limb[i] &= ~((1u << (shift - base)) - 1);
+    }
+    bigfixAddDouble(&abs, &abs, -ldexp((double)rest, e));
+    if (up) {
+        bigfixAddDouble(&abs, &abs, ldexp((double)m, e));
+        for (int i = BIGFIX_LIMBS - 1; i >= 0 && ++multiple[i] == 0; --i)
+            ;
+    }
+    *distance = (remainder - (up ? (double)m : 0.0)) / (double)m;
+
+    if (negative) {
+        negate(&abs, &abs, BIGFIX_LIMBS);
+        BigFix count;
+        memcpy(count.limb, multiple, sizeof(count.limb));
+        negate(&count, &count, BIGFIX_LIMBS);
+        memcpy(multiple, count.limb, sizeof(count.limb));
+        *distance = -*distance;
+    }
+    *r = abs;
+    return 1;
+}
@@ -0,0 +1,96 @@
+/** @file        bigfix.h
+ *
+ *  @brief       Fixed point numbers with arbitrary (but bounded) precision.
+ *
+ *               A number consists of 32 bit limbs in two's complement. The first limb
+ *               is the signed integer part, the others are the fraction with the most
+ *               significant limb first. Operations take the number of limbs to use,
+ *               so the cost grows with the zoom depth instead of always paying for
+ *               the maximum precision.
+ *
+ *  @version     1.0
+ *  @date        10/17/2026
+ *  Revision:    -
+ *
+ *  @author      mandex contributors
+ *  @copyright   Copyright (c) 2026 mandex contributors. All rights reserved.
+ *               This work is licensed under the terms of the MIT license.
+ */
+
+#ifndef BIGFIX_H
+#define BIGFIX_H
+
+#include <stdint.h>
+#include "qd_real.h"
+
+// 31 fraction limbs resolve 2^-992, which is below the smallest
+// normal double, so deltas in double underflow before this runs out.
+#define BIGFIX_LIMBS 32
+
+/** @brief A fixed point number
+ */
+
+typedef struct {
+    uint32_t limb[BIGFIX_LIMBS];
+} BigFix;
+
+/** @brief Returns the number of limbs needed to resolve a spacing
+ *
+ *  @param spacing The smallest difference which must be representable
+ *  @return        Number of limbs, at most BIGFIX_LIMBS
+ */
+
+int bigfixLimbs(double spacing);
+
+/** @brief Converts a double exactly. Bits below the last limb are truncated.
+ */
+
+BigFix bigfixFromDouble(double a);
+
+/** @brief Converts to the nearest double
+ */
+
+double bigfixToDouble(const BigFix* a);
+
+/** @brief Converts to quad-double, which holds the first 212 bits
+ */
+
+qd_real bigfixToQD(const BigFix* a);
+
+/** @brief r = a + b. r may be one of the operands.
+ */
+
+void bigfixAdd(BigFix* r, const BigFix* a, const BigFix* b, int limbs);
+
+/** @brief r = a - b. r may be one of the operands.
+ */
+
+void bigfixSub(BigFix* r, const BigFix* a, const BigFix* b, int limbs);
+
+/** @brief r = a * b truncated to limbs. r may be one of the operands.
+ */
+
+void bigfixMul(BigFix* r, const BigFix* a, const BigFix* b, int limbs);
+
+/** @brief r = a + b for a double b, using all limbs
+ */
+
+void bigfixAddDouble(BigFix* r, const BigFix* a, double b);
+
+/** @brief Rounds to the nearest multiple of a step, exactly
+ *
+ *         The step must have at most 47 significant bits and not be finer than
+ *         the last limb resolves after dropping its trailing zero bits.
+ *
+ *  @param r        Receives the multiple. r may be a.
+ *  @param a        The number
+ *  @param step     The step, greater than 0
+ *  @param multiple Receives the number of steps of r: an integer in two's complement
+ *                  with BIGFIX_LIMBS limbs, the most significant first
+ *  @param distance Receives a - r in steps, between -0.5 and 0.5
+ *  @return 1 on success, 0 if the step is too fine and nothing was written
+ */
+
+int bigfixRoundToMultiple(BigFix* r, const BigFix* a, double step, uint32_t* multiple, double* distance);
+
+#endif /* BIGFIX_H */
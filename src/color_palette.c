@@ -8,6 +8,17 @@
 #include <stdint.h>
 #include <stdlib.h>
 #include <time.h>
+#include "color_palette.h"
+
+// Points inside the set are drawn black (RGBA)
+#define INTERIOR_COLOR 0x000000FF
+
+// Largest change of a color channel from one gradient stop to the next
+#define SMOOTH_STEP 48
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define COLOR_PALETTE_X86
+#endif
 
 typedef union {
     uint32_t rgba;
@@ -37,9 +48,9 @@ void colorSmooth(uint32_t* colors, int num_colors)
     int16_t red = col[0].red;
     int16_t blue = col[0].blue;
     int16_t green = col[0].green;
-    int16_t delta_r = rand() % 7;
-    int16_t delta_b = rand() % 7;
-    int16_t delta_g = rand() % 7;
+    int16_t delta_r = rand() % (SMOOTH_STEP + 1);
+    int16_t delta_b = rand() % (SMOOTH_STEP + 1);
+    int16_t delta_g = rand() % (SMOOTH_STEP + 1);
 
     for (int i = 0; i < num_colors; ++i) {
         red += delta_r;
@@ -63,3 +74,78 @@ void colorSmooth(uint32_t* colors, int num_colors)
         col[i].alpha = 255;
     }
 }
+
+// Mixes two colors, weight is 0 for a and 256 for b
+static uint32_t mixColors(uint32_t a, uint32_t b, uint32_t weight)
+{
+    // two channels at once, each product fits into 16 bits
+    uint32_t rb = (((a & 0x00FF00FF) * (256 - weight) + (b & 0x00FF00FF) * weight) >> 8) & 0x00FF00FF;
+    uint32_t ga = (((a >> 8) & 0x00FF00FF) * (256 - weight) + ((b >> 8) & 0x00FF00FF) * weight) & 0xFF00FF00;
+    return rb | ga;
+}
+
+void colorBlend(struct ColorPalette* palette, int iterations)
+{
+    int steps = COLOR_SHADES / COLOR_STOPS;
+    for (int i = 0; i < COLOR_SHADES; ++i) {
+        uint32_t a = palette->stops[i / steps];
+        uint32_t b = palette->stops[(i / steps + 1) % COLOR_STOPS];
+        palette->shades[i] = mixColors(a, b, (uint32_t)(i % steps * 256 / steps));
+    }
+
+    // a shade every 1 / steps of the way from one stop to the next
+    int shift = 0;
+    while (shift < 24 && ((int64_t)COLOR_SHADES << (shift + 1)) <= ((int64_t)iterations << COLOR_FRACTION_BITS))
+        ++shift;
+    palette->shadeShift = shift;
+}
+
+// The periods are powers of two, so positions wrap around at the end of the palette
+static void colorShadeScalar(const struct ColorPalette* palette, const uint32_t* positions, uint32_t* pixels, int count)
+{
+    const uint32_t* shades = palette->shades;
+    int shift = palette->shadeShift;
+    for (int i = 0; i < count; ++i) {
+        uint32_t position = positions[i];
+        uint32_t color = shades[(position >> shift) & (COLOR_SHADES - 1)];
+        pixels[i] = position == COLOR_INTERIOR ? INTERIOR_COLOR : color;
+    }
+}
+
+#ifdef COLOR_PALETTE_X86
+
+#include <immintrin.h>
+
+#define TARGET_AVX2 __attribute__((target("avx2")))
+
+// Gathers the shades of 8 positions at once
+TARGET_AVX2 static void colorShadeAVX2(const struct ColorPalette* palette, const uint32_t* positions, uint32_t* pixels, int count)
+{
+    const __m256i mask = _mm256_set1_epi32(COLOR_SHADES - 1);
+    const __m256i interior = _mm256_set1_epi32((int)COLOR_INTERIOR);
+    const __m256i black = _mm256_set1_epi32(INTERIOR_COLOR);
+    const __m128i shift = _mm_cvtsi32_si128(palette->shadeShift);
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i position = _mm256_loadu_si256((const __m256i*)(positions + i));
+        __m256i index = _mm256_and_si256(_mm256_srl_epi32(position, shift), mask);
+        __m256i color = _mm256_i32gather_epi32((const int*)palette->shades, index, 4);
+        __m256i inside = _mm256_cmpeq_epi32(position, interior);
+        _mm256_storeu_si256((__m256i*)(pixels + i), _mm256_blendv_epi8(color, black, inside));
+    }
+    colorShadeScalar(palette, positions + i, pixels + i, count - i);
+}
+
+#endif
+
+void colorShade(const struct ColorPalette* palette, const uint32_t* positions, uint32_t* pixels, int count)
+{
+#ifdef COLOR_PALETTE_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        colorShadeAVX2(palette, positions, pixels, count);
+        return;
+    }
+#endif
+    colorShadeScalar(palette, positions, pixels, count);
+}
@@ -14,6 +14,33 @@
 
 #ifndef COLOR_PALETTE_H
 
+#include <stdint.h>
+
+// Number of gradient stops of a palette, a power of two
+#define COLOR_STOPS 16
+
+// Positions on a palette are iterations in 1 / 2^COLOR_FRACTION_BITS
+#define COLOR_FRACTION_BITS 4
+
+// Position of points inside the set, they are drawn black
+#define COLOR_INTERIOR UINT32_MAX
+
+// Colors blended between two stops, as many as fractions of an iteration
+#define COLOR_SHADES (COLOR_STOPS << COLOR_FRACTION_BITS)
+
+/** @brief A palette made of gradient stops.
+*
+*   Colors between two stops are interpolated, after the last stop the
+*   colors blend into the first one again, so the palette repeats.
+*   The blended colors take 1 kB, so they stay in the L1 cache while drawing.
+*/
+
+struct ColorPalette {
+    uint32_t stops[COLOR_STOPS];    // RGBA
+    uint32_t shades[COLOR_SHADES];  // blended by colorBlend()
+    int shadeShift;                 // positions from one shade to the next are 2^shadeShift
+};
+
 /** @brief Creates a completely random color palette
 *
 *   @param Array which is filled with random colors. Must be allocated before.
@@ -32,5 +59,25 @@ void colorRandom(uint32_t* colors, int num_colors);
 
 void colorSmooth(uint32_t* colors, int num_colors);
 
+/** @brief Blends the stops of a palette, must be called when they changed.
+*
+*   @param palette
+*   @param iterations After how many the colors repeat. Rounded down to a power of two, at least one per stop.
+*   @return void
+*/
+
+void colorBlend(struct ColorPalette* palette, int iterations);
+
+/** @brief Colors positions on a palette, e.g. smooth iteration counts.
+*
+*   @param palette
+*   @param positions Positions in 1 / 2^COLOR_FRACTION_BITS iterations, or COLOR_INTERIOR
+*   @param pixels    Receives the colors
+*   @param count     Number of positions
+*   @return void
+*/
+
+void colorShade(const struct ColorPalette* palette, const uint32_t* positions, uint32_t* pixels, int count);
+
 #define COLOR_PALETTE_H
 #endif /* COLOR_PALETTE_H */
@@ -0,0 +1,145 @@
+/** @file        dd_real.h
+ *
+ *  @brief       Double-double arithmetic. A number is the unevaluated sum of two
+ *               doubles, which gives about 106 bits of mantissa.
+ *
+ *               The algorithms are the ones of the QD library by Hida, Li and Bailey.
+ *               All functions are inline because they are used in the inner loop
+ *               of the iteration kernels.
+ *
+ *  @version     1.0
+ *  @date        10/17/2026
+ *  Revision:    -
+ *
+ *  @author      mandex contributors
+ *  @copyright   Copyright (c) 2026 mandex contributors. All rights reserved.
+ *               This work is licensed under the terms of the MIT license.
+ */
+
+#ifndef DD_REAL_H
+#define DD_REAL_H
+
+/** @brief A double-double number with |lo| <= ulp(hi) / 2
+ */
+
+typedef struct {
+    double hi;
+    double lo;
+} dd_real;
+
+/** @brief Error free sum, requires |a| >= |b|
+ */
+
+static inline double quick_two_sum(double a, double b, double* err)
+{
+    double s = a + b;
+    *err = b - (s - a);
+    return s;
+}
+
+/** @brief Error free sum of two doubles
+ */
+
+static inline double two_sum(double a, double b, double* err)
+{
+    double s = a + b;
+    double bb = s - a;
+    *err = (a - (s - bb)) + (b - bb);
+    return s;
+}
+
+/** @brief Error free product of two doubles
+ *
+ *  Uses the fma instruction if the compiler targets it, Dekker's split otherwise.
+ *  The simd kernels always use fma.
+ */
+
+static inline double two_prod(double a, double b, double* err)
+{
+    double p = a * b;
+#ifdef __FMA__
+    *err = __builtin_fma(a, b, -p);
+#else
+    const double splitter = 134217729.0;    // 2^27 + 1
+    double t = splitter * a;
+    double a_hi = t - (t - a);
+    double a_lo = a - a_hi;
+    t = splitter * b;
+    double b_hi = t - (t - b);
+    double b_lo = b - b_hi;
+    *err = ((a_hi * b_hi - p) + a_hi * b_lo + a_lo * b_hi) + a_lo * b_lo;
+#endif
+    return p;
+}
+
+static inline dd_real dd_from_double(double a)
+{
+    dd_real r = { a, 0.0 };
+    return r;
+}
+
+static inline dd_real dd_add(dd_real a, dd_real b)
+{
+    double e, f;
+    double s = two_sum(a.hi, b.hi, &e);
+    double t = two_sum(a.lo, b.lo, &f);
+    e += t;
+    s = quick_two_sum(s, e, &e);
+    e += f;
+    dd_real r;
+    r.hi = quick_two_sum(s, e, &r.lo);
+    return r;
+}
+
+static inline dd_real dd_neg(dd_real a)
+{
+    dd_real r = { -a.hi, -a.lo };
+    return r;
+}
+
+static inline dd_real dd_sub(dd_real a, dd_real b)
+{
+    return dd_add(a, dd_neg(b));
+}
+
+static inline dd_real dd_add_d(dd_real a, double b)
+{
+    double e;
+    double s = two_sum(a.hi, b, &e);
+    e += a.lo;
+    dd_real r;
+    r.hi = quick_two_sum(s, e, &r.lo);
+    return r;
+}
+
+static inline dd_real dd_mul(dd_real a, dd_real b)
+{
+    double e;
+    double p = two_prod(a.hi, b.hi, &e);
+    e += a.hi * b.lo + a.lo * b.hi;
+    dd_real r;
+    r.hi = quick_two_sum(p, e, &r.lo);
+    return r;
+}
+
+static inline dd_real dd_sqr(dd_real a)
+{
+    double e;
+    double p = two_prod(a.hi, a.hi, &e);
+    e += 2.0 * a.hi * a.lo;
+    e += a.lo * a.lo;
+    dd_real r;
+    r.hi = quick_two_sum(p, e, &r.lo);
+    return r;
+}
+
+/** @brief Multiplication with a power of two, which is exact
+ */
+
+static inline dd_real dd_mul_pwr2(dd_real a, double b)
+{
+    dd_real r = { a.hi * b, a.lo * b };
+    return r;
+}
+
+#endif /* DD_REAL_H */
@@ -0,0 +1,580 @@
+/*  Filename:  deflate.c
+ *
+ *  Author:    mandex contributors
+ *  Copyright: (c) 2026 mandex contributors. All rights reserved.
+ *             This work is licensed under the terms of the MIT license.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "deflate.h"
+
+#define WINDOW_SIZE 32768
+#define WINDOW_MASK (WINDOW_SIZE - 1)
+#define HASH_BITS 15
+#define HASH_SIZE (1 << HASH_BITS)
+
+#define MIN_MATCH 3
+#define MAX_MATCH 258
+#define MAX_CHAIN 64        // earlier positions compared for a match
+#define GOOD_MATCH 8        // a quarter of them after a match this long
+#define LAZY_MATCH 16       // no better match is looked for after one this long
+#define NICE_MATCH 128      // a match this long is taken at once
+#define TOO_FAR 4096        // shortest matches further back cost more than literals
+
+// Each block has its own codes for the frequencies of its symbols
+#define BLOCK_SYMBOLS 16384
+
+#define LITLEN_CODES 286
+#define DIST_CODES 30
+#define CODELEN_CODES 19
+#define MAX_BITS 15
+#define MAX_CODELEN_BITS 7
+#define END_OF_BLOCK 256
+#define STORED_MAX 65535
+
+static const uint16_t lengthBase[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+static const uint8_t lengthExtra[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+static const uint16_t distBase[DIST_CODES] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+static const uint8_t distExtra[DIST_CODES] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+static const uint8_t codeLengthOrder[CODELEN_CODES] = {
+    16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15
+};
+
+// A literal if dist is 0, then length is the byte
+struct Symbol {
+    uint16_t length;
+    uint16_t dist;
+};
+
+struct Deflater {
+    int32_t head[HASH_SIZE];            // latest position of each hash, -1 if none
+    int32_t prev[WINDOW_SIZE];          // position before with the same hash
+    uint8_t lengthCode[MAX_MATCH + 1];  // length code - 257
+    uint8_t distCode[512];              // see distanceCode()
+
+    const uint8_t* data;
+    int blockStart;                     // first byte of the block
+    int covered;                        // bytes of the symbols so far
+    struct Symbol symbols[BLOCK_SYMBOLS];
+    int numSymbols;
+    uint32_t litFreq[LITLEN_CODES];
+    uint32_t distFreq[DIST_CODES];
+
+    uint8_t* out;
+    size_t outSize;
+    uint64_t bits;                      // not written yet, fewer than 8
+    int numBits;
+};
+
+static inline void putBits(struct Deflater* d, uint32_t value, int numBits)
+{
+    d->bits |= (uint64_t)value << d->numBits;
+    d->numBits += numBits;
+    while (d->numBits >= 8) {
+        d->out[d->outSize++] = (uint8_t)d->bits;
+        d->bits >>= 8;
+        d->numBits -= 8;
+    }
+}
+
+static inline void alignBits(struct Deflater* d)
+{
+    putBits(d, 0, (8 - d->numBits) & 7);
+}
+
+static inline int distanceCode(const struct Deflater* d, int dist)
+{
+    return dist <= 256 ? d->distCode[dist - 1] : d->distCode[256 + ((dist - 1) >> 7)];
+}
+
+static void initDeflater(struct Deflater* d, const uint8_t* data, uint8_t* out)
+{
+    for (int i = 0; i < HASH_SIZE; ++i)
+        d->head[i] = -1;
+    for (int code = 0; code < 29; ++code) {
+        for (int length = lengthBase[code]; length < lengthBase[code] + (1 << lengthExtra[code]) && length <= MAX_MATCH; ++length)
+            d->lengthCode[length] = code;
+    }
+    // distances above 256 start at multiples of 128
+    for (int code = 0; code < DIST_CODES; ++code) {
+        for (int dist = distBase[code]; dist < distBase[code] + (1 << distExtra[code]); ++dist) {
+            if (dist <= 256)
+                d->distCode[dist - 1] = code;
+            else
+                d->distCode[256 + ((dist - 1) >> 7)] = code;
+        }
+    }
+    d->data = data;
+    d->blockStart = 0;
+    d->covered = 0;
+    d->numSymbols = 0;
+    memset(d->litFreq, 0, sizeof(d->litFreq));
+    memset(d->distFreq, 0, sizeof(d->distFreq));
+    d->out = out;
+    d->outSize = 0;
+    d->bits = 0;
+    d->numBits = 0;
+}
+
+// Huffman code lengths of the symbols sorted by frequency, the rarest first,
+// computed in place (Moffat and Katajainen). Becomes the lengths, longest first.
+static void minimumRedundancy(uint32_t* a, int n)
+{
+    a[0] += a[1];
+    int root = 0;
+    int leaf = 2;
+    for (int next = 1; next < n - 1; ++next) {
+        if (leaf >= n || a[root] < a[leaf]) {
+            a[next] = a[root];
+            a[root++] = next;
+        }
+        else {
+            a[next] = a[leaf++];
+        }
+        if (leaf >= n || (root < next && a[root] < a[leaf])) {
+            a[next] += a[root];
+            a[root++] = next;
+        }
+        else {
+            a[next] += a[leaf++];
+        }
+    }
+
+    a[n - 2] = 0;
+    for (int next = n - 3; next >= 0; --next)
+        a[next] = a[a[next]] + 1;
+
+    int available = 1;
+    int used = 0;
+    int depth = 0;
+    root = n - 2;
+    int next = n - 1;
+    while (available > 0) {
+        while (root >= 0 && (int)a[root] == depth) {
+            ++used;
+            --root;
+        }
+        while (available > used) {
+            a[next--] = depth;
+            --available;
+        }
+        available = 2 * used;
+        ++depth;
+        used = 0;
+    }
+}
+
+static int compareFrequency(const void* a, const void* b)
+{
+    const uint32_t* x = a;
+    const uint32_t* y = b;
+    if (x[0] != y[0])
+        return x[0] < y[0] ? -1 : 1;
+    return x[1] < y[1] ? -1 : x[1] > y[1];
+}
+
+// Code lengths of at most maxBits for the frequencies of n symbols
+static void buildCodeLengths(const uint32_t* freq, int n, int maxBits, uint8_t* lengths)
+{
+    uint32_t sorted[LITLEN_CODES][2];   // frequency and symbol
+    uint32_t a[LITLEN_CODES];
+    int used = 0;
+
+    memset(lengths, 0, n);
+    for (int i = 0; i < n; ++i) {
+        if (freq[i]) {
+            sorted[used][0] = freq[i];
+            sorted[used++][1] = i;
+        }
+    }
+    // a code with a single symbol is completed by another one
+    if (used < 2) {
+        int symbol = used ? (int)sorted[0][1] : 0;
+        lengths[symbol] = 1;
+        lengths[symbol ? 0 : 1] = 1;
+        return;
+    }
+
+    qsort(sorted, used, sizeof(sorted[0]), compareFrequency);
+    for (int i = 0; i < used; ++i)
+        a[i] = sorted[i][0];
+    minimumRedundancy(a, used);
+
+    // longer codes are shortened and shorter ones lengthened until the code is complete again
+    int count[MAX_BITS + 1] = {0};
+    for (int i = 0; i < used; ++i)
+        ++count[a[i] > (uint32_t)maxBits ? maxBits : (int)a[i]];
+    uint32_t total = 0;
+    for (int bits = 1; bits <= maxBits; ++bits)
+        total += (uint32_t)count[bits] << (maxBits - bits);
+    while (total > 1u << maxBits) {
+        --count[maxBits];
+        for (int bits = maxBits - 1; bits > 0; --bits) {
+            if (count[bits]) {
+                --count[bits];
+                count[bits + 1] += 2;
+                break;
+            }
+        }
+        --total;
+    }
+
+    int symbol = 0;
+    for (int bits = maxBits; bits > 0; --bits) {
+        for (int i = 0; i < count[bits]; ++i)
+            lengths[sorted[symbol++][1]] = bits;
+    }
+}
+
+// Canonical codes of the lengths, bit reversed since deflate writes the lowest bit first
+static void buildCodes(const uint8_t* lengths, int n, uint16_t* codes)
+{
+    int count[MAX_BITS + 1] = {0};
+    uint32_t next[MAX_BITS + 1];
+    for (int i = 0; i < n; ++i)
+        ++count[lengths[i]];
+    count[0] = 0;
+
+    uint32_t code = 0;
+    for (int bits = 1; bits <= MAX_BITS; ++bits) {
+        code = (code + count[bits - 1]) << 1;
+        next[bits] = code;
+    }
+    for (int i = 0; i < n; ++i) {
+        if (!lengths[i])
+            continue;
+        uint32_t c = next[lengths[i]]++;
+        uint32_t reversed = 0;
+        for (int bit = 0; bit < lengths[i]; ++bit) {
+            reversed = reversed << 1 | (c & 1);
+            c >>= 1;
+        }
+        codes[i] = reversed;
+    }
+}
+
+// The code lengths of both codes as written in the header of a block,
+// with runs of lengths coded by the symbols 16 (repeat), 17 and 18 (zeros).
+// Returns the number of symbols, each has its extra bits in the upper byte.
+static int runLengths(const uint8_t* lengths, int n, uint16_t* runs, uint32_t* freq)
+{
+    int numRuns = 0;
+    int i = 0;
+    while (i < n) {
+        int length = lengths[i];
+        int run = 1;
+        while (i + run < n && lengths[i + run] == length)
+            ++run;
+        i += run;
+
+        if (length == 0) {
+            while (run >= 11) {
+                int part = run < 138 ? run : 138;
+                runs[numRuns++] = 18 | (part - 11) << 8;
+                run -= part;
+            }
+            if (run >= 3) {
+                runs[numRuns++] = 17 | (run - 3) << 8;
+                run = 0;
+            }
+        }
+        else {
+            runs[numRuns++] = length;
+            --run;
+            while (run >= 3) {
+                int part = run < 6 ? run : 6;
+                runs[numRuns++] = 16 | (part - 3) << 8;
+                run -= part;
+            }
+        }
+        while (run-- > 0)
+            runs[numRuns++] = length;
+    }
+    for (int r = 0; r < numRuns; ++r)
+        ++freq[runs[r] & 0xff];
+    return numRuns;
+}
+
+static void writeStored(struct Deflater* d, const uint8_t* data, int size, int last)
+{
+    do {
+        int part = size < STORED_MAX ? size : STORED_MAX;
+        size -= part;
+        putBits(d, last && !size, 1);
+        putBits(d, 0, 2);
+        alignBits(d);
+        putBits(d, part, 16);
+        putBits(d, ~part & 0xffff, 16);
+        memcpy(d->out + d->outSize, data, part);
+        d->outSize += part;
+        data += part;
+    } while (size);
+}
+
+// Writes the symbols as block with their own codes, or the bytes as stored
+// block if that is shorter
+static void writeBlock(struct Deflater* d, int last)
+{
+    static const uint8_t runExtra[3] = {2, 3, 7};
+    uint8_t litLengths[LITLEN_CODES];
+    uint8_t distLengths[DIST_CODES];
+    uint8_t lengths[LITLEN_CODES + DIST_CODES];
+    uint16_t runs[LITLEN_CODES + DIST_CODES];
+    uint32_t runFreq[CODELEN_CODES] = {0};
+    uint8_t runLengthsBits[CODELEN_CODES];
+    uint16_t litCodes[LITLEN_CODES];
+    uint16_t distCodes[DIST_CODES];
+    uint16_t runCodes[CODELEN_CODES];
+
+    ++d->litFreq[END_OF_BLOCK];
+    buildCodeLengths(d->litFreq, LITLEN_CODES, MAX_BITS, litLengths);
+    buildCodeLengths(d->distFreq, DIST_CODES, MAX_BITS, distLengths);
+
+    int numLit = LITLEN_CODES;
+    while (numLit > 257 && !litLengths[numLit - 1])
+        --numLit;
+    int numDist = DIST_CODES;
+    while (numDist > 1 && !distLengths[numDist - 1])
+        --numDist;
+    memcpy(lengths, litLengths, numLit);
+    memcpy(lengths + numLit, distLengths, numDist);
+    int numRuns = runLengths(lengths, numLit + numDist, runs, runFreq);
+    buildCodeLengths(runFreq, CODELEN_CODES, MAX_CODELEN_BITS, runLengthsBits);
+    int numRunCodes = CODELEN_CODES;
+    while (numRunCodes > 4 && !runLengthsBits[codeLengthOrder[numRunCodes - 1]])
+        --numRunCodes;
+
+    uint64_t bits = 3 + 14 + 3 * numRunCodes;
+    for (int i = 0; i < CODELEN_CODES; ++i)
+        bits += (uint64_t)runFreq[i] * (runLengthsBits[i] + (i >= 16 ? runExtra[i - 16] : 0));
+    for (int i = 0; i < LITLEN_CODES; ++i)
+        bits += (uint64_t)d->litFreq[i] * (litLengths[i] + (i > END_OF_BLOCK ? lengthExtra[i - 257] : 0));
+    for (int i = 0; i < DIST_CODES; ++i)
+        bits += (uint64_t)d->distFreq[i] * (distLengths[i] + distExtra[i]);
+
+    // header and longest alignment of each stored block
+    int size = d->covered - d->blockStart;
+    uint64_t storedBits = (uint64_t)(size / STORED_MAX + 1) * (3 + 7 + 32) + 8 * (uint64_t)size;
+
+    if (storedBits <= bits) {
+        writeStored(d, d->data + d->blockStart, size, last);
+    }
+    else {
+        buildCodes(litLengths, LITLEN_CODES, litCodes);
+        buildCodes(distLengths, DIST_CODES, distCodes);
+        buildCodes(runLengthsBits, CODELEN_CODES, runCodes);
+
+        putBits(d, last, 1);
+        putBits(d, 2, 2);
+        putBits(d, numLit - 257, 5);
+        putBits(d, numDist - 1, 5);
+        putBits(d, numRunCodes - 4, 4);
+        for (int i = 0; i < numRunCodes; ++i)
+            putBits(d, runLengthsBits[codeLengthOrder[i]], 3);
+        for (int r = 0; r < numRuns; ++r) {
+            int symbol = runs[r] & 0xff;
+            putBits(d, runCodes[symbol], runLengthsBits[symbol]);
+            if (symbol >= 16)
+                putBits(d, runs[r] >> 8, runExtra[symbol - 16]);
+        }
+
+        for (int s = 0; s < d->numSymbols; ++s) {
+            struct Symbol symbol = d->symbols[s];
+            if (!symbol.dist) {
+                putBits(d, litCodes[symbol.length], litLengths[symbol.length]);
+                continue;
+            }
+            int code = d->lengthCode[symbol.length];
+            putBits(d, litCodes[257 + code], litLengths[257 + code]);
+            putBits(d, symbol.length - lengthBase[code], lengthExtra[code]);
+            code = distanceCode(d, symbol.dist);
+            putBits(d, distCodes[code], distLengths[code]);
+            putBits(d, symbol.dist - distBase[code], distExtra[code]);
+        }
+        putBits(d, litCodes[END_OF_BLOCK], litLengths[END_OF_BLOCK]);
+    }
+
+    d->blockStart = d->covered;
+    d->numSymbols = 0;
+    memset(d->litFreq, 0, sizeof(d->litFreq));
+    memset(d->distFreq, 0, sizeof(d->distFreq));
+}
+
+static inline void putLiteral(struct Deflater* d, uint8_t byte)
+{
+    d->symbols[d->numSymbols].length = byte;
+    d->symbols[d->numSymbols++].dist = 0;
+    ++d->litFreq[byte];
+    ++d->covered;
+    if (d->numSymbols == BLOCK_SYMBOLS)
+        writeBlock(d, 0);
+}
+
+static inline void putMatch(struct Deflater* d, int length, int dist)
+{
+    d->symbols[d->numSymbols].length = length;
+    d->symbols[d->numSymbols++].dist = dist;
+    ++d->litFreq[257 + d->lengthCode[length]];
+    ++d->distFreq[distanceCode(d, dist)];
+    d->covered += length;
+    if (d->numSymbols == BLOCK_SYMBOLS)
+        writeBlock(d, 0);
+}
+
+// Enters a position with at least MIN_MATCH bytes left, returns the latest one with the same hash
+static inline int insertHash(struct Deflater* d, int pos)
+{
+    const uint8_t* p = d->data + pos;
+    uint32_t hash = ((uint32_t)p[0] << 16 | p[1] << 8 | p[2]) * 2654435761u >> (32 - HASH_BITS);
+    int candidate = d->head[hash];
+    d->prev[pos & WINDOW_MASK] = candidate;
+    d->head[hash] = pos;
+    return candidate;
+}
+
+// Longest match longer than best at an earlier position of the hash chain
+static int longestMatch(struct Deflater* d, int pos, int end, int candidate, int best, int* dist)
+{
+    int chain = best >= GOOD_MATCH ? MAX_CHAIN >> 2 : MAX_CHAIN;
+    int maxLength = end - pos < MAX_MATCH ? end - pos : MAX_MATCH;
+    // older positions of the chain are overwritten in prev, -1 ends it
+    int limit = pos > WINDOW_SIZE ? pos - WINDOW_SIZE : -1;
+    const uint8_t* scan = d->data + pos;
+
+    if (best < MIN_MATCH - 1)
+        best = MIN_MATCH - 1;
+    while (candidate > limit && chain-- > 0 && best < maxLength) {
+        const uint8_t* match = d->data + candidate;
+        if (match[best] == scan[best] && match[0] == scan[0] && match[1] == scan[1]) {
+            int length = 2;
+            while (length < maxLength && match[length] == scan[length])
+                ++length;
+            if (length > best) {
+                best = length;
+                *dist = pos - candidate;
+                if (length >= NICE_MATCH)
+                    break;
+            }
+        }
+        candidate = d->prev[candidate & WINDOW_MASK];
+    }
+    return best;
+}
+
+size_t deflateStripBound(size_t size)
+{
+    return size + size / 1024 + 64;
+}
+
+// Each match is only taken if the next position has no longer one (lazy matching, as zlib)
+size_t deflateStrip(const uint8_t* data, size_t size, int last, uint8_t* out)
+{
+    struct Deflater* d = malloc(sizeof(struct Deflater));
+    if (!d)
+        return 0;
+    initDeflater(d, data, out);
+
+    int end = (int)size;
+    int pos = 0;
+    int prevLength = 0;
+    int prevDist = 0;
+    int hasLiteral = 0;     // the byte before pos isn't covered yet
+    while (pos < end) {
+        int length = 0;
+        int dist = 0;
+        if (pos + MIN_MATCH <= end) {
+            int candidate = insertHash(d, pos);
+            if (candidate >= 0 && prevLength < LAZY_MATCH) {
+                length = longestMatch(d, pos, end, candidate, prevLength, &dist);
+                if (length <= prevLength || length < MIN_MATCH || (length == MIN_MATCH && dist > TOO_FAR))
+                    length = 0;
+            }
+        }
+
+        if (prevLength >= MIN_MATCH && !length) {
+            putMatch(d, prevLength, prevDist);
+            int matchEnd = pos - 1 + prevLength;
+            for (int p = pos + 1; p < matchEnd && p + MIN_MATCH <= end; ++p)
+                insertHash(d, p);
+            pos = matchEnd;
+            prevLength = 0;
+            hasLiteral = 0;
+        }
+        else {
+            if (hasLiteral)
+                putLiteral(d, data[pos - 1]);
+            prevLength = length;
+            prevDist = dist;
+            hasLiteral = 1;
+            ++pos;
+        }
+    }
+    if (hasLiteral)
+        putLiteral(d, data[pos - 1]);
+
+    if (d->numSymbols || last)
+        writeBlock(d, last);
+    if (!last) {
+        // an empty stored block ends the strip on a byte
+        putBits(d, 0, 3);
+        alignBits(d);
+        putBits(d, 0, 16);
+        putBits(d, 0xffff, 16);
+    }
+    alignBits(d);
+
+    size_t outSize = d->outSize;
+    free(d);
+    return outSize;
+}
+
+#define ADLER_BASE 65521
+#define ADLER_NMAX 5552     // bytes summed before the sums could overflow
+
+uint32_t adler32Update(uint32_t adler, const uint8_t* data, size_t size)
+{
+    uint32_t a = adler & 0xffff;
+    uint32_t b = adler >> 16;
+    while (size) {
+        size_t part = size < ADLER_NMAX ? size : ADLER_NMAX;
+        size -= part;
+        while (part--) {
+            a += *data++;
+            b += a;
+        }
+        a %= ADLER_BASE;
+        b %= ADLER_BASE;
+    }
+    return b << 16 | a;
+}
+
+uint32_t adler32Combine(uint32_t adler, uint32_t adlerNext, size_t sizeNext)
+{
+    uint32_t rem = sizeNext % ADLER_BASE;
+    uint32_t a = adler & 0xffff;
+    uint32_t b = (uint32_t)(((uint64_t)rem * a) % ADLER_BASE);
+    a += (adlerNext & 0xffff) + ADLER_BASE - 1;
+    b += (adler >> 16) + (adlerNext >> 16) + ADLER_BASE - rem;
+    if (a >= ADLER_BASE)
+        a -= ADLER_BASE;
+    if (a >= ADLER_BASE)
+        a -= ADLER_BASE;
+    if (b >= 2 * ADLER_BASE)
+        b -= 2 * ADLER_BASE;
+    if (b >= ADLER_BASE)
+        b -= ADLER_BASE;
+    return b << 16 | a;
+}
@@ -0,0 +1,68 @@
+/** @file        deflate.h
+ *
+ *  @brief       Compresses data in the deflate format of zlib and png.
+ *
+ *               Data is compressed in strips which don't refer to each other, so
+ *               several threads can compress the strips of one stream at once.
+ *               Each strip but the last ends on a byte with an empty stored block,
+ *               so the compressed strips are joined by writing them one after
+ *               the other.
+ *
+ *  @version     1.0
+ *  @date        10/17/2026
+ *  Revision:    -
+ *
+ *  @author      mandex contributors
+ *  @copyright   Copyright (c) 2026 mandex contributors. All rights reserved.
+ *               This work is licensed under the terms of the MIT license.
+ */
+
+#ifndef DEFLATE_H
+#define DEFLATE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Adler-32 checksum of no data
+#define ADLER32_INIT 1
+
+/** @brief Size of a buffer which holds a compressed strip in any case
+ *
+ *  @param size Bytes of the strip
+ *  @return Bytes of the buffer
+ */
+
+size_t deflateStripBound(size_t size);
+
+/** @brief Compresses a strip of a stream as deflate blocks
+ *
+ *  @param data Bytes of the strip
+ *  @param size Number of bytes, at most INT_MAX
+ *  @param last If the strip ends the stream
+ *  @param out  Receives the blocks, must have deflateStripBound() bytes
+ *  @return Number of bytes written to out, 0 if allocation failed
+ */
+
+size_t deflateStrip(const uint8_t* data, size_t size, int last, uint8_t* out);
+
+/** @brief Continues an Adler-32 checksum, as zlib has at the end of a stream
+ *
+ *  @param adler Checksum of the data before, ADLER32_INIT at the start
+ *  @param data
+ *  @param size Number of bytes
+ *  @return Checksum including data
+ */
+
+uint32_t adler32Update(uint32_t adler, const uint8_t* data, size_t size);
+
+/** @brief Checksum of two parts of data from the checksums of both parts
+ *
+ *  @param adler     Checksum of the first part
+ *  @param adlerNext Checksum of the second part alone
+ *  @param sizeNext  Bytes of the second part
+ *  @return Checksum of both parts
+ */
+
+uint32_t adler32Combine(uint32_t adler, uint32_t adlerNext, size_t sizeNext);
+
+#endif /* DEFLATE_H */
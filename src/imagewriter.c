@@ -0,0 +1,171 @@
+/*  Filename:  imagewriter.c
+ *
+ *  Author:    mandex contributors
+ *  Copyright: (c) 2026 mandex contributors. All rights reserved.
+ *             This work is licensed under the terms of the MIT license.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <SDL2/SDL.h>
+#include "imagewriter.h"
+#include "saveBmp.h"
+#include "savePng.h"
+
+struct QueuedImage {
+    struct QueuedImage* next;
+    char filename[IMAGE_NAME_SIZE];
+    uint32_t* pixels;
+    ImageCopy copy;     // copies the pixels if they are NULL
+    void* source;
+    int32_t width;
+    int32_t height;
+};
+
+struct ImageWriter {
+    SDL_Thread* thread;
+    SDL_mutex* lock;
+    SDL_cond* wake;
+    struct QueuedImage* queue;
+    struct QueuedImage** queueEnd;
+    int queued;
+    int saved;
+    int failed;
+    int closing;
+};
+
+int saveImage(const char* filename, const uint32_t* pixels, int32_t width, int32_t height)
+{
+    int result = savePNG(filename, pixels, width, height);
+    const char* extension = strrchr(filename, '.');
+    if (result != -2 || !extension || strcmp(extension, ".png") || strlen(filename) >= IMAGE_NAME_SIZE)
+        return result;
+
+    // a bmp only needs one row in memory
+    char bmpName[IMAGE_NAME_SIZE];
+    strcpy(bmpName, filename);
+    strcpy(bmpName + (extension - filename), ".bmp");
+    return saveBMP(bmpName, pixels, width, height);
+}
+
+static int writeImages(void* data)
+{
+    ImageWriter* writer = data;
+    SDL_LockMutex(writer->lock);
+    for (;;) {
+        while (!writer->queue && !writer->closing)
+            SDL_CondWait(writer->wake, writer->lock);
+        struct QueuedImage* image = writer->queue;
+        if (!image)
+            break;
+        writer->queue = image->next;
+        if (!writer->queue)
+            writer->queueEnd = &writer->queue;
+        SDL_UnlockMutex(writer->lock);
+
+        if (image->copy) {
+            size_t height = image->height < 0 ? -(size_t)image->height : (size_t)image->height;
+            image->pixels = malloc((size_t)image->width * height * sizeof(uint32_t));
+            image->copy(image->source, image->pixels);
+        }
+        int result = image->pixels ? saveImage(image->filename, image->pixels, image->width, image->height) : -2;
+        free(image->pixels);
+        free(image);
+
+        SDL_LockMutex(writer->lock);
+        --writer->queued;
+        if (result)
+            ++writer->failed;
+        else
+            ++writer->saved;
+    }
+    SDL_UnlockMutex(writer->lock);
+    return 0;
+}
+
+ImageWriter* createImageWriter(void)
+{
+    ImageWriter* writer = calloc(1, sizeof(ImageWriter));
+    if (!writer)
+        return NULL;
+    writer->queueEnd = &writer->queue;
+
+    writer->lock = SDL_CreateMutex();
+    writer->wake = SDL_CreateCond();
+    if (writer->lock && writer->wake)
+        writer->thread = SDL_CreateThread(writeImages, "imagewriter", writer);
+    if (!writer->thread) {
+        freeImageWriter(writer);
+        return NULL;
+    }
+    return writer;
+}
+
+void freeImageWriter(ImageWriter* writer)
+{
+    if (!writer)
+        return;
+    if (writer->thread) {
+        SDL_LockMutex(writer->lock);
+        writer->closing = 1;
+        SDL_CondSignal(writer->wake);
+        SDL_UnlockMutex(writer->lock);
+        SDL_WaitThread(writer->thread, NULL);
+    }
+    if (writer->wake)
+        SDL_DestroyCond(writer->wake);
+    if (writer->lock)
+        SDL_DestroyMutex(writer->lock);
+    free(writer);
+}
+
+static int enqueue(ImageWriter* writer, const char* filename, uint32_t* pixels, ImageCopy copy, void* source,
+                   int32_t width, int32_t height)
+{
+    struct QueuedImage* image = malloc(sizeof(struct QueuedImage));
+    if (!image || strlen(filename) >= IMAGE_NAME_SIZE) {
+        free(image);
+        free(pixels);
+        if (copy)
+            copy(source, NULL);
+        SDL_LockMutex(writer->lock);
+        ++writer->failed;
+        SDL_UnlockMutex(writer->lock);
+        return 1;
+    }
+    strcpy(image->filename, filename);
+    image->pixels = pixels;
+    image->copy = copy;
+    image->source = source;
+    image->width = width;
+    image->height = height;
+    image->next = NULL;
+
+    SDL_LockMutex(writer->lock);
+    *writer->queueEnd = image;
+    writer->queueEnd = &image->next;
+    ++writer->queued;
+    SDL_CondSignal(writer->wake);
+    SDL_UnlockMutex(writer->lock);
+    return 0;
+}
+
+int queueImage(ImageWriter* writer, const char* filename, uint32_t* pixels, int32_t width, int32_t height)
+{
+    return enqueue(writer, filename, pixels, NULL, NULL, width, height);
+}
+
+int queueImageCopy(ImageWriter* writer, const char* filename, ImageCopy copy, void* source,
+                   int32_t width, int32_t height)
+{
+    return enqueue(writer, filename, NULL, copy, source, width, height);
+}
+
+void getImageWriterStats(ImageWriter* writer, int* queued, int* saved, int* failed)
+{
+    SDL_LockMutex(writer->lock);
+    *queued = writer->queued;
+    *saved = writer->saved;
+    *failed = writer->failed;
+    SDL_UnlockMutex(writer->lock);
+}
@@ -0,0 +1,104 @@
+/** @file        imagewriter.h
+ *
+ *  @brief       Saves images with a thread in the background.
+ *
+ *               Images are queued with their pixels and compressed and written
+ *               to their files in order by the thread, so the caller goes on at
+ *               once however slow the storage is.
+ *
+ *  @version     1.0
+ *  @date        10/17/2026
+ *  Revision:    -
+ *
+ *  @author      mandex contributors
+ *  @copyright   Copyright (c) 2026 mandex contributors. All rights reserved.
+ *               This work is licensed under the terms of the MIT license.
+ */
+
+#ifndef IMAGEWRITER_H
+#define IMAGEWRITER_H
+
+#include <stdint.h>
+
+// Longest file name of an image, with the terminating zero
+#define IMAGE_NAME_SIZE 64
+
+typedef struct ImageWriter ImageWriter;
+
+/** @brief Copies the pixels of a queued image, called by the thread of the writer
+ *
+ *  @param source The source passed to queueImageCopy(), it is released by the call
+ *  @param pixels Receives the pixels, NULL if there is no memory for them
+ */
+
+typedef void (*ImageCopy)(void* source, uint32_t* pixels);
+
+/** @brief Starts the thread which saves the images
+ *
+ *  @return Pointer to the writer, NULL if it couldn't be started. Must be freed with freeImageWriter().
+ */
+
+ImageWriter* createImageWriter(void);
+
+/** @brief Saves the images still queued and stops the thread
+ *
+ *  @param writer May be NULL.
+ */
+
+void freeImageWriter(ImageWriter* writer);
+
+/** @brief Saves an image as png file, see savePNG()
+ *
+ *         If there is not enough memory for compressing it, it is saved as bmp
+ *         file instead, with the extension .png of filename replaced by .bmp.
+ *
+ *  @param filename Name or path of the file, ending with .png
+ *  @param pixels   The pixels of the image
+ *  @param width    The image width in pixels
+ *  @param height   The image height in pixels. Can be negative to invert y-axis
+ *  @return 0 if the image is saved
+ */
+
+int saveImage(const char* filename, const uint32_t* pixels, int32_t width, int32_t height);
+
+/** @brief Queues an image to be saved, see saveImage()
+ *
+ *  @param writer
+ *  @param filename Name or path of the file, it is copied
+ *  @param pixels   The pixels of the image, allocated with malloc(). The writer frees
+ *                  them once they are saved, also if the image can't be queued.
+ *  @param width    The image width in pixels
+ *  @param height   The image height in pixels. Can be negative to invert y-axis
+ *  @return 0 if the image is queued, else it counts as failed
+ */
+
+int queueImage(ImageWriter* writer, const char* filename, uint32_t* pixels, int32_t width, int32_t height);
+
+/** @brief Queues an image whose pixels are copied by the thread of the writer, see queueImage()
+ *
+ *         The caller doesn't need memory for the pixels, e.g. for a snapshot of
+ *         the screen which is copied once it is saved.
+ *
+ *  @param writer
+ *  @param filename Name or path of the file, it is copied
+ *  @param copy     Copies the pixels, called once also if the image can't be queued
+ *  @param source   Passed to copy
+ *  @param width    The image width in pixels
+ *  @param height   The image height in pixels. Can be negative to invert y-axis
+ *  @return 0 if the image is queued, else it counts as failed
+ */
+
+int queueImageCopy(ImageWriter* writer, const char* filename, ImageCopy copy, void* source,
+                   int32_t width, int32_t height);
+
+/** @brief Tells how many images are queued and how many were saved
+ *
+ *  @param writer
+ *  @param queued Receives the number of images not saved yet
+ *  @param saved  Receives the number of images saved since the writer was created
+ *  @param failed Receives the number of images which couldn't be saved
+ */
+
+void getImageWriterStats(ImageWriter* writer, int* queued, int* saved, int* failed);
+
+#endif /* IMAGEWRITER_H */
@@ -8,86 +8,1038 @@
 #include <stdlib.h>
 #include <stddef.h>
 #include <string.h>
+#include <float.h>
+#include <math.h>
 #include "mandelbrot.h"
+#include "mandelkernel.h"
 
-// complex double
-struct complexd {
-    double re;
-    double im;
-};
+// Kernels are selected once when the first points are created
+static const struct MandelKernels* kernels;
 
-struct MandelPoint {
-    struct complexd c;
-    struct complexd z;
-    uint32_t diverged;
-    uint32_t iterations;
-};
+// Size of one lane rounded up, so every lane starts at a multiple of 64 bytes
+static size_t laneSize(uint32_t numPoints, size_t elementSize)
+{
+    return (numPoints * elementSize + 63) & ~(size_t)63;
+}
 
 MandelPoint* createMandelPoint(uint32_t numPoints)
 {
-    return malloc(numPoints * sizeof(MandelPoint));
+    if (!kernels)
+        kernels = selectMandelKernels();
+
+    MandelPoint* points = malloc(sizeof(MandelPoint));
+    if (!points)
+        return NULL;
+
+    size_t sizeDouble = laneSize(numPoints, sizeof(double));
+    size_t sizeInt = laneSize(numPoints, sizeof(uint32_t));
+    size_t sizeByte = laneSize(numPoints, sizeof(uint8_t));
+    points->memory = malloc(6 * sizeDouble + 3 * sizeInt + 2 * sizeByte + 63);
+    if (!points->memory) {
+        free(points);
+        return NULL;
+    }
+
+    uint8_t* lane = (uint8_t*)(((uintptr_t)points->memory + 63) & ~(uintptr_t)63);
+    points->c_re = (double*)lane;
+    points->c_im = (double*)(lane += sizeDouble);
+    points->z_re = (double*)(lane += sizeDouble);
+    points->z_im = (double*)(lane += sizeDouble);
+    points->zs_re = (double*)(lane += sizeDouble);
+    points->zs_im = (double*)(lane += sizeDouble);
+    points->iterations = (uint32_t*)(lane += sizeDouble);
+    points->diverged = (uint32_t*)(lane += sizeInt);
+    points->preview = (uint32_t*)(lane += sizeInt);
+    points->reference = lane + sizeInt;
+    points->smooth = points->reference + sizeByte;
+    points->numPoints = numPoints;
+    points->tailMemory = NULL;
+    points->references = NULL;
+    points->compacted = 0;
+    points->mirror = -1;
+    return points;
+}
+
+// Extended precision needs the lower parts of z. They are allocated
+// the first time the points are used with extended precision.
+static int allocTails(MandelPoint* points)
+{
+    if (points->tailMemory)
+        return 0;
+
+    size_t sizeDouble = laneSize(points->numPoints, sizeof(double));
+    points->tailMemory = malloc(6 * sizeDouble + 63);
+    if (!points->tailMemory)
+        return 1;
+
+    uint8_t* lane = (uint8_t*)(((uintptr_t)points->tailMemory + 63) & ~(uintptr_t)63);
+    for (int i = 0; i < 3; ++i) {
+        points->z_re_tail[i] = (double*)lane;
+        points->z_im_tail[i] = (double*)(lane += sizeDouble);
+        lane += sizeDouble;
+    }
+    return 0;
 }
 
-MandelPoint* indexMandelPoint(MandelPoint* points, int num)
+// Number of tail lanes z needs in a precision
+static int tailCount(int precision)
 {
-    return points + num;
+    return precision == MANDEL_QUAD_DOUBLE ? 3 : precision == MANDEL_DOUBLE_DOUBLE ? 1 : 0;
 }
 
-void iterateMandelbrot(MandelPoint* points, int numPoints, int iterations)
+void freeMandelPoint(MandelPoint* points)
 {
-    while(numPoints--) {
-        int i = iterations;
-        MandelPoint p = points[numPoints];
-        if (p.diverged)
+    if (points) {
+        free(points->memory);
+        free(points->tailMemory);
+        if (!points->compacted)
+            freeReferences(points->references);
+    }
+    free(points);
+}
+
+// Diverged points are iterated on until z is this far out, so the smooth
+// count hardly depends on how far beyond the escape radius z landed
+#define SMOOTH_RADIUS2 65536.0
+#define SMOOTH_ITERATIONS 16
+
+// Sets the smooth count of point p from the z at which it diverged. The
+// kernels keep that z, for perturbation it is relative to the reference.
+static void smoothPoint(MandelPoint* points, int p)
+{
+    double zr = points->z_re[p];
+    double zi = points->z_im[p];
+    double cr = points->c_re[p];
+    double ci = points->c_im[p];
+    if (points->precision >= MANDEL_DOUBLE_DOUBLE) {
+        cr += points->center_re.x[0];
+        ci += points->center_im.x[0];
+    }
+    if (points->precision == MANDEL_PERTURBATION && points->reference[p] != REFERENCE_FAILED) {
+        const struct ReferenceOrbit* orbit = points->references->orbit[points->reference[p] & ~REFERENCE_GLITCHED];
+        zr += orbit->z_re[points->diverged[p]];
+        zi += orbit->z_im[points->diverged[p]];
+    }
+
+    // double is precise enough, the orbit doesn't come back
+    double abs2 = zr * zr + zi * zi;
+    int k = 0;
+    for (; abs2 <= SMOOTH_RADIUS2 && k < SMOOTH_ITERATIONS; ++k) {
+        double re = zr * zr - zi * zi + cr;
+        zi = 2.0 * zr * zi + ci;
+        zr = re;
+        abs2 = zr * zr + zi * zi;
+    }
+
+    // continuous where the point diverges one iteration later: log2(log2 |z|) grows by one then
+    double fraction = k - (abs2 > 4.0 ? log2(0.5 * log2(abs2)) : 0.0);
+    double smooth = fraction * MANDEL_SMOOTH_STEPS + MANDEL_SMOOTH_OFFSET + 0.5;
+    points->smooth[p] = smooth < 0.0 ? 0 : smooth > MANDEL_SMOOTH_PENDING - 1 ? MANDEL_SMOOTH_PENDING - 1 : (uint8_t)smooth;
+}
+
+// Iterates a point no reference could fix for the given number of iterations.
+// It goes on relative to the primary reference, but restarts at the beginning
+// of its orbit whenever z comes closer to zero than the difference to the orbit
+// (rebasing). Then the difference can't lose precision, so the orbit in BigFix
+// is all the precision the point needs. The z lanes hold the difference and the
+// zs_re lane the iteration of the orbit. Once the point diverged z is not
+// relative to a reference anymore.
+static void iterateFailedPoint(MandelPoint* points, int p, int iterations)
+{
+    const struct MandelReferences* refs = points->references;
+    const struct ReferenceOrbit* orbit = refs->orbit[0];
+    const double* Zr = orbit->z_re;
+    const double* Zi = orbit->z_im;
+    double dcr = points->c_re[p] - refs->offset_re[0];
+    double dci = points->c_im[p] - refs->offset_im[0];
+    double dzr = points->z_re[p];
+    double dzi = points->z_im[p];
+    uint32_t n = points->iterations[p];
+    int m = (int)points->zs_re[p];
+
+    for (; iterations > 0; --iterations) {
+        if (n >= points->maxIterations) {
+            points->diverged[p] = MANDEL_INTERIOR;
+            break;
+        }
+        // the reference escaped before the point, z itself goes on from the start
+        if (m >= orbit->length) {
+            dzr += Zr[m];
+            dzi += Zi[m];
+            m = 0;
+        }
+        double tr = 2.0 * Zr[m] + dzr;
+        double ti = 2.0 * Zi[m] + dzi;
+        double nr = tr * dzr - ti * dzi + dcr;
+        dzi = tr * dzi + ti * dzr + dci;
+        dzr = nr;
+        ++m;
+        ++n;
+
+        double zr = Zr[m] + dzr;
+        double zi = Zi[m] + dzi;
+        double abs2 = zr * zr + zi * zi;
+        if (abs2 > 4.0) {
+            points->diverged[p] = n;
+            dzr = zr;
+            dzi = zi;
+            break;
+        }
+        if (abs2 < dzr * dzr + dzi * dzi) {
+            dzr = zr;
+            dzi = zi;
+            m = 0;
+        }
+    }
+    points->z_re[p] = dzr;
+    points->z_im[p] = dzi;
+    points->zs_re[p] = m;
+    points->iterations[p] = n;
+}
+
+int iterateMandelbrot(MandelPoint* points, int first, int numPoints, int iterations)
+{
+    int glitched = 0;
+    switch (points->precision) {
+    case MANDEL_FLOAT:
+        kernels->iterateFloat(points, first, numPoints, iterations);
+        break;
+    case MANDEL_DOUBLE:
+        kernels->iterateDouble(points, first, numPoints, iterations);
+        break;
+    case MANDEL_DOUBLE_DOUBLE:
+        kernels->iterateDoubleDouble(points, first, numPoints, iterations);
+        break;
+    case MANDEL_QUAD_DOUBLE:
+        kernels->iterateQuadDouble(points, first, numPoints, iterations);
+        break;
+    case MANDEL_PERTURBATION:
+        glitched = kernels->iteratePerturbation(points, first, numPoints, iterations);
+        break;
+    }
+
+    for (int p = first; p < first + numPoints; ++p) {
+        if (points->precision == MANDEL_PERTURBATION && points->reference[p] == REFERENCE_FAILED && !points->diverged[p])
+            iterateFailedPoint(points, p, iterations);
+        uint32_t diverged = points->diverged[p];
+        if (diverged && diverged != MANDEL_INTERIOR && points->smooth[p] == MANDEL_SMOOTH_PENDING)
+            smoothPoint(points, p);
+    }
+    return glitched;
+}
+
+int correctGlitches(MandelPoint* points, int first, int numPoints, ReferenceCancel cancel, const void* data)
+{
+    struct MandelReferences* refs = points->references;
+    if (!refs)
+        return 0;
+
+    // Points which glitched with an older reference try the newest one first.
+    // The others get a new reference at the point which came closest to zero,
+    // it is the most likely one to lie in the region which glitched.
+    int newest = refs->count - 1;
+    int best = -1;
+    double bestAbs = 0.0;
+    int corrected = 0;
+    for (int p = first; p < first + numPoints; ++p) {
+        uint8_t r = points->reference[p];
+        if (!(r & REFERENCE_GLITCHED) || r == REFERENCE_FAILED)
+            continue;
+        r &= ~REFERENCE_GLITCHED;
+        if (r < newest) {
+            points->reference[p] = newest;
+            points->z_re[p] = 0.0;
+            points->z_im[p] = 0.0;
+            points->iterations[p] = 0;
+            ++corrected;
             continue;
+        }
+        const struct ReferenceOrbit* orbit = refs->orbit[r];
+        uint32_t n = points->iterations[p];
+        double zr = orbit->z_re[n] + points->z_re[p];
+        double zi = orbit->z_im[n] + points->z_im[p];
+        double abs2 = zr * zr + zi * zi;
+        if (best < 0 || abs2 < bestAbs) {
+            best = p;
+            bestAbs = abs2;
+        }
+    }
+    if (best < 0)
+        return corrected;
 
-        double z2_re = p.z.re * p.z.re;
-        double z2_im = p.z.im * p.z.im;
-
-        while (i--) {
-            p.z.im = 2.0 * p.z.re * p.z.im + p.c.im;
-            p.z.re = z2_re - z2_im + p.c.re;
-            z2_re = p.z.re * p.z.re;
-            z2_im = p.z.im * p.z.im;
-            if ((z2_re + z2_im > 4.0 )) {
-                p.diverged = p.iterations;
-                break;
-            }
-            else
-                ++(p.iterations);
+    int index = addReference(refs, points->c_re[best], points->c_im[best], cancel, data);
+    uint8_t glitchedNewest = (uint8_t)newest | REFERENCE_GLITCHED;
+    for (int p = first; p < first + numPoints; ++p) {
+        if (points->reference[p] != glitchedNewest)
+            continue;
+        if (index < 0) {
+            // restarts after the series, relative to the primary reference
+            points->reference[p] = REFERENCE_FAILED;
+            evaluateSeries(refs, points->c_re[p], points->c_im[p], &points->z_re[p], &points->z_im[p]);
+            points->iterations[p] = refs->seriesSkip;
+            points->zs_re[p] = refs->seriesSkip;
+            continue;
         }
-        points[numPoints] = p;
+        points->reference[p] = index;
+        points->z_re[p] = 0.0;
+        points->z_im[p] = 0.0;
+        points->iterations[p] = 0;
+        ++corrected;
     }
+    return corrected;
+}
+
+// A pixel must span at least this many ulps of a precision before it is used
+#define ULPS_PER_PIXEL 256.0
+
+// Machine epsilon of double-double (2^-104)
+#define DD_EPSILON 4.93038065763132e-32
+
+static inline double maxAbs(double a, double b)
+{
+    a = a < 0.0 ? -a : a;
+    b = b < 0.0 ? -b : b;
+    return a > b ? a : b;
+}
+
+enum MandelPrecision selectPrecision(const struct ScreenXY* screen)
+{
+    double spacing = pixelSpacing(screen);
+    double x = bigfixToDouble(&screen->xCenter);
+    double y = bigfixToDouble(&screen->yCenter);
+
+    double magnitude = maxAbs(maxAbs(x - 0.5 * screen->xSpan, x + 0.5 * screen->xSpan),
+                              maxAbs(y - 0.5 * screen->ySpan, y + 0.5 * screen->ySpan));
+    magnitude = maxAbs(magnitude, 2.0);     // z can grow up to the escape radius
+    if (spacing > magnitude * FLT_EPSILON * ULPS_PER_PIXEL)
+        return MANDEL_FLOAT;
+    if (spacing > magnitude * DBL_EPSILON * ULPS_PER_PIXEL)
+        return MANDEL_DOUBLE;
+    if (spacing > magnitude * DD_EPSILON * ULPS_PER_PIXEL)
+        return MANDEL_DOUBLE_DOUBLE;
+    return MANDEL_PERTURBATION;
+}
+
+// Rows on the bottom side of the axis are read from the top side
+static inline int mirrorRow(const MandelPoint* points, int y)
+{
+    return 2 * y > points->mirror && y <= points->mirror ? points->mirror - y : y;
 }
 
+// Position of a result on the palette, 0 for none
+static inline uint32_t palettePosition(uint32_t value, uint8_t smooth)
+{
+    if (value == MANDEL_INTERIOR)
+        return COLOR_INTERIOR;
+    return value ? value * MANDEL_SMOOTH_STEPS + smooth - MANDEL_SMOOTH_OFFSET : 0;
+}
+
+// Result of the finest progressive pass which calculated the block of
+// point x in row y, the preview of point i without one
+static inline uint32_t coarsePosition(const MandelPoint* points, int x, int y, ptrdiff_t i)
+{
+    int width = points->screen.width;
+    for (int stride = 2; stride <= MANDEL_COARSE_STRIDE; stride *= 2) {
+        ptrdiff_t p = (ptrdiff_t)(y & -stride) * width + (x & -stride);
+        if (points->diverged[p])
+            return palettePosition(points->diverged[p], points->smooth[p]);
+    }
+    return palettePosition(points->preview[i], MANDEL_SMOOTH_OFFSET);
+}
+
+// Pixels are colored in runs of this many, once their positions are known
+#define DRAW_RUN 256
+
 void drawMandelbrot(const MandelPoint* points,
                     uint32_t*    pixels,
-                    int          numPoints,
-                    const uint32_t*    colors,
-                    int          numColors)
+                    int          pitch,
+                    const struct MandelTile* tile,
+                    const struct ColorPalette* palette)
+{
+    uint32_t positions[DRAW_RUN];
+    int width = points->screen.width;
+    int end = tile->x + tile->width;
+    for (int y = tile->y; y < tile->y + tile->height; ++y) {
+        int source = mirrorRow(points, y);
+        const uint32_t* diverged = points->diverged + (ptrdiff_t)source * width;
+        const uint8_t* smooth = points->smooth + (ptrdiff_t)source * width;
+        uint32_t* row = pixels + (ptrdiff_t)(y - tile->y) * pitch - tile->x;
+        for (int x = tile->x; x < end; x += DRAW_RUN) {
+            int run = end - x < DRAW_RUN ? end - x : DRAW_RUN;
+            ptrdiff_t i = (ptrdiff_t)y * width + x;
+
+            // without branches for the points with a result, the others are rare once a view is done
+            int missing = 0;
+            for (int k = 0; k < run; ++k) {
+                uint32_t value = diverged[x + k];
+                uint32_t position = value * MANDEL_SMOOTH_STEPS + smooth[x + k] - MANDEL_SMOOTH_OFFSET;
+                positions[k] = value == MANDEL_INTERIOR ? COLOR_INTERIOR : position;
+                missing |= !value;
+            }
+            for (int k = 0; missing && k < run; ++k) {
+                if (!diverged[x + k])
+                    positions[k] = coarsePosition(points, x + k, source, i + k);
+            }
+            colorShade(palette, positions, row + x, run);
+        }
+    }
+}
+
+
+// Main cardioid and period 2 bulb, the largest parts of the set
+static inline int inCardioidOrBulb(double x, double y)
+{
+    double y2 = y * y;
+    double q = (x - 0.25) * (x - 0.25) + y2;
+    if (q * (q + (x - 0.25)) <= 0.25 * y2)
+        return 1;
+    return (x + 1.0) * (x + 1.0) + y2 <= 0.0625;
+}
+
+// Periodic points are found once z returns closer than this fraction
+// of a pixel, but not closer than the rounding noise of the precision
+#define CYCLE_PIXEL_FRACTION 1e-3
+#define CYCLE_ULPS 16.0
+
+static double cycleEpsilon(const struct ScreenXY* screen, enum MandelPrecision precision)
+{
+    double eps = pixelSpacing(screen) * CYCLE_PIXEL_FRACTION;
+    double noise = CYCLE_ULPS * (precision == MANDEL_FLOAT ? FLT_EPSILON : DBL_EPSILON);
+    eps = eps > noise ? eps : noise;
+    return eps * eps;
+}
+
+// The automatic budget starts with the base for the whole set and
+// grows by a fixed amount whenever the screen got half as wide
+#define AUTO_ITERATIONS_BASE 1000
+#define AUTO_ITERATIONS_PER_ZOOM 250
+#define FULL_SPAN 4.0
+
+uint32_t selectMaxIterations(const struct ScreenXY* screen, uint32_t maxIterations)
+{
+    if (maxIterations != MANDEL_ITERATIONS_AUTO)
+        return maxIterations;
+
+    uint32_t budget = AUTO_ITERATIONS_BASE;
+    for (double span = screen->xSpan; span < FULL_SPAN && span > 0.0; span *= 2.0) {
+        if (budget > UINT32_MAX - 1 - AUTO_ITERATIONS_PER_ZOOM)
+            break;
+        budget += AUTO_ITERATIONS_PER_ZOOM;
+    }
+    return budget;
+}
+
+// Row h shows imaginary part (h - height / 2) * mapY + yCenter, so row
+// mirror - h shows its negative if 2 * yCenter is a whole number of rows
+static int mirrorAxis(const struct ScreenXY* screen)
+{
+    double mapY = screen->ySpan / (double)screen->height;
+    double rows = 2.0 * bigfixToDouble(&screen->yCenter) / mapY;
+    if (rows <= -screen->height || rows >= screen->height)
+        return -1;
+    int rounded = (int)(rows < 0.0 ? rows - 0.5 : rows + 0.5);
+    double error = rows - rounded;
+    if (error < -1e-3 || error > 1e-3)
+        return -1;
+    return screen->height - rounded;
+}
+
+int mirroredMandelRows(const MandelPoint* points, struct MandelTile* rows)
+{
+    if (points->mirror < 0)
+        return 0;
+    int last = points->mirror < points->screen.height - 1 ? points->mirror : points->screen.height - 1;
+    rows->x = 0;
+    rows->width = points->screen.width;
+    rows->y = points->mirror / 2 + 1;
+    rows->height = last - rows->y + 1;
+    return rows->height > 0;
+}
+
+int mirroredMandelTile(const MandelPoint* points, const struct MandelTile* tile, struct MandelTile* image)
+{
+    struct MandelTile rows;
+    if (!mirroredMandelRows(points, &rows))
+        return 0;
+    int first = points->mirror - (tile->y + tile->height - 1);
+    int last = points->mirror - tile->y;
+    if (first < rows.y)
+        first = rows.y;
+    if (last > rows.y + rows.height - 1)
+        last = rows.y + rows.height - 1;
+    image->x = tile->x;
+    image->width = tile->width;
+    image->y = first;
+    image->height = last - first + 1;
+    return image->height > 0;
+}
+
+int mirroredMandelSource(const MandelPoint* points, const struct MandelTile* tile, struct MandelTile* source)
+{
+    struct MandelTile rows;
+    if (!mirroredMandelRows(points, &rows))
+        return 0;
+    int first = tile->y > rows.y ? tile->y : rows.y;
+    int last = tile->y + tile->height < rows.y + rows.height ? tile->y + tile->height - 1 : rows.y + rows.height - 1;
+    source->x = tile->x;
+    source->width = tile->width;
+    source->y = points->mirror - last;
+    source->height = last - first + 1;
+    return source->height > 0;
+}
+
+void prepareMandelbrot(MandelPoint* points, const struct ScreenXY* screen, enum MandelPrecision precision,
+                       uint32_t maxIterations)
+{
+    points->screen = *screen;
+    points->precision = precision;
+    points->maxIterations = maxIterations;
+    points->mirror = mirrorAxis(screen);
+
+    // nothing of the old view is drawn, unless it is reprojected
+    memset(points->diverged, 0, screen->height * screen->width * sizeof(uint32_t));
+    memset(points->preview, 0, screen->height * screen->width * sizeof(uint32_t));
+}
+
+// Offset of two centers in pixels plus extra, if it is a whole number of them
+// less than pixels
+static int pixelOffset(const BigFix* to, const BigFix* from, double map, double extra, int pixels, int* offset)
+{
+    BigFix diff;
+    bigfixSub(&diff, to, from, BIGFIX_LIMBS);
+    double steps = bigfixToDouble(&diff) / map + extra;
+    if (steps <= -pixels || steps >= pixels)
+        return 0;
+    int rounded = (int)(steps < 0.0 ? steps - 0.5 : steps + 0.5);
+    double error = steps - rounded;
+    if (error < -1e-3 || error > 1e-3)
+        return 0;
+    *offset = rounded;
+    return 1;
+}
+
+// Offset of a view to another one of the same size, if it moved by whole pixels
+static int shiftOffset(const struct ScreenXY* now, const struct ScreenXY* old, int* dx, int* dy)
+{
+    return pixelOffset(&now->xCenter, &old->xCenter, now->xSpan / now->width, 0.0, now->width, dx)
+        && pixelOffset(&now->yCenter, &old->yCenter, now->ySpan / now->height, 0.0, now->height, dy);
+}
+
+// Part of the screen which is still on it after a move by an offset.
+// Point (x, y) is point (x + dx, y + dy) of the old view.
+static void reusedRect(const struct ScreenXY* now, int dx, int dy, struct MandelTile* reused)
+{
+    reused->x = dx < 0 ? -dx : 0;
+    reused->y = dy < 0 ? -dy : 0;
+    reused->width = now->width - (dx < 0 ? -dx : dx);
+    reused->height = now->height - (dy < 0 ? -dy : dy);
+}
+
+int shiftedMandelRect(const MandelPoint* points, const MandelPoint* from, struct MandelTile* reused)
+{
+    const struct ScreenXY* now = &points->screen;
+    const struct ScreenXY* old = &from->screen;
+    int dx, dy;
+    if (now->width != old->width || now->height != old->height
+        || now->xSpan != old->xSpan || now->ySpan != old->ySpan
+        || points->maxIterations != from->maxIterations || points->precision != from->precision
+        || !shiftOffset(now, old, &dx, &dy))
+        return 0;
+    reusedRect(now, dx, dy, reused);
+    return 1;
+}
+
+void shiftMandelTile(MandelPoint* points, const MandelPoint* from, const struct MandelTile* tile)
+{
+    int dx, dy;
+    if (!shiftOffset(&points->screen, &from->screen, &dx, &dy))
+        return;
+    struct MandelTile reused;
+    reusedRect(&points->screen, dx, dy, &reused);
+
+    int left = tile->x > reused.x ? tile->x : reused.x;
+    int right = tile->x + tile->width < reused.x + reused.width ? tile->x + tile->width : reused.x + reused.width;
+    int top = tile->y > reused.y ? tile->y : reused.y;
+    int bottom = tile->y + tile->height < reused.y + reused.height ? tile->y + tile->height : reused.y + reused.height;
+    int width = points->screen.width;
+    for (int y = top; y < bottom; ++y) {
+        ptrdiff_t i = (ptrdiff_t)y * width;
+        ptrdiff_t o = (ptrdiff_t)mirrorRow(from, y + dy) * width + dx;
+        for (int x = left; x < right; ++x) {
+            points->preview[i + x] = from->preview[o + x];
+            if (!points->diverged[i + x]) {
+                points->diverged[i + x] = from->diverged[o + x];
+                points->smooth[i + x] = from->smooth[o + x];
+            }
+        }
+    }
+}
+
+// Tells if two pixel sizes are the same up to rounding
+static inline int sameMap(double a, double b)
+{
+    double diff = a > b ? a - b : b - a;
+    return diff <= 1e-9 * a;
+}
+
+int mergeMandelTile(MandelPoint* points, const MandelPoint* from, const struct MandelTile* tile)
 {
-    ptrdiff_t i = numPoints;
-    while(i--) {
-        pixels[i] = colors[points[i].diverged % numColors];
+    const struct ScreenXY* now = &points->screen;
+    const struct ScreenXY* old = &from->screen;
+    double mapX = now->xSpan / now->width;
+    double mapY = now->ySpan / now->height;
+    if (!sameMap(mapX, old->xSpan / old->width) || !sameMap(mapY, old->ySpan / old->height)
+        || points->maxIterations != from->maxIterations || points->precision != from->precision)
+        return 0;
+
+    // point (x, y) is point (x + dx, y + dy) of from, the centers of the views
+    // differ by half of the difference in size
+    int dx, dy;
+    int range = now->width + old->width;
+    if (!pixelOffset(&now->xCenter, &old->xCenter, mapX, 0.5 * (old->width - now->width), range, &dx))
+        return 0;
+    range = now->height + old->height;
+    if (!pixelOffset(&now->yCenter, &old->yCenter, mapY, 0.5 * (old->height - now->height), range, &dy))
+        return 0;
+
+    int left = dx < 0 ? -dx : 0;
+    int right = old->width - dx < now->width ? old->width - dx : now->width;
+    int top = dy < 0 ? -dy : 0;
+    int bottom = old->height - dy < now->height ? old->height - dy : now->height;
+    if (left < tile->x)
+        left = tile->x;
+    if (right > tile->x + tile->width)
+        right = tile->x + tile->width;
+    if (top < tile->y)
+        top = tile->y;
+    if (bottom > tile->y + tile->height)
+        bottom = tile->y + tile->height;
+    int merged = 0;
+    for (int y = top; y < bottom; ++y) {
+        ptrdiff_t i = (ptrdiff_t)y * now->width;
+        ptrdiff_t o = (ptrdiff_t)mirrorRow(from, y + dy) * old->width + dx;
+        for (int x = left; x < right; ++x) {
+            if (!points->diverged[i + x] && from->diverged[o + x]) {
+                points->diverged[i + x] = from->diverged[o + x];
+                points->smooth[i + x] = from->smooth[o + x];
+                ++merged;
+            }
+        }
     }
+    return merged;
 }
 
+// Pixel size rounded to 32 bits of mantissa, so sizes which differ only by
+// rounding of the zoom get the same level
+static uint64_t mapLevel(double map)
+{
+    uint64_t bits;
+    memcpy(&bits, &map, sizeof(bits));
+    return (bits + (1u << 19)) >> 20;
+}
 
-void initMandelbrot(MandelPoint* points, const struct ScreenXY* screen)
+// Position of the center on the grid, if it lies on it
+static int gridCenter(const BigFix* center, double map, struct GridPosition* position)
 {
-    double mapX = (screen->xMax - screen->xMin) / (double)screen->width;
-    double mapY = (screen->yMax - screen->yMin) / (double)screen->height;
-    ptrdiff_t i = screen->height * screen->width;
-    int h = screen->height;
-    while (h--) {
-        int w = screen->width;
-        while (w--) {
-            points[--i].c.re = (double)w * mapX + screen->xMin;
-            points[i].c.im = (double)h * mapY + screen->yMin;
-            points[i].z.im = 0.0;
-            points[i].z.re = 0.0,
-            points[i].diverged = 0;
-            points[i].iterations = 0;
+    BigFix snapped = *center;
+    return snapToGrid(&snapped, map, position);
+}
+
+int getMandelGrid(const MandelPoint* points, struct MandelGrid* grid)
+{
+    const struct ScreenXY* screen = &points->screen;
+    double mapX = screen->xSpan / screen->width;
+    double mapY = screen->ySpan / screen->height;
+    struct GridPosition x, y;
+    if (!gridCenter(&screen->xCenter, mapX, &x) || !gridCenter(&screen->yCenter, mapY, &y))
+        return 0;
+
+    grid->levelX = mapLevel(mapX);
+    grid->levelY = mapLevel(mapY);
+    grid->precision = points->precision;
+    grid->maxIterations = points->maxIterations;
+    grid->regionX = x.region;
+    grid->regionY = y.region;
+    grid->x = x.offset - screen->width / 2;
+    grid->y = y.offset - screen->height / 2;
+    grid->width = screen->width;
+    grid->height = screen->height;
+    return 1;
+}
+
+int readMandelBlock(const MandelPoint* points, const struct MandelTile* block, uint32_t* values, uint8_t* smooth,
+                    int pitch)
+{
+    for (int y = 0; y < block->height; ++y) {
+        ptrdiff_t row = (ptrdiff_t)mirrorRow(points, block->y + y) * points->screen.width + block->x;
+        for (int x = 0; x < block->width; ++x) {
+            uint32_t value = points->diverged[row + x];
+            if (!value)
+                return 0;
+            if (values) {
+                values[y * pitch + x] = value;
+                smooth[y * pitch + x] = points->smooth[row + x];
+            }
         }
     }
+    return 1;
+}
+
+int writeMandelBlock(MandelPoint* points, const struct MandelTile* block, const uint32_t* values,
+                     const uint8_t* smooth, int pitch)
+{
+    int written = 0;
+    for (int y = 0; y < block->height; ++y) {
+        ptrdiff_t row = (ptrdiff_t)(block->y + y) * points->screen.width + block->x;
+        for (int x = 0; x < block->width; ++x) {
+            if (!points->diverged[row + x]) {
+                points->diverged[row + x] = values[y * pitch + x];
+                points->smooth[row + x] = smooth[y * pitch + x];
+                ++written;
+            }
+        }
+    }
+    return written;
+}
+
+// Maps the pixels of one axis to the old view: old = new * scale + offset
+static void mapAxis(const BigFix* now, const BigFix* old, double span, double oldSpan, int pixels,
+                    double* scale, double* offset)
+{
+    BigFix diff;
+    bigfixSub(&diff, now, old, BIGFIX_LIMBS);
+    double oldMap = oldSpan / pixels;
+    *scale = span / oldSpan;
+    *offset = 0.5 * pixels * (1.0 - *scale) + bigfixToDouble(&diff) / oldMap;
+}
+
+// Nearest old pixel, -1 if it is outside. exact tells if the pixel lies on it.
+static int nearestPixel(double position, int pixels, int* exact)
+{
+    if (position < -0.5 || position >= pixels - 0.5)
+        return -1;
+    int nearest = (int)(position + 0.5);
+    double error = position - nearest;
+    *exact = error > -1e-3 && error < 1e-3;
+    return nearest;
+}
+
+void reprojectMandelTile(MandelPoint* points, const MandelPoint* from, const struct MandelTile* tile)
+{
+    const struct ScreenXY* now = &points->screen;
+    const struct ScreenXY* old = &from->screen;
+    if (now->width != old->width || now->height != old->height)
+        return;
+
+    double scaleX, offsetX, scaleY, offsetY;
+    mapAxis(&now->xCenter, &old->xCenter, now->xSpan, old->xSpan, now->width, &scaleX, &offsetX);
+    mapAxis(&now->yCenter, &old->yCenter, now->ySpan, old->ySpan, now->height, &scaleY, &offsetY);
+
+    // Points inside the set may diverge with a larger budget, only
+    // those which diverged within it are sure to be the same.
+    int keep = points->precision == from->precision;
+    int keepInterior = keep && points->maxIterations <= from->maxIterations;
+    for (int y = tile->y; y < tile->y + tile->height; ++y) {
+        int exactY;
+        int oy = nearestPixel(y * scaleY + offsetY, now->height, &exactY);
+        if (oy < 0)
+            continue;
+        oy = mirrorRow(from, oy);
+        ptrdiff_t i = (ptrdiff_t)y * now->width + tile->x;
+        for (int x = tile->x; x < tile->x + tile->width; ++x, ++i) {
+            int exactX;
+            int ox = nearestPixel(x * scaleX + offsetX, now->width, &exactX);
+            if (ox < 0)
+                continue;
+            ptrdiff_t o = (ptrdiff_t)oy * now->width + ox;
+            uint32_t d = from->diverged[o];
+            points->preview[i] = d ? d : from->preview[o];
+            if (d && !points->diverged[i] && exactX && exactY
+                && (d == MANDEL_INTERIOR ? keepInterior : keep && d <= points->maxIterations)) {
+                points->diverged[i] = d;
+                points->smooth[i] = from->smooth[o];
+            }
+        }
+    }
+}
+
+int setupMandelbrot(MandelPoint* points, ReferenceCancel cancel, const void* data)
+{
+    const struct ScreenXY* screen = &points->screen;
+    int precision = points->precision;
+    freeReferences(points->references);
+    points->references = NULL;
+    if (precision == MANDEL_PERTURBATION) {
+        points->references = createReferences(screen, points->maxIterations, cancel, data);
+        if (!points->references && cancel && cancel(data))
+            return 0;
+        if (!points->references)
+            precision = MANDEL_QUAD_DOUBLE;
+    }
+    if ((precision == MANDEL_DOUBLE_DOUBLE || precision == MANDEL_QUAD_DOUBLE) && allocTails(points))
+        precision = MANDEL_DOUBLE;
+    // other tiles of the view are reprojected meanwhile, which read the precision
+    if (precision != points->precision)
+        points->precision = precision;
+    points->center_re = bigfixToQD(&screen->xCenter);
+    // the rows of a mirrored view are placed from the axis, see initMandelTile()
+    points->center_im = points->mirror >= 0 && precision != MANDEL_PERTURBATION
+                      ? qd_from_double(0.0) : bigfixToQD(&screen->yCenter);
+    points->cycleEpsilon = cycleEpsilon(screen, precision);
+    return 1;
+}
+
+void initMandelTile(MandelPoint* points, const struct MandelTile* tile)
+{
+    const struct ScreenXY* screen = &points->screen;
+    int precision = points->precision;
+
+    // Extended precision and perturbation kernels add the center themselves,
+    // the offset to center is precise enough in double.
+    double origin_re = 0.0;
+    double origin_im = 0.0;
+    if (precision < MANDEL_DOUBLE_DOUBLE) {
+        origin_re = bigfixToDouble(&screen->xCenter);
+        origin_im = bigfixToDouble(&screen->yCenter);
+    }
+
+    // Extended precision is only used for views far below the size of the
+    // cardioid and bulb, double couldn't decide the test for them anyway.
+    int cardioidTest = precision < MANDEL_DOUBLE_DOUBLE;
+    const struct MandelReferences* refs = points->references;
+    int numTails = tailCount(precision);
+
+    double mapX = screen->xSpan / (double)screen->width;
+    double mapY = screen->ySpan / (double)screen->height;
+    double halfWidth = 0.5 * screen->width;
+    double halfHeight = 0.5 * screen->height;
+
+    // Rows of a mirrored view are placed from the axis, so it is exactly real
+    // and the rows mirrored at it are exact conjugates. Their imaginary parts
+    // are small then, double is precise enough for them with extended precision too.
+    double axis = halfHeight;
+    if (points->mirror >= 0 && precision != MANDEL_PERTURBATION) {
+        axis = 0.5 * points->mirror;
+        origin_im = 0.0;
+    }
+    for (int h = tile->y; h < tile->y + tile->height; ++h) {
+        ptrdiff_t i = (ptrdiff_t)h * screen->width + tile->x;
+        for (int w = tile->x; w < tile->x + tile->width; ++w, ++i) {
+            if (points->diverged[i])
+                continue;
+            points->c_re[i] = ((double)w - halfWidth) * mapX + origin_re;
+            points->c_im[i] = ((double)h - axis) * mapY + origin_im;
+            points->z_re[i] = 0.0;
+            points->z_im[i] = 0.0;
+            points->diverged[i] = 0;
+            points->smooth[i] = MANDEL_SMOOTH_PENDING;
+            points->iterations[i] = 0;
+            points->reference[i] = 0;
+            for (int t = 0; t < numTails; ++t) {
+                points->z_re_tail[t][i] = 0.0;
+                points->z_im_tail[t][i] = 0.0;
+            }
+
+            if (cardioidTest && inCardioidOrBulb(points->c_re[i], points->c_im[i]))
+                points->diverged[i] = MANDEL_INTERIOR;
+
+            // all points start after the iterations the series skips
+            if (refs) {
+                evaluateSeries(refs, points->c_re[i], points->c_im[i], &points->z_re[i], &points->z_im[i]);
+                points->iterations[i] = refs->seriesSkip;
+            }
+        }
+    }
+}
+
+void initMandelbrot(MandelPoint* points, const struct ScreenXY* screen, enum MandelPrecision precision,
+                    uint32_t maxIterations)
+{
+    struct MandelTile all = {0, 0, screen->width, screen->height};
+    prepareMandelbrot(points, screen, precision, maxIterations);
+    setupMandelbrot(points, NULL, NULL);
+    initMandelTile(points, &all);
+}
+
+// Copies all lanes of point src in from to point dst in to
+static void copyPoint(MandelPoint* to, int dst, const MandelPoint* from, int src, int numTails)
+{
+    to->c_re[dst] = from->c_re[src];
+    to->c_im[dst] = from->c_im[src];
+    to->z_re[dst] = from->z_re[src];
+    to->z_im[dst] = from->z_im[src];
+    to->zs_re[dst] = from->zs_re[src];
+    to->zs_im[dst] = from->zs_im[src];
+    to->iterations[dst] = from->iterations[src];
+    to->diverged[dst] = from->diverged[src];
+    to->smooth[dst] = from->smooth[src];
+    to->reference[dst] = from->reference[src];
+    for (int t = 0; t < numTails; ++t) {
+        to->z_re_tail[t][dst] = from->z_re_tail[t][src];
+        to->z_im_tail[t][dst] = from->z_im_tail[t][src];
+    }
+}
+
+// Points are live until they diverged or are interior. Points no reference
+// could fix stay live until iterateMandelbrot() finished them. Points which
+// used up the budget are marked as interior on the way, also if they
+// diverged after it in the iterations since the last check.
+static inline int isLive(MandelPoint* points, int p)
+{
+    uint32_t diverged = points->diverged[p];
+    if (diverged) {
+        if (diverged != MANDEL_INTERIOR && diverged > points->maxIterations)
+            points->diverged[p] = MANDEL_INTERIOR;
+        return 0;
+    }
+    if (points->iterations[p] >= points->maxIterations) {
+        points->diverged[p] = MANDEL_INTERIOR;
+        return 0;
+    }
+    return 1;
+}
+
+// Gives the copy the parameters of the points. Returns the number of tail lanes, -1 if they can't be allocated.
+static int startCopy(MandelPoint* live, const MandelPoint* points)
+{
+    int numTails = tailCount(points->precision);
+    if (numTails && allocTails(live))
+        return -1;
+
+    live->precision = points->precision;
+    live->center_re = points->center_re;
+    live->center_im = points->center_im;
+    live->cycleEpsilon = points->cycleEpsilon;
+    live->maxIterations = points->maxIterations;
+    live->references = points->references;
+    live->compacted = 1;
+    return numTails;
+}
+
+// Copies point p if it is live. Returns the new number of copied points.
+static inline int gatherPoint(MandelPoint* live, uint32_t* index, int count, MandelPoint* points, int p, int numTails)
+{
+    if (isLive(points, p)) {
+        copyPoint(live, count, points, p, numTails);
+        index[count++] = p;
+    }
+    return count;
+}
+
+// First multiple of stride from start on
+static inline int alignUp(int start, int stride)
+{
+    return (start + stride - 1) / stride * stride;
+}
+
+int gatherMandelPoints(MandelPoint* live, uint32_t* index, MandelPoint* points, const struct MandelTile* tile, int stride)
+{
+    int numTails = startCopy(live, points);
+    if (numTails < 0)
+        return -1;
+
+    int count = 0;
+    int left = alignUp(tile->x, stride);
+    for (int y = alignUp(tile->y, stride); y < tile->y + tile->height; y += stride) {
+        int row = y * points->screen.width;
+        for (int x = left; x < tile->x + tile->width; x += stride)
+            count = gatherPoint(live, index, count, points, row + x, numTails);
+    }
+    return count;
+}
+
+int gatherMandelBorder(MandelPoint* live, uint32_t* index, MandelPoint* points, const struct MandelTile* tile)
+{
+    int numTails = startCopy(live, points);
+    if (numTails < 0)
+        return -1;
+
+    // between the top and bottom row only the first and last column
+    int count = 0;
+    int last = tile->y + tile->height - 1;
+    int inner = tile->width > 1 ? tile->width - 1 : 1;
+    for (int y = tile->y; y <= last; ++y) {
+        int first = y * points->screen.width + tile->x;
+        int step = y == tile->y || y == last ? 1 : inner;
+        for (int p = first; p < first + tile->width; p += step)
+            count = gatherPoint(live, index, count, points, p, numTails);
+    }
+    return count;
+}
+
+int uniformMandelBorder(const MandelPoint* points, const struct MandelTile* tile, uint32_t* value)
+{
+    int last = tile->y + tile->height - 1;
+    int inner = tile->width > 1 ? tile->width - 1 : 1;
+    uint32_t first = points->diverged[tile->y * points->screen.width + tile->x];
+    if (!first)
+        return 0;
+
+    // the smooth count must be the same as well, else the filled points would
+    // be one flat color against the gradient of the border
+    int smooth = first == MANDEL_INTERIOR ? -1 : points->smooth[tile->y * points->screen.width + tile->x];
+    for (int y = tile->y; y <= last; ++y) {
+        int row = y * points->screen.width + tile->x;
+        int step = y == tile->y || y == last ? 1 : inner;
+        for (int p = row; p < row + tile->width; p += step) {
+            if (points->diverged[p] != first || (smooth >= 0 && points->smooth[p] != smooth))
+                return 0;
+        }
+    }
+    *value = first;
+    return 1;
+}
+
+void fillMandelTile(MandelPoint* points, const struct MandelTile* tile, uint32_t value)
+{
+    uint8_t smooth = points->smooth[tile->y * points->screen.width + tile->x];
+    for (int y = tile->y; y < tile->y + tile->height; ++y) {
+        ptrdiff_t row = (ptrdiff_t)y * points->screen.width;
+        for (int x = tile->x; x < tile->x + tile->width; ++x) {
+            if (!points->diverged[row + x]) {
+                points->diverged[row + x] = value;
+                points->smooth[row + x] = smooth;
+            }
+        }
+    }
+}
+
+int scatterMandelPoints(MandelPoint* points, MandelPoint* live, const uint32_t* index, int count)
+{
+    int numTails = tailCount(live->precision);
+    int remaining = 0;
+    for (int k = 0; k < count; ++k) {
+        remaining += isLive(live, k);
+        copyPoint(points, index[k], live, k, numTails);
+    }
+    return remaining;
+}
+
+int compactMandelPoints(MandelPoint* points, MandelPoint* live, uint32_t* index, int count)
+{
+    int numTails = tailCount(live->precision);
+    int kept = 0;
+    for (int k = 0; k < count; ++k) {
+        if (isLive(live, k)) {
+            if (kept != k) {
+                copyPoint(live, kept, live, k, numTails);
+                index[kept] = index[k];
+            }
+            ++kept;
+        }
+        else {
+            points->diverged[index[k]] = live->diverged[k];
+            points->smooth[index[k]] = live->smooth[k];
+            points->reference[index[k]] = live->reference[k];
+        }
+    }
+    return kept;
+}
+
+int countLiveMandelPoints(MandelPoint* points, int first, int numPoints)
+{
+    int remaining = 0;
+    for (int p = first; p < first + numPoints; ++p)
+        remaining += isLive(points, p);
+    return remaining;
 }
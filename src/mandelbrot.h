@@ -15,69 +15,469 @@
 
 #include <stdint.h>
 #include "screen_xy.h"
+#include "color_palette.h"
+#include "perturbation.h"
 
 
-/** @brief   Contains information for a complex point in mandelbrotset.
+/** @brief   Contains information for the complex points in mandelbrotset.
  *
  *  @details Each point corresponds to one pixel of the screen.
+ *           The points are stored as struct of arrays, so they can be
+ *           iterated with simd instructions.
  */
 
 typedef struct MandelPoint MandelPoint;
 
+// The diverged lane holds 0 while a point is iterated, the iteration
+// at which it diverged plus one, or MANDEL_INTERIOR if it is inside the set
+#define MANDEL_INTERIOR UINT32_MAX
+
+// The smooth lane refines the iteration of diverged points for coloring without bands.
+// The smooth iteration count is (diverged * MANDEL_SMOOTH_STEPS + smooth - MANDEL_SMOOTH_OFFSET)
+// in 1 / MANDEL_SMOOTH_STEPS iterations, MANDEL_SMOOTH_PENDING until it is calculated.
+#define MANDEL_SMOOTH_STEPS (1 << COLOR_FRACTION_BITS)
+#define MANDEL_SMOOTH_OFFSET (2 * MANDEL_SMOOTH_STEPS)
+#define MANDEL_SMOOTH_PENDING UINT8_MAX
+
+/** @brief A rectangle of points on the screen.
+ */
+
+struct MandelTile {
+    int x;
+    int y;
+    int width;
+    int height;
+};
+
+/** @brief Where points lie on the grid of all views zoomed to the same depth.
+ */
+
+struct MandelGrid {
+    uint64_t levelX;            // pixel size, rounded so views of the same depth match
+    uint64_t levelY;
+    int precision;              // results of other precisions or budgets may differ
+    uint32_t maxIterations;
+    uint64_t regionX;           // see struct GridPosition
+    uint64_t regionY;
+    int64_t x;                  // column of the left points in the region
+    int64_t y;                  // row of the top points in the region
+    int width;                  // size of the view in points
+    int height;
+};
+
+// Passed as maximum iterations to scale them with the zoom depth
+#define MANDEL_ITERATIONS_AUTO 0
+
+// Distance of the points calculated by the first progressive pass, every
+// further pass halves it until all points are calculated
+#define MANDEL_COARSE_STRIDE 8
+
+/** @brief The floating point type the points are iterated with.
+ *
+ *  MANDEL_FLOAT         - twice the throughput of double, only for shallow zoom levels.
+ *  MANDEL_DOUBLE        - default precision.
+ *  MANDEL_DOUBLE_DOUBLE - about 106 bits, for zoom levels beyond double.
+ *  MANDEL_QUAD_DOUBLE   - about 212 bits, fallback if perturbation is out of memory.
+ *  MANDEL_PERTURBATION  - double relative to reference orbits, for zoom levels beyond double-double.
+ */
+
+enum MandelPrecision {
+    MANDEL_FLOAT,
+    MANDEL_DOUBLE,
+    MANDEL_DOUBLE_DOUBLE,
+    MANDEL_QUAD_DOUBLE,
+    MANDEL_PERTURBATION
+};
+
 /** @brief Allocates memory for number of MandelPoints
+ *
+ *         The first call selects the iteration kernel for the cpu.
  *
  *  @param number Number of elements
- *  @return Pointer to allocated memory. Must be freed manually.
+ *  @return Pointer to allocated memory. Must be freed with freeMandelPoint().
  */
 
 MandelPoint* createMandelPoint(uint32_t numPoints);
 
-/** @brief Increments the pointer by a number of elements.
+/** @brief Frees memory allocated with createMandelPoint()
+ *
+ *  @param points The points to free. May be NULL.
+ *  @return void
+ */
+
+void freeMandelPoint(MandelPoint* points);
+
+
+/** @brief Selects the lowest precision which can resolve the pixels of the screen.
+ *
+ *         Float is only used while the pixel spacing is well above float epsilon.
+ *
+ *  @param screen Contains information about how screen is mapped to xy-coordinates
+ *  @return The precision to pass to initMandelbrot()
+ */
+
+enum MandelPrecision selectPrecision(const struct ScreenXY* screen);
+
+/** @brief Selects how many iterations a point may take before it counts as inside the set.
+ *
+ *         Deeper zoom levels show finer details, which need more iterations
+ *         to diverge. The automatic budget grows with every halving of the
+ *         width of the screen.
+ *
+ *  @param screen        Contains information about how screen is mapped to xy-coordinates
+ *  @param maxIterations Fixed budget, or MANDEL_ITERATIONS_AUTO
+ *  @return The budget to pass to initMandelbrot()
+ */
+
+uint32_t selectMaxIterations(const struct ScreenXY* screen, uint32_t maxIterations);
+
+/** @brief Sets the view of the points without initialising them.
+ *
+ *         Cheap enough to be called for every change of the view. Until the
+ *         tiles are initialised with initMandelTile() the points are drawn
+ *         like points which are still iterated.
+ *
+ *  @param points        The array of points. Must be allocated with to width * height elements
+ *  @param screen        Contains information about how screen is mapped to xy-coordinates
+ *  @param precision     The precision iterateMandelbrot() uses for these points
+ *  @param maxIterations Points which reach this many iterations are inside the set
+ *  @return void
+ */
+
+void prepareMandelbrot(MandelPoint* points, const struct ScreenXY* screen, enum MandelPrecision precision,
+                       uint32_t maxIterations);
+
+/** @brief Tells which rows are the mirror image of others.
+ *
+ *         The set is symmetric about the real axis. If the axis lies on a row
+ *         or between two, the rows on the one side of it are complex conjugates
+ *         of the rows on the other side and need not be calculated. Drawing and
+ *         reusing the points reads them from the mirrored rows instead.
+ *
+ *  @param points The points prepared with prepareMandelbrot()
+ *  @param rows   Receives the rows which are mirrored, the whole width of the screen
+ *  @return 1 if there are rows which are mirrored, else 0
+ */
+
+int mirroredMandelRows(const MandelPoint* points, struct MandelTile* rows);
+
+/** @brief Tells which mirrored rows are drawn like the points of a tile
+ *
+ *  @param points The points prepared with prepareMandelbrot()
+ *  @param tile   Part of the screen
+ *  @param image  Receives the part of the mirrored rows whose points are read from tile
+ *  @return 1 if there is such a part, else 0
+ */
+
+int mirroredMandelTile(const MandelPoint* points, const struct MandelTile* tile, struct MandelTile* image);
+
+/** @brief Tells which rows are drawn for the mirrored rows of a tile
+ *
+ *  @param points The points prepared with prepareMandelbrot()
+ *  @param tile   Part of the screen
+ *  @param source Receives the part of the rows whose points are drawn for the mirrored rows of tile
+ *  @return 1 if tile has mirrored rows, else 0
+ */
+
+int mirroredMandelSource(const MandelPoint* points, const struct MandelTile* tile, struct MandelTile* source);
+
+/** @brief Tells where the points lie on the grid of their depth.
+ *
+ *         Views aligned with alignToPixels() lie on the grid, their points
+ *         have the same position on it as the points of other views there.
+ *
+ *  @param points The points prepared with prepareMandelbrot()
+ *  @param grid   Receives the position of the points
+ *  @return 1 if the view is aligned, else 0
+ */
+
+int getMandelGrid(const MandelPoint* points, struct MandelGrid* grid);
+
+/** @brief Copies the results of a block of points.
+ *
+ *  @param points The points
+ *  @param block  The block on the screen
+ *  @param values Receives the diverged values, may be NULL to only check the block
+ *  @param smooth Receives the smooth values, may be NULL with values
+ *  @param pitch  Distance of the rows in values and smooth
+ *  @return 1 if all points of the block have a result, else 0 and values is incomplete
+ */
+
+int readMandelBlock(const MandelPoint* points, const struct MandelTile* block, uint32_t* values, uint8_t* smooth,
+                    int pitch);
+
+/** @brief Gives the points of a block which have no result the ones of values.
+ *
+ *         Must be called after prepareMandelbrot(), initMandelTile() keeps the
+ *         points with a result.
+ *
+ *  @param points The prepared points
+ *  @param block  The block on the screen
+ *  @param values The diverged values, like from readMandelBlock()
+ *  @param smooth The smooth values
+ *  @param pitch  Distance of the rows in values and smooth
+ *  @return Number of points which got a result
+ */
+
+int writeMandelBlock(MandelPoint* points, const struct MandelTile* block, const uint32_t* values,
+                     const uint8_t* smooth, int pitch);
+
+/** @brief Tells which points keep their results after a move.
+ *
+ *         If the view of the points moved by whole pixels against the view of
+ *         other points, the points which are still on the screen keep their
+ *         results, see shiftMandelTile(). Must be called after prepareMandelbrot().
+ *
+ *  @param points The prepared points
+ *  @param from   The points of the previous view
+ *  @param reused Receives the part of the screen which keeps the results
+ *  @return 1 if the views match, else 0
+ */
+
+int shiftedMandelRect(const MandelPoint* points, const MandelPoint* from, struct MandelTile* reused);
+
+/** @brief Keeps the results of the points of a tile which are still on the screen after a move.
+ *
+ *         The points of the tile which lie in the part shiftedMandelRect() tells
+ *         and have no result yet get the result of the other view, which may
+ *         also be none yet. Only for views shiftedMandelRect() found to match.
+ *         Must be called after prepareMandelbrot(), initMandelTile() keeps the
+ *         points with a result. Tiles don't overlap, so they can be shifted
+ *         concurrently.
+ *
+ *  @param points The prepared points
+ *  @param from   The points of the previous view
+ *  @param tile   The tile on the screen
+ *  @return void
+ */
+
+void shiftMandelTile(MandelPoint* points, const MandelPoint* from, const struct MandelTile* tile);
+
+/** @brief Takes the results of points of another view which lie on the points of a tile.
+ *
+ *         Like shiftMandelTile(), but the views may differ in size and only
+ *         points which have no result get the one of the other view. For views
+ *         calculated in advance. Must be called after prepareMandelbrot(),
+ *         initMandelTile() keeps the points with a result.
+ *
+ *  @param points The prepared points
+ *  @param from   Points of a view with the same pixel size, precision and budget
+ *  @param tile   The part of the screen to take the results for
+ *  @return Number of points which got a result
+ */
+
+int mergeMandelTile(MandelPoint* points, const MandelPoint* from, const struct MandelTile* tile);
+
+/** @brief Shows the points of a tile with the previous view until they have a result.
+ *
+ *         Every point is previewed with the nearest point of the previous view.
+ *         Points without a result which lie exactly on a point of the previous
+ *         view take its result if it can't change with the new precision and budget.
+ *         Must be called after prepareMandelbrot(), initMandelTile() keeps the
+ *         points with a result. Tiles don't overlap, so they can be reprojected
+ *         concurrently.
+ *
+ *  @param points The prepared points
+ *  @param from   The points of the previous view
+ *  @param tile   The tile on the screen
+ *  @return void
+ */
+
+void reprojectMandelTile(MandelPoint* points, const MandelPoint* from, const struct MandelTile* tile);
+
+/** @brief Creates what all tiles of the view share.
  *
- *         This is necesarry because the size of MandelPoint is not visible.
+ *         Calculates the reference orbits for perturbation and allocates the
+ *         memory for extended precision, see initMandelbrot() for what happens
+ *         if that fails. Must be called once after prepareMandelbrot() before
+ *         the first tile is initialised, and not concurrently with correctGlitches().
  *
- *  @param points Pointer to array.
- *  @param num    Array index
- *  @return       Pointer to element with index relative to poins
+ *  @param points The points prepared with prepareMandelbrot()
+ *  @param cancel Stops calculating the reference orbit once the view is not needed anymore, may be NULL
+ *  @param data   Passed to cancel
+ *  @return 1 if the points are set up, 0 if it was cancelled and they must be set up again
  */
 
-MandelPoint* indexMandelPoint(MandelPoint* points, int num);
+int setupMandelbrot(MandelPoint* points, ReferenceCancel cancel, const void* data);
+
+/** @brief Initialises the points of a tile.
+ *
+ *         Tiles don't overlap, so they can be initialised concurrently.
+ *         Points which already have a result from shiftMandelTile() are kept.
+ *
+ *  @param points The points set up with setupMandelbrot()
+ *  @param tile   The tile on the screen
+ *  @return void
+ */
+
+void initMandelTile(MandelPoint* points, const struct MandelTile* tile);
 
 /** @brief Initialises the Mandelbrot Points.
  *         Must be called before use of iterateMandelbrot()
  *
- *  @param points The array of points. Must be allocated with to width * height elements
- *  @param screen Contains information about how screen is mapped to xy-coordinates
+ *         If the memory for extended precision can't be allocated
+ *         the points are initialised for double precision. If the
+ *         reference orbit for perturbation can't be allocated they are
+ *         initialised for quad-double.
+ *
+ *  @param points    The array of points. Must be allocated with to width * height elements
+ *  @param screen    Contains information about how screen is mapped to xy-coordinates
+ *  @param precision The precision iterateMandelbrot() uses for these points
+ *  @param maxIterations Points which reach this many iterations are inside the set
  *  @return void
  */
 
-void initMandelbrot(MandelPoint* points, const struct ScreenXY* screen);
+void initMandelbrot(MandelPoint* points, const struct ScreenXY* screen, enum MandelPrecision precision,
+                    uint32_t maxIterations);
 
 /** @brief Calculates mandelbrot iterations over given points.
 *
 *   @param  points     Array of points.
-*   @param  numPoints  Number of elements in array points
+*   @param  first      Index of the first point which is iterated
+*   @param  numPoints  Number of points starting at first
 *   @param  iterations Number of iterations which are calculated.
-*   @return void
+*           Points which diverge get their smooth iteration count.
+*   @return Number of points which glitched, only for MANDEL_PERTURBATION.
+*           They stop until correctGlitches() is called.
 */
 
-void iterateMandelbrot(MandelPoint* points, int numPoints, int iterations);
+int iterateMandelbrot(MandelPoint* points, int first, int numPoints, int iterations);
+
+/** @brief Gives points which glitched with perturbation another reference.
+ *
+ *         Calculates a new reference orbit if needed. The references are shared
+ *         by all points, so calls for the same points must not run concurrently.
+ *
+ *  @param  points    Array of points.
+ *  @param  first     Index of the first point which is corrected
+ *  @param  numPoints Number of points starting at first
+ *  @param  cancel    Stops calculating a new reference orbit, may be NULL
+ *  @param  data      Passed to cancel
+ *  @return Number of points which continue with another reference
+ */
+
+int correctGlitches(MandelPoint* points, int first, int numPoints, ReferenceCancel cancel, const void* data);
+
+/** @brief Copies the points of a tile which are still iterated.
+ *
+ *         Iterating the copy only touches points which need work, instead of
+ *         skipping the done ones every pass. The copy shares the references
+ *         with the original, so it must not be used after the original is
+ *         initialised again.
+ *
+ *  @param  live      Receives the copy. Must be allocated for the points of the tile.
+ *  @param  index     Receives the index in points of every copied point
+ *  @param  points    The points
+ *  @param  tile      The tile on the screen the points were initialised for
+ *  @param  stride    Only points in every stride-th row and column of the screen
+ *                    are copied, 1 for all points
+ *  @return Number of copied points, -1 if memory allocation failed
+ */
+
+int gatherMandelPoints(MandelPoint* live, uint32_t* index, MandelPoint* points, const struct MandelTile* tile, int stride);
+
+/** @brief Copies the points on the border of a tile which are still iterated.
+ *
+ *         Like gatherMandelPoints(), for rendering by subdivision: if all points
+ *         on the border of a tile have the same result, the points inside very
+ *         likely have it too.
+ *
+ *  @param  live      Receives the copy. Must be allocated for the points of the tile.
+ *  @param  index     Receives the index in points of every copied point
+ *  @param  points    The points
+ *  @param  tile      The tile on the screen the points were initialised for
+ *  @return Number of copied points, -1 if memory allocation failed
+ */
+
+int gatherMandelBorder(MandelPoint* live, uint32_t* index, MandelPoint* points, const struct MandelTile* tile);
+
+/** @brief Tells if all points on the border of a tile have the same result.
+ *
+ *         Points which diverged must have the same smooth count as well.
+ *
+ *  @param  points The points
+ *  @param  tile   The tile on the screen
+ *  @param  value  Receives the diverged value of the border
+ *  @return 1 if the border is done and has one value, else 0
+ */
+
+int uniformMandelBorder(const MandelPoint* points, const struct MandelTile* tile, uint32_t* value);
+
+/** @brief Gives all points of a tile without result the same one.
+ *
+ *         They get the smooth count of the top left point, which is the one
+ *         of the whole border if uniformMandelBorder() found it uniform.
+ *
+ *  @param  points The points
+ *  @param  tile   The tile on the screen
+ *  @param  value  The diverged value, e.g. of the border
+ */
+
+void fillMandelTile(MandelPoint* points, const struct MandelTile* tile, uint32_t value);
+
+/** @brief Writes the points of the copy back to the original.
+ *
+ *         The original continues where the copy stopped. Points which used
+ *         up the iteration budget are marked as inside the set.
+ *
+ *  @param  points The original points
+ *  @param  live   The copy made with gatherMandelPoints()
+ *  @param  index  The index of the copied points in points
+ *  @param  count  Number of points in live
+ *  @return Number of points in live which are still iterated
+ */
+
+int scatterMandelPoints(MandelPoint* points, MandelPoint* live, const uint32_t* index, int count);
+
+/** @brief Removes the points which are done from the copy.
+ *
+ *         Their result is written back to the original, like with scatterMandelPoints().
+ *
+ *  @param  points The original points
+ *  @param  live   The copy made with gatherMandelPoints()
+ *  @param  index  The index of the copied points in points
+ *  @param  count  Number of points in live
+ *  @return Number of points in live which are still iterated
+ */
+
+int compactMandelPoints(MandelPoint* points, MandelPoint* live, uint32_t* index, int count);
+
+/** @brief Counts the points in range which are still iterated.
+ *
+ *         Points which used up the iteration budget are marked as inside the
+ *         set, so once this returns 0 the points in range are done.
+ *
+ *  @param  points    The points
+ *  @param  first     Index of the first point in range
+ *  @param  numPoints Number of points in range
+ *  @return Number of points which need more iterations
+ */
+
+int countLiveMandelPoints(MandelPoint* points, int first, int numPoints);
 
 /** @brief Draws the mandelbrot to an array of pixels
+ *
+ *         Points inside the set are black, the others are colored by
+ *         their smooth iteration count. Points which are still
+ *         iterated are drawn like the nearest point of a progressive pass
+ *         above and left of them, which covers the block up to the next
+ *         point of the pass. Without one they are drawn like their preview,
+ *         the first color without one. Mirrored rows are drawn like the rows
+ *         they mirror, see mirroredMandelRows().
  *
  *  @param  points    The Mandelbrot points
- *  @param  pixels    The pixels which are drawn
- *  @param  numPoints Number of pixels and points must be the same
- *  @param  colors    The color palette
- *  @param  numColors Depth of the color palette
+ *  @param  pixels    The pixel of the top left point of tile
+ *  @param  pitch     Pixels from one row to the next
+ *  @param  tile      Part of the screen which is drawn
+ *  @param  palette   The color palette
  *  @return void
  */
 
 void drawMandelbrot(const MandelPoint* points,
                     uint32_t* pixels,
-                    int numPoints,
-                    const uint32_t* colors,
-                    int numColors);
+                    int pitch,
+                    const struct MandelTile* tile,
+                    const struct ColorPalette* palette);
 
 #define MANDELBROT_H
 #endif /* MANDELBROT_H */
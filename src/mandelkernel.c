@@ -0,0 +1,158 @@
+/*  Filename:  mandelkernel.c
+ *
+ *  Author:    mandex contributors
+ *  Copyright: (c) 2026 mandex contributors. All rights reserved.
+ *             This work is licensed under the terms of the MIT license.
+ */
+
+#include "mandelkernel.h"
+
+static const struct MandelKernels kernelsScalar = {
+    .name = "scalar",
+    .iterateDouble = iterateDoubleScalar,
+    .iterateFloat = iterateFloatScalar,
+    .iterateDoubleDouble = iterateDoubleDoubleScalar,
+    .iterateQuadDouble = iterateQuadDoubleScalar,
+    .iteratePerturbation = iteratePerturbationScalar
+};
+
+#ifdef MANDELKERNEL_X86
+static const struct MandelKernels kernelsSSE2 = {
+    .name = "SSE2",
+    .iterateDouble = iterateDoubleSSE2,
+    .iterateFloat = iterateFloatSSE2,
+    .iterateDoubleDouble = iterateDoubleDoubleScalar,     // no fma before AVX2
+    .iterateQuadDouble = iterateQuadDoubleScalar,
+    .iteratePerturbation = iteratePerturbationScalar
+};
+
+static const struct MandelKernels kernelsAVX2 = {
+    .name = "AVX2",
+    .iterateDouble = iterateDoubleAVX2,
+    .iterateFloat = iterateFloatAVX2,
+    .iterateDoubleDouble = iterateDoubleDoubleAVX2,
+    .iterateQuadDouble = iterateQuadDoubleScalar,
+    .iteratePerturbation = iteratePerturbationAVX2
+};
+
+static const struct MandelKernels kernelsAVX512 = {
+    .name = "AVX-512",
+    .iterateDouble = iterateDoubleAVX512,
+    .iterateFloat = iterateFloatAVX512,
+    .iterateDoubleDouble = iterateDoubleDoubleAVX512,
+    .iterateQuadDouble = iterateQuadDoubleScalar,
+    .iteratePerturbation = iteratePerturbationAVX2     // lanes rarely stay in lockstep for 8 points
+};
+#endif
+
+const struct MandelKernels* selectMandelKernels(void)
+{
+#ifdef MANDELKERNEL_X86
+    // also checks if the os saves the vector registers
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+        return &kernelsAVX512;
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+        return &kernelsAVX2;
+    if (__builtin_cpu_supports("sse2"))
+        return &kernelsSSE2;
+#endif
+    return &kernelsScalar;
+}
+
+void iterateDoubleScalar(struct MandelPoint* points, int first, int numPoints, int iterations)
+{
+    double* restrict c_re = points->c_re;
+    double* restrict c_im = points->c_im;
+    double* restrict z_re = points->z_re;
+    double* restrict z_im = points->z_im;
+    uint32_t* restrict iter = points->iterations;
+    uint32_t* restrict diverged = points->diverged;
+    double* restrict zs_re = points->zs_re;
+    double* restrict zs_im = points->zs_im;
+    const double eps = points->cycleEpsilon;
+
+    for (int p = first; p < first + numPoints; ++p) {
+        if (diverged[p])
+            continue;
+
+        if (isCycleStart(iter[p], iterations)) {
+            zs_re[p] = z_re[p];
+            zs_im[p] = z_im[p];
+        }
+        int i = iterations;
+        double zr = z_re[p];
+        double zi = z_im[p];
+        double sr = zs_re[p];
+        double si = zs_im[p];
+        double z2_re = zr * zr;
+        double z2_im = zi * zi;
+        uint32_t n = iter[p];
+
+        while (i--) {
+            zi = 2.0 * zr * zi + c_im[p];
+            zr = z2_re - z2_im + c_re[p];
+            z2_re = zr * zr;
+            z2_im = zi * zi;
+            if (z2_re + z2_im > 4.0) {
+                diverged[p] = n + 1;
+                break;
+            }
+            ++n;
+            double dr = zr - sr;
+            double di = zi - si;
+            if (dr * dr + di * di < eps) {
+                diverged[p] = MANDEL_INTERIOR;
+                break;
+            }
+        }
+        z_re[p] = zr;
+        z_im[p] = zi;
+        iter[p] = n;
+    }
+}
+
+// Points are stored as double and only converted for iterating, so
+// switching between float and double needs no other storage.
+void iterateFloatScalar(struct MandelPoint* points, int first, int numPoints, int iterations)
+{
+    const float eps = (float)points->cycleEpsilon;
+
+    for (int p = first; p < first + numPoints; ++p) {
+        if (points->diverged[p])
+            continue;
+
+        startCycleCheck(points, p, 1, iterations);
+        int i = iterations;
+        float sr = (float)points->zs_re[p];
+        float si = (float)points->zs_im[p];
+        float cr = (float)points->c_re[p];
+        float ci = (float)points->c_im[p];
+        float zr = (float)points->z_re[p];
+        float zi = (float)points->z_im[p];
+        float z2_re = zr * zr;
+        float z2_im = zi * zi;
+        uint32_t n = points->iterations[p];
+
+        while (i--) {
+            zi = 2.0f * zr * zi + ci;
+            zr = z2_re - z2_im + cr;
+            z2_re = zr * zr;
+            z2_im = zi * zi;
+            if (z2_re + z2_im > 4.0f) {
+                points->diverged[p] = n + 1;
+                break;
+            }
+            ++n;
+            float dr = zr - sr;
+            float di = zi - si;
+            if (dr * dr + di * di < eps) {
+                points->diverged[p] = MANDEL_INTERIOR;
+                break;
+            }
+        }
+        points->z_re[p] = zr;
+        points->z_im[p] = zi;
+        points->iterations[p] = n;
+    }
+}
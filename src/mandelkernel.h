@@ -0,0 +1,161 @@
+/** @file        mandelkernel.h
+ *
+ *  @brief       Iteration kernels for the mandelbrot set and the point storage they work on.
+ *
+ *               Internal header shared by mandelbrot.c and the kernel implementations.
+ *               There is one kernel per instruction set. The best one for the cpu is
+ *               selected at runtime, so one binary runs well on all x86 machines.
+ *
+ *  @version     1.0
+ *  @date        10/17/2026
+ *  Revision:    -
+ *
+ *  @author      mandex contributors
+ *  @copyright   Copyright (c) 2026 mandex contributors. All rights reserved.
+ *               This work is licensed under the terms of the MIT license.
+ */
+
+#ifndef MANDELKERNEL_H
+#define MANDELKERNEL_H
+
+#include <stdint.h>
+#include "qd_real.h"
+#include "perturbation.h"
+#include "mandelbrot.h"
+
+// Kernels for SSE2, AVX2 and AVX-512 are only compiled for x86 with gcc or clang.
+// Everywhere else (e.g. WebAssembly) the scalar kernel is used.
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define MANDELKERNEL_X86
+#endif
+
+/** @brief   The points of the mandelbrot set as struct of arrays.
+ *
+ *  @details Every lane has one element per pixel, so a kernel can load
+ *           consecutive pixels into one vector register.
+ *           All lanes are aligned to 64 bytes.
+ *
+ *           For float and double c is the point itself. For double-double and
+ *           quad-double c is the offset to center, which the kernels add in
+ *           extended precision. z is stored in z and the tail lanes then.
+ *
+ *           For perturbation c is the offset to center as well and z is the
+ *           difference to the orbit of the reference the point uses.
+ */
+
+struct MandelPoint {
+    int precision;          // enum MandelPrecision the points were initialised for
+    double* c_re;
+    double* c_im;
+    double* z_re;
+    double* z_im;
+    uint32_t* iterations;
+    uint32_t* diverged;     // 0, iteration at which the point diverged + 1, or MANDEL_INTERIOR
+    uint32_t* preview;      // drawn instead of diverged until the point has a result
+    uint8_t* smooth;        // fraction of the iteration at which the point diverged, see MANDEL_SMOOTH_STEPS
+    double* zs_re;          // z saved for periodicity checking for float and double, for perturbation
+                            // the iteration of the orbit a point without reference is rebased on
+    double* zs_im;
+    double cycleEpsilon;    // squared distance to the saved z at which a point is periodic
+    uint32_t maxIterations; // points which reach this count are treated as interior
+    void* memory;           // one allocation backing all lanes
+    uint32_t numPoints;
+    struct ScreenXY screen; // the view the points are initialised for
+    int mirror;             // rows y and mirror - y are complex conjugates, -1 if none are
+
+    qd_real center_re;
+    qd_real center_im;
+    double* z_re_tail[3];   // lower parts of z, only allocated for extended precision
+    double* z_im_tail[3];
+    void* tailMemory;
+
+    uint8_t* reference;     // index of the reference orbit, flags for glitched points
+    struct MandelReferences* references;    // only for perturbation, else NULL
+    int compacted;          // copy made by gatherMandelPoints(), the references belong to the original
+};
+
+/** @brief Returns if a point saves z for periodicity checking before this pass.
+ *
+ *         Periodicity is checked like in Brent's cycle detection. z is compared
+ *         with the saved z every iteration and saved again after 1, 2, 4, 8...
+ *         passes, so a cycle is found once its period fits between two saves.
+ *
+ *  @param n          Iterations the point has done so far
+ *  @param iterations Iterations per pass
+ */
+
+static inline int isCycleStart(uint32_t n, int iterations)
+{
+    uint32_t pass = n / iterations;
+    return (pass & (pass - 1)) == 0;
+}
+
+/** @brief Saves z of the points in range which start a cycle check
+ */
+
+static inline void startCycleCheck(struct MandelPoint* points, int first, int numPoints, int iterations)
+{
+    for (int p = first; p < first + numPoints; ++p) {
+        if (isCycleStart(points->iterations[p], iterations)) {
+            points->zs_re[p] = points->z_re[p];
+            points->zs_im[p] = points->z_im[p];
+        }
+    }
+}
+
+/** @brief Calculates mandelbrot iterations over a range of points.
+ *
+ *  @param points     The points
+ *  @param first      Index of the first point in range
+ *  @param numPoints  Number of points in range
+ *  @param iterations Number of iterations which are calculated.
+ *  @return void
+ */
+
+typedef void (*MandelKernel)(struct MandelPoint* points, int first, int numPoints, int iterations);
+
+/** @brief Calculates mandelbrot iterations relative to reference orbits.
+ *
+ *  @return Number of points in range which glitched in this call
+ */
+
+typedef int (*PerturbationKernel)(struct MandelPoint* points, int first, int numPoints, int iterations);
+
+/** @brief The kernels for one instruction set
+ */
+
+struct MandelKernels {
+    const char* name;
+    MandelKernel iterateDouble;
+    MandelKernel iterateFloat;      // twice the lanes of iterateDouble
+    MandelKernel iterateDoubleDouble;
+    MandelKernel iterateQuadDouble;
+    PerturbationKernel iteratePerturbation;
+};
+
+/** @brief Selects the fastest kernels the cpu supports (checked with cpuid).
+ *
+ *  @return The selected kernels. Statically allocated, do not free.
+ */
+
+const struct MandelKernels* selectMandelKernels(void);
+
+void iterateDoubleScalar(struct MandelPoint* points, int first, int numPoints, int iterations);
+void iterateFloatScalar(struct MandelPoint* points, int first, int numPoints, int iterations);
+void iterateDoubleDoubleScalar(struct MandelPoint* points, int first, int numPoints, int iterations);
+void iterateQuadDoubleScalar(struct MandelPoint* points, int first, int numPoints, int iterations);
+int iteratePerturbationScalar(struct MandelPoint* points, int first, int numPoints, int iterations);
+
+#ifdef MANDELKERNEL_X86
+void iterateDoubleSSE2(struct MandelPoint* points, int first, int numPoints, int iterations);
+void iterateFloatSSE2(struct MandelPoint* points, int first, int numPoints, int iterations);
+void iterateDoubleAVX2(struct MandelPoint* points, int first, int numPoints, int iterations);
+void iterateFloatAVX2(struct MandelPoint* points, int first, int numPoints, int iterations);
+void iterateDoubleDoubleAVX2(struct MandelPoint* points, int first, int numPoints, int iterations);
+int iteratePerturbationAVX2(struct MandelPoint* points, int first, int numPoints, int iterations);
+void iterateDoubleAVX512(struct MandelPoint* points, int first, int numPoints, int iterations);
+void iterateFloatAVX512(struct MandelPoint* points, int first, int numPoints, int iterations);
+void iterateDoubleDoubleAVX512(struct MandelPoint* points, int first, int numPoints, int iterations);
+#endif
+
+#endif /* MANDELKERNEL_H */
@@ -0,0 +1,370 @@
+/*  Filename:  mandelkernel_avx2.c
+ *
+ *  Author:    mandex contributors
+ *  Copyright: (c) 2026 mandex contributors. All rights reserved.
+ *             This work is licensed under the terms of the MIT license.
+ */
+
+#include "mandelkernel.h"
+
+#ifdef MANDELKERNEL_X86
+
+#include <immintrin.h>
+
+#define TARGET_AVX2 __attribute__((target("avx2,fma")))
+
+TARGET_AVX2 void iterateDoubleAVX2(struct MandelPoint* points, int first, int numPoints, int iterations)
+{
+    const __m256d four = _mm256_set1_pd(4.0);
+    const __m256d one = _mm256_set1_pd(1.0);
+    const __m256d interior = _mm256_set1_pd(-1.0);     // all bits set as int32, MANDEL_INTERIOR
+    const __m256d eps = _mm256_set1_pd(points->cycleEpsilon);
+    int end = first + numPoints;
+    int p = first;
+
+    for (; p + 4 <= end; p += 4) {
+        __m256d div = _mm256_cvtepi32_pd(_mm_loadu_si128((const __m128i*)(points->diverged + p)));
+        __m256d active = _mm256_cmp_pd(div, _mm256_setzero_pd(), _CMP_EQ_OQ);
+        if (_mm256_testz_pd(active, active))
+            continue;
+
+        startCycleCheck(points, p, 4, iterations);
+        __m256d sr = _mm256_loadu_pd(points->zs_re + p);
+        __m256d si = _mm256_loadu_pd(points->zs_im + p);
+        __m256d cr = _mm256_loadu_pd(points->c_re + p);
+        __m256d ci = _mm256_loadu_pd(points->c_im + p);
+        __m256d zr = _mm256_loadu_pd(points->z_re + p);
+        __m256d zi = _mm256_loadu_pd(points->z_im + p);
+        __m256d n = _mm256_cvtepi32_pd(_mm_loadu_si128((const __m128i*)(points->iterations + p)));
+        __m256d zr2 = _mm256_mul_pd(zr, zr);
+        __m256d zi2 = _mm256_mul_pd(zi, zi);
+        __m256d zr_out = zr;
+        __m256d zi_out = zi;
+
+        for (int i = iterations; i--;) {
+            zi = _mm256_fmadd_pd(_mm256_add_pd(zr, zr), zi, ci);
+            zr = _mm256_add_pd(_mm256_sub_pd(zr2, zi2), cr);
+            zr2 = _mm256_mul_pd(zr, zr);
+            zi2 = _mm256_mul_pd(zi, zi);
+            __m256d escaped = _mm256_and_pd(_mm256_cmp_pd(_mm256_add_pd(zr2, zi2), four, _CMP_GT_OQ), active);
+            div = _mm256_blendv_pd(div, _mm256_add_pd(n, one), escaped);
+            zr_out = _mm256_blendv_pd(zr_out, zr, escaped);
+            zi_out = _mm256_blendv_pd(zi_out, zi, escaped);
+            active = _mm256_andnot_pd(escaped, active);
+            n = _mm256_add_pd(n, _mm256_and_pd(active, one));
+            __m256d dr = _mm256_sub_pd(zr, sr);
+            __m256d di = _mm256_sub_pd(zi, si);
+            __m256d cycle = _mm256_and_pd(_mm256_cmp_pd(_mm256_fmadd_pd(dr, dr, _mm256_mul_pd(di, di)), eps, _CMP_LT_OQ), active);
+            div = _mm256_blendv_pd(div, interior, cycle);
+            active = _mm256_andnot_pd(cycle, active);
+            if (_mm256_testz_pd(active, active))
+                break;
+        }
+
+        _mm256_storeu_pd(points->z_re + p, _mm256_blendv_pd(zr_out, zr, active));
+        _mm256_storeu_pd(points->z_im + p, _mm256_blendv_pd(zi_out, zi, active));
+        _mm_storeu_si128((__m128i*)(points->iterations + p), _mm256_cvttpd_epi32(n));
+        _mm_storeu_si128((__m128i*)(points->diverged + p), _mm256_cvttpd_epi32(div));
+    }
+    iterateDoubleScalar(points, p, end - p, iterations);
+}
+
+TARGET_AVX2 static inline __m256 load_ps(const double* src)
+{
+    __m128 lo = _mm256_cvtpd_ps(_mm256_loadu_pd(src));
+    __m128 hi = _mm256_cvtpd_ps(_mm256_loadu_pd(src + 4));
+    return _mm256_insertf128_ps(_mm256_castps128_ps256(lo), hi, 1);
+}
+
+TARGET_AVX2 static inline void store_ps(double* dst, __m256 v)
+{
+    _mm256_storeu_pd(dst, _mm256_cvtps_pd(_mm256_castps256_ps128(v)));
+    _mm256_storeu_pd(dst + 4, _mm256_cvtps_pd(_mm256_extractf128_ps(v, 1)));
+}
+
+TARGET_AVX2 void iterateFloatAVX2(struct MandelPoint* points, int first, int numPoints, int iterations)
+{
+    const __m256 four = _mm256_set1_ps(4.0f);
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256 eps = _mm256_set1_ps((float)points->cycleEpsilon);
+    const __m256i interior = _mm256_set1_epi32((int)MANDEL_INTERIOR);
+    int end = first + numPoints;
+    int p = first;
+
+    for (; p + 8 <= end; p += 8) {
+        // iteration counts stay integers, float can't count beyond 2^24
+        __m256i div = _mm256_loadu_si256((const __m256i*)(points->diverged + p));
+        __m256 active = _mm256_castsi256_ps(_mm256_cmpeq_epi32(div, _mm256_setzero_si256()));
+        if (_mm256_testz_ps(active, active))
+            continue;
+
+        startCycleCheck(points, p, 8, iterations);
+        __m256 sr = load_ps(points->zs_re + p);
+        __m256 si = load_ps(points->zs_im + p);
+        __m256 cr = load_ps(points->c_re + p);
+        __m256 ci = load_ps(points->c_im + p);
+        __m256 zr = load_ps(points->z_re + p);
+        __m256 zi = load_ps(points->z_im + p);
+        __m256i n = _mm256_loadu_si256((const __m256i*)(points->iterations + p));
+        __m256 zr2 = _mm256_mul_ps(zr, zr);
+        __m256 zi2 = _mm256_mul_ps(zi, zi);
+        __m256 zr_out = zr;
+        __m256 zi_out = zi;
+
+        for (int i = iterations; i--;) {
+            zi = _mm256_fmadd_ps(_mm256_add_ps(zr, zr), zi, ci);
+            zr = _mm256_add_ps(_mm256_sub_ps(zr2, zi2), cr);
+            zr2 = _mm256_mul_ps(zr, zr);
+            zi2 = _mm256_mul_ps(zi, zi);
+            __m256 escaped = _mm256_and_ps(_mm256_cmp_ps(_mm256_add_ps(zr2, zi2), four, _CMP_GT_OQ), active);
+            div = _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(div), _mm256_castsi256_ps(_mm256_add_epi32(n, one)), escaped));
+            zr_out = _mm256_blendv_ps(zr_out, zr, escaped);
+            zi_out = _mm256_blendv_ps(zi_out, zi, escaped);
+            active = _mm256_andnot_ps(escaped, active);
+            n = _mm256_sub_epi32(n, _mm256_castps_si256(active));  // mask is -1 for active lanes
+            __m256 dr = _mm256_sub_ps(zr, sr);
+            __m256 di = _mm256_sub_ps(zi, si);
+            __m256 cycle = _mm256_and_ps(_mm256_cmp_ps(_mm256_fmadd_ps(dr, dr, _mm256_mul_ps(di, di)), eps, _CMP_LT_OQ), active);
+            div = _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(div), _mm256_castsi256_ps(interior), cycle));
+            active = _mm256_andnot_ps(cycle, active);
+            if (_mm256_testz_ps(active, active))
+                break;
+        }
+
+        store_ps(points->z_re + p, _mm256_blendv_ps(zr_out, zr, active));
+        store_ps(points->z_im + p, _mm256_blendv_ps(zi_out, zi, active));
+        _mm256_storeu_si256((__m256i*)(points->iterations + p), n);
+        _mm256_storeu_si256((__m256i*)(points->diverged + p), div);
+    }
+    iterateFloatScalar(points, p, end - p, iterations);
+}
+
+// Double-double arithmetic on 4 lanes, see dd_real.h for the scalar version
+
+struct dd4 {
+    __m256d hi;
+    __m256d lo;
+};
+
+TARGET_AVX2 static inline __m256d two_sum4(__m256d a, __m256d b, __m256d* err)
+{
+    __m256d s = _mm256_add_pd(a, b);
+    __m256d bb = _mm256_sub_pd(s, a);
+    *err = _mm256_add_pd(_mm256_sub_pd(a, _mm256_sub_pd(s, bb)), _mm256_sub_pd(b, bb));
+    return s;
+}
+
+TARGET_AVX2 static inline struct dd4 quick_two_sum4(__m256d a, __m256d b)
+{
+    struct dd4 r;
+    r.hi = _mm256_add_pd(a, b);
+    r.lo = _mm256_sub_pd(b, _mm256_sub_pd(r.hi, a));
+    return r;
+}
+
+TARGET_AVX2 static inline struct dd4 dd4_add(struct dd4 a, struct dd4 b)
+{
+    __m256d e, f;
+    __m256d s = two_sum4(a.hi, b.hi, &e);
+    __m256d t = two_sum4(a.lo, b.lo, &f);
+    struct dd4 r = quick_two_sum4(s, _mm256_add_pd(e, t));
+    return quick_two_sum4(r.hi, _mm256_add_pd(r.lo, f));
+}
+
+TARGET_AVX2 static inline struct dd4 dd4_sub(struct dd4 a, struct dd4 b)
+{
+    const __m256d sign = _mm256_set1_pd(-0.0);
+    b.hi = _mm256_xor_pd(b.hi, sign);
+    b.lo = _mm256_xor_pd(b.lo, sign);
+    return dd4_add(a, b);
+}
+
+TARGET_AVX2 static inline struct dd4 dd4_mul(struct dd4 a, struct dd4 b)
+{
+    __m256d p = _mm256_mul_pd(a.hi, b.hi);
+    __m256d e = _mm256_fmsub_pd(a.hi, b.hi, p);
+    e = _mm256_fmadd_pd(a.hi, b.lo, e);
+    e = _mm256_fmadd_pd(a.lo, b.hi, e);
+    return quick_two_sum4(p, e);
+}
+
+TARGET_AVX2 static inline struct dd4 dd4_sqr(struct dd4 a)
+{
+    __m256d p = _mm256_mul_pd(a.hi, a.hi);
+    __m256d e = _mm256_fmsub_pd(a.hi, a.hi, p);
+    e = _mm256_fmadd_pd(_mm256_add_pd(a.hi, a.hi), a.lo, e);
+    return quick_two_sum4(p, e);
+}
+
+TARGET_AVX2 static inline struct dd4 dd4_load(const double* hi, const double* lo)
+{
+    struct dd4 r = { _mm256_loadu_pd(hi), _mm256_loadu_pd(lo) };
+    return r;
+}
+
+TARGET_AVX2 void iterateDoubleDoubleAVX2(struct MandelPoint* points, int first, int numPoints, int iterations)
+{
+    const __m256d four = _mm256_set1_pd(4.0);
+    const __m256d one = _mm256_set1_pd(1.0);
+    dd_real center_re = qd_to_dd(points->center_re);
+    dd_real center_im = qd_to_dd(points->center_im);
+    struct dd4 center_re4 = { _mm256_set1_pd(center_re.hi), _mm256_set1_pd(center_re.lo) };
+    struct dd4 center_im4 = { _mm256_set1_pd(center_im.hi), _mm256_set1_pd(center_im.lo) };
+    int end = first + numPoints;
+    int p = first;
+
+    for (; p + 4 <= end; p += 4) {
+        __m256d div = _mm256_cvtepi32_pd(_mm_loadu_si128((const __m128i*)(points->diverged + p)));
+        __m256d active = _mm256_cmp_pd(div, _mm256_setzero_pd(), _CMP_EQ_OQ);
+        if (_mm256_testz_pd(active, active))
+            continue;
+
+        struct dd4 offset_re = { _mm256_loadu_pd(points->c_re + p), _mm256_setzero_pd() };
+        struct dd4 offset_im = { _mm256_loadu_pd(points->c_im + p), _mm256_setzero_pd() };
+        struct dd4 cr = dd4_add(center_re4, offset_re);
+        struct dd4 ci = dd4_add(center_im4, offset_im);
+        struct dd4 zr = dd4_load(points->z_re + p, points->z_re_tail[0] + p);
+        struct dd4 zi = dd4_load(points->z_im + p, points->z_im_tail[0] + p);
+        __m256d n = _mm256_cvtepi32_pd(_mm_loadu_si128((const __m128i*)(points->iterations + p)));
+        struct dd4 zr_out = zr;
+        struct dd4 zi_out = zi;
+
+        for (int i = iterations; i--;) {
+            struct dd4 zr2 = dd4_sqr(zr);
+            struct dd4 zi2 = dd4_sqr(zi);
+            struct dd4 zri = dd4_mul(zr, zi);
+            zri.hi = _mm256_add_pd(zri.hi, zri.hi);
+            zri.lo = _mm256_add_pd(zri.lo, zri.lo);
+            zi = dd4_add(zri, ci);
+            zr = dd4_add(dd4_sub(zr2, zi2), cr);
+            __m256d abs2 = _mm256_fmadd_pd(zr.hi, zr.hi, _mm256_mul_pd(zi.hi, zi.hi));
+            __m256d escaped = _mm256_and_pd(_mm256_cmp_pd(abs2, four, _CMP_GT_OQ), active);
+            div = _mm256_blendv_pd(div, _mm256_add_pd(n, one), escaped);
+            zr_out.hi = _mm256_blendv_pd(zr_out.hi, zr.hi, escaped);
+            zr_out.lo = _mm256_blendv_pd(zr_out.lo, zr.lo, escaped);
+            zi_out.hi = _mm256_blendv_pd(zi_out.hi, zi.hi, escaped);
+            zi_out.lo = _mm256_blendv_pd(zi_out.lo, zi.lo, escaped);
+            active = _mm256_andnot_pd(escaped, active);
+            n = _mm256_add_pd(n, _mm256_and_pd(active, one));
+            if (_mm256_testz_pd(active, active))
+                break;
+        }
+
+        _mm256_storeu_pd(points->z_re + p, _mm256_blendv_pd(zr_out.hi, zr.hi, active));
+        _mm256_storeu_pd(points->z_re_tail[0] + p, _mm256_blendv_pd(zr_out.lo, zr.lo, active));
+        _mm256_storeu_pd(points->z_im + p, _mm256_blendv_pd(zi_out.hi, zi.hi, active));
+        _mm256_storeu_pd(points->z_im_tail[0] + p, _mm256_blendv_pd(zi_out.lo, zi.lo, active));
+        _mm_storeu_si128((__m128i*)(points->iterations + p), _mm256_cvttpd_epi32(n));
+        _mm_storeu_si128((__m128i*)(points->diverged + p), _mm256_cvttpd_epi32(div));
+    }
+    iterateDoubleDoubleScalar(points, p, end - p, iterations);
+}
+
+// Perturbation needs the same Z for all lanes, so a vector of points is only
+// iterated together while they use the same reference at the same iteration.
+// That is the common case, because the series approximation starts all points
+// at the same iteration. Everything else is left to the scalar kernel.
+
+TARGET_AVX2 int iteratePerturbationAVX2(struct MandelPoint* points, int first, int numPoints, int iterations)
+{
+    const struct MandelReferences* refs = points->references;
+    const __m256d two = _mm256_set1_pd(2.0);
+    const __m256d four = _mm256_set1_pd(4.0);
+    const __m256d one = _mm256_set1_pd(1.0);
+    int glitched = 0;
+    int end = first + numPoints;
+    int p = first;
+
+    for (; p + 4 <= end; p += 4) {
+        int lead = -1;
+        int lockstep = 1;
+        long long lanes[4];
+        for (int l = 0; l < 4; ++l) {
+            int live = !points->diverged[p + l] && !(points->reference[p + l] & REFERENCE_GLITCHED);
+            lanes[l] = live ? -1 : 0;
+            if (!live)
+                continue;
+            if (lead < 0)
+                lead = p + l;
+            else if (points->reference[p + l] != points->reference[lead]
+                     || points->iterations[p + l] != points->iterations[lead])
+                lockstep = 0;
+        }
+        if (lead < 0)
+            continue;
+        if (!lockstep) {
+            glitched += iteratePerturbationScalar(points, p, 4, iterations);
+            continue;
+        }
+
+        uint8_t r = points->reference[lead];
+        const struct ReferenceOrbit* orbit = refs->orbit[r];
+        const double* Zr = orbit->z_re;
+        const double* Zi = orbit->z_im;
+        uint32_t n = points->iterations[lead];
+        int steps = orbit->length > (int)n ? orbit->length - (int)n : 0;
+        if (steps > iterations)
+            steps = iterations;
+
+        __m256d active = _mm256_castsi256_pd(_mm256_set_epi64x(lanes[3], lanes[2], lanes[1], lanes[0]));
+        __m256d glitch = _mm256_setzero_pd();
+        __m256d dcr = _mm256_sub_pd(_mm256_loadu_pd(points->c_re + p), _mm256_set1_pd(refs->offset_re[r]));
+        __m256d dci = _mm256_sub_pd(_mm256_loadu_pd(points->c_im + p), _mm256_set1_pd(refs->offset_im[r]));
+        __m256d dzr = _mm256_loadu_pd(points->z_re + p);
+        __m256d dzi = _mm256_loadu_pd(points->z_im + p);
+        __m256d div = _mm256_cvtepi32_pd(_mm_loadu_si128((const __m128i*)(points->diverged + p)));
+        __m256d nv = _mm256_cvtepi32_pd(_mm_loadu_si128((const __m128i*)(points->iterations + p)));
+        __m256d dzr_out = dzr;
+        __m256d dzi_out = dzi;
+
+        int done = 0;
+        while (done < steps) {
+            __m256d tr = _mm256_fmadd_pd(two, _mm256_set1_pd(Zr[n]), dzr);
+            __m256d ti = _mm256_fmadd_pd(two, _mm256_set1_pd(Zi[n]), dzi);
+            __m256d nr = _mm256_fmadd_pd(tr, dzr, _mm256_fnmadd_pd(ti, dzi, dcr));
+            dzi = _mm256_fmadd_pd(tr, dzi, _mm256_fmadd_pd(ti, dzr, dci));
+            dzr = nr;
+
+            double Zr1 = Zr[n + 1];
+            double Zi1 = Zi[n + 1];
+            __m256d zr = _mm256_add_pd(_mm256_set1_pd(Zr1), dzr);
+            __m256d zi = _mm256_add_pd(_mm256_set1_pd(Zi1), dzi);
+            __m256d abs2 = _mm256_fmadd_pd(zr, zr, _mm256_mul_pd(zi, zi));
+            __m256d escaped = _mm256_and_pd(_mm256_cmp_pd(abs2, four, _CMP_GT_OQ), active);
+            div = _mm256_blendv_pd(div, _mm256_set1_pd((double)(n + 1)), escaped);
+            active = _mm256_andnot_pd(escaped, active);
+            nv = _mm256_add_pd(nv, _mm256_and_pd(active, one));
+
+            __m256d limit = _mm256_set1_pd(GLITCH_TOLERANCE * (Zr1 * Zr1 + Zi1 * Zi1));
+            __m256d g = _mm256_and_pd(_mm256_cmp_pd(abs2, limit, _CMP_LT_OQ), active);
+            glitch = _mm256_or_pd(glitch, g);
+            __m256d stopped = _mm256_or_pd(escaped, g);
+            dzr_out = _mm256_blendv_pd(dzr_out, dzr, stopped);
+            dzi_out = _mm256_blendv_pd(dzi_out, dzi, stopped);
+            active = _mm256_andnot_pd(g, active);
+            ++n;
+            ++done;
+            if (_mm256_testz_pd(active, active))
+                break;
+        }
+
+        _mm256_storeu_pd(points->z_re + p, _mm256_blendv_pd(dzr_out, dzr, active));
+        _mm256_storeu_pd(points->z_im + p, _mm256_blendv_pd(dzi_out, dzi, active));
+        _mm_storeu_si128((__m128i*)(points->iterations + p), _mm256_cvttpd_epi32(nv));
+        _mm_storeu_si128((__m128i*)(points->diverged + p), _mm256_cvttpd_epi32(div));
+        int mask = _mm256_movemask_pd(glitch);
+        for (int l = 0; l < 4; ++l) {
+            if (mask & (1 << l)) {
+                points->reference[p + l] |= REFERENCE_GLITCHED;
+                ++glitched;
+            }
+        }
+
+        // the reference ended before the iterations did
+        if (done < iterations && !_mm256_testz_pd(active, active))
+            glitched += iteratePerturbationScalar(points, p, 4, iterations - done);
+    }
+    return glitched + iteratePerturbationScalar(points, p, end - p, iterations);
+}
+
+#endif /* MANDELKERNEL_X86 */
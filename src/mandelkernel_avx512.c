@@ -0,0 +1,273 @@
+/*  Filename:  mandelkernel_avx512.c
+ *
+ *  Author:    mandex contributors
+ *  Copyright: (c) 2026 mandex contributors. All rights reserved.
+ *             This work is licensed under the terms of the MIT license.
+ */
+
+#include "mandelkernel.h"
+
+#ifdef MANDELKERNEL_X86
+
+#include <immintrin.h>
+
+#define TARGET_AVX512 __attribute__((target("avx512f")))
+
+// loads 8 uint32 and converts them to double, lanes not in mask are zero
+TARGET_AVX512 static inline __m512d load_u32(const uint32_t* src, __mmask8 mask)
+{
+    __m512i v = _mm512_maskz_loadu_epi32((__mmask16)mask, src);
+    return _mm512_cvtepu32_pd(_mm512_castsi512_si256(v));
+}
+
+TARGET_AVX512 static inline void store_u32(uint32_t* dst, __mmask8 mask, __m512d v)
+{
+    _mm512_mask_storeu_epi32(dst, (__mmask16)mask, _mm512_castsi256_si512(_mm512_cvttpd_epu32(v)));
+}
+
+TARGET_AVX512 void iterateDoubleAVX512(struct MandelPoint* points, int first, int numPoints, int iterations)
+{
+    const __m512d four = _mm512_set1_pd(4.0);
+    const __m512d one = _mm512_set1_pd(1.0);
+    const __m512d interior = _mm512_set1_pd((double)MANDEL_INTERIOR);
+    const __m512d eps = _mm512_set1_pd(points->cycleEpsilon);
+    int end = first + numPoints;
+
+    // the last block is handled with a partial mask, so no scalar tail is needed
+    for (int p = first; p < end; p += 8) {
+        __mmask8 inRange = end - p >= 8 ? 0xFF : (__mmask8)((1u << (end - p)) - 1);
+        __m512d div = load_u32(points->diverged + p, inRange);
+        __mmask8 active = _mm512_mask_cmp_pd_mask(inRange, div, _mm512_setzero_pd(), _CMP_EQ_OQ);
+        if (!active)
+            continue;
+
+        startCycleCheck(points, p, end - p >= 8 ? 8 : end - p, iterations);
+        __m512d sr = _mm512_maskz_loadu_pd(inRange, points->zs_re + p);
+        __m512d si = _mm512_maskz_loadu_pd(inRange, points->zs_im + p);
+        __m512d cr = _mm512_maskz_loadu_pd(inRange, points->c_re + p);
+        __m512d ci = _mm512_maskz_loadu_pd(inRange, points->c_im + p);
+        __m512d zr = _mm512_maskz_loadu_pd(inRange, points->z_re + p);
+        __m512d zi = _mm512_maskz_loadu_pd(inRange, points->z_im + p);
+        __m512d n = load_u32(points->iterations + p, inRange);
+        __m512d zr2 = _mm512_mul_pd(zr, zr);
+        __m512d zi2 = _mm512_mul_pd(zi, zi);
+        __m512d zr_out = zr;
+        __m512d zi_out = zi;
+
+        for (int i = iterations; i--;) {
+            zi = _mm512_fmadd_pd(_mm512_add_pd(zr, zr), zi, ci);
+            zr = _mm512_add_pd(_mm512_sub_pd(zr2, zi2), cr);
+            zr2 = _mm512_mul_pd(zr, zr);
+            zi2 = _mm512_mul_pd(zi, zi);
+            __mmask8 escaped = _mm512_mask_cmp_pd_mask(active, _mm512_add_pd(zr2, zi2), four, _CMP_GT_OQ);
+            div = _mm512_mask_mov_pd(div, escaped, _mm512_add_pd(n, one));
+            zr_out = _mm512_mask_mov_pd(zr_out, escaped, zr);
+            zi_out = _mm512_mask_mov_pd(zi_out, escaped, zi);
+            active &= ~escaped;
+            n = _mm512_mask_add_pd(n, active, n, one);
+            __m512d dr = _mm512_sub_pd(zr, sr);
+            __m512d di = _mm512_sub_pd(zi, si);
+            __mmask8 cycle = _mm512_mask_cmp_pd_mask(active, _mm512_fmadd_pd(dr, dr, _mm512_mul_pd(di, di)), eps, _CMP_LT_OQ);
+            div = _mm512_mask_mov_pd(div, cycle, interior);
+            active &= ~cycle;
+            if (!active)
+                break;
+        }
+
+        _mm512_mask_storeu_pd(points->z_re + p, inRange, _mm512_mask_mov_pd(zr_out, active, zr));
+        _mm512_mask_storeu_pd(points->z_im + p, inRange, _mm512_mask_mov_pd(zi_out, active, zi));
+        store_u32(points->iterations + p, inRange, n);
+        store_u32(points->diverged + p, inRange, div);
+    }
+}
+
+TARGET_AVX512 static inline __m512 load_ps(const double* src, __mmask16 mask)
+{
+    __m256 lo = _mm512_cvtpd_ps(_mm512_maskz_loadu_pd((__mmask8)mask, src));
+    __m256 hi = _mm512_cvtpd_ps(_mm512_maskz_loadu_pd((__mmask8)(mask >> 8), src + 8));
+    return _mm512_castpd_ps(_mm512_insertf64x4(_mm512_castpd256_pd512(_mm256_castps_pd(lo)), _mm256_castps_pd(hi), 1));
+}
+
+TARGET_AVX512 static inline void store_ps(double* dst, __mmask16 mask, __m512 v)
+{
+    __m512d pd = _mm512_castps_pd(v);
+    _mm512_mask_storeu_pd(dst, (__mmask8)mask, _mm512_cvtps_pd(_mm256_castpd_ps(_mm512_castpd512_pd256(pd))));
+    _mm512_mask_storeu_pd(dst + 8, (__mmask8)(mask >> 8), _mm512_cvtps_pd(_mm256_castpd_ps(_mm512_extractf64x4_pd(pd, 1))));
+}
+
+TARGET_AVX512 void iterateFloatAVX512(struct MandelPoint* points, int first, int numPoints, int iterations)
+{
+    const __m512 four = _mm512_set1_ps(4.0f);
+    const __m512i one = _mm512_set1_epi32(1);
+    const __m512i interior = _mm512_set1_epi32((int)MANDEL_INTERIOR);
+    const __m512 eps = _mm512_set1_ps((float)points->cycleEpsilon);
+    int end = first + numPoints;
+
+    for (int p = first; p < end; p += 16) {
+        __mmask16 inRange = end - p >= 16 ? 0xFFFF : (__mmask16)((1u << (end - p)) - 1);
+        // iteration counts stay integers, float can't count beyond 2^24
+        __m512i div = _mm512_maskz_loadu_epi32(inRange, points->diverged + p);
+        __mmask16 active = _mm512_mask_cmpeq_epi32_mask(inRange, div, _mm512_setzero_si512());
+        if (!active)
+            continue;
+
+        startCycleCheck(points, p, end - p >= 16 ? 16 : end - p, iterations);
+        __m512 sr = load_ps(points->zs_re + p, inRange);
+        __m512 si = load_ps(points->zs_im + p, inRange);
+        __m512 cr = load_ps(points->c_re + p, inRange);
+        __m512 ci = load_ps(points->c_im + p, inRange);
+        __m512 zr = load_ps(points->z_re + p, inRange);
+        __m512 zi = load_ps(points->z_im + p, inRange);
+        __m512i n = _mm512_maskz_loadu_epi32(inRange, points->iterations + p);
+        __m512 zr2 = _mm512_mul_ps(zr, zr);
+        __m512 zi2 = _mm512_mul_ps(zi, zi);
+        __m512 zr_out = zr;
+        __m512 zi_out = zi;
+
+        for (int i = iterations; i--;) {
+            zi = _mm512_fmadd_ps(_mm512_add_ps(zr, zr), zi, ci);
+            zr = _mm512_add_ps(_mm512_sub_ps(zr2, zi2), cr);
+            zr2 = _mm512_mul_ps(zr, zr);
+            zi2 = _mm512_mul_ps(zi, zi);
+            __mmask16 escaped = _mm512_mask_cmp_ps_mask(active, _mm512_add_ps(zr2, zi2), four, _CMP_GT_OQ);
+            div = _mm512_mask_mov_epi32(div, escaped, _mm512_add_epi32(n, one));
+            zr_out = _mm512_mask_mov_ps(zr_out, escaped, zr);
+            zi_out = _mm512_mask_mov_ps(zi_out, escaped, zi);
+            active &= ~escaped;
+            n = _mm512_mask_add_epi32(n, active, n, one);
+            __m512 dr = _mm512_sub_ps(zr, sr);
+            __m512 di = _mm512_sub_ps(zi, si);
+            __mmask16 cycle = _mm512_mask_cmp_ps_mask(active, _mm512_fmadd_ps(dr, dr, _mm512_mul_ps(di, di)), eps, _CMP_LT_OQ);
+            div = _mm512_mask_mov_epi32(div, cycle, interior);
+            active &= ~cycle;
+            if (!active)
+                break;
+        }
+
+        store_ps(points->z_re + p, inRange, _mm512_mask_mov_ps(zr_out, active, zr));
+        store_ps(points->z_im + p, inRange, _mm512_mask_mov_ps(zi_out, active, zi));
+        _mm512_mask_storeu_epi32(points->iterations + p, inRange, n);
+        _mm512_mask_storeu_epi32(points->diverged + p, inRange, div);
+    }
+}
+
+// Double-double arithmetic on 8 lanes, see dd_real.h for the scalar version
+
+struct dd8 {
+    __m512d hi;
+    __m512d lo;
+};
+
+TARGET_AVX512 static inline __m512d two_sum8(__m512d a, __m512d b, __m512d* err)
+{
+    __m512d s = _mm512_add_pd(a, b);
+    __m512d bb = _mm512_sub_pd(s, a);
+    *err = _mm512_add_pd(_mm512_sub_pd(a, _mm512_sub_pd(s, bb)), _mm512_sub_pd(b, bb));
+    return s;
+}
+
+TARGET_AVX512 static inline struct dd8 quick_two_sum8(__m512d a, __m512d b)
+{
+    struct dd8 r;
+    r.hi = _mm512_add_pd(a, b);
+    r.lo = _mm512_sub_pd(b, _mm512_sub_pd(r.hi, a));
+    return r;
+}
+
+TARGET_AVX512 static inline struct dd8 dd8_add(struct dd8 a, struct dd8 b)
+{
+    __m512d e, f;
+    __m512d s = two_sum8(a.hi, b.hi, &e);
+    __m512d t = two_sum8(a.lo, b.lo, &f);
+    struct dd8 r = quick_two_sum8(s, _mm512_add_pd(e, t));
+    return quick_two_sum8(r.hi, _mm512_add_pd(r.lo, f));
+}
+
+TARGET_AVX512 static inline struct dd8 dd8_sub(struct dd8 a, struct dd8 b)
+{
+    b.hi = _mm512_sub_pd(_mm512_setzero_pd(), b.hi);
+    b.lo = _mm512_sub_pd(_mm512_setzero_pd(), b.lo);
+    return dd8_add(a, b);
+}
+
+TARGET_AVX512 static inline struct dd8 dd8_mul(struct dd8 a, struct dd8 b)
+{
+    __m512d p = _mm512_mul_pd(a.hi, b.hi);
+    __m512d e = _mm512_fmsub_pd(a.hi, b.hi, p);
+    e = _mm512_fmadd_pd(a.hi, b.lo, e);
+    e = _mm512_fmadd_pd(a.lo, b.hi, e);
+    return quick_two_sum8(p, e);
+}
+
+TARGET_AVX512 static inline struct dd8 dd8_sqr(struct dd8 a)
+{
+    __m512d p = _mm512_mul_pd(a.hi, a.hi);
+    __m512d e = _mm512_fmsub_pd(a.hi, a.hi, p);
+    e = _mm512_fmadd_pd(_mm512_add_pd(a.hi, a.hi), a.lo, e);
+    return quick_two_sum8(p, e);
+}
+
+TARGET_AVX512 static inline struct dd8 dd8_load(const double* hi, const double* lo, __mmask8 mask)
+{
+    struct dd8 r = { _mm512_maskz_loadu_pd(mask, hi), _mm512_maskz_loadu_pd(mask, lo) };
+    return r;
+}
+
+TARGET_AVX512 void iterateDoubleDoubleAVX512(struct MandelPoint* points, int first, int numPoints, int iterations)
+{
+    const __m512d four = _mm512_set1_pd(4.0);
+    const __m512d one = _mm512_set1_pd(1.0);
+    dd_real center_re = qd_to_dd(points->center_re);
+    dd_real center_im = qd_to_dd(points->center_im);
+    struct dd8 center_re8 = { _mm512_set1_pd(center_re.hi), _mm512_set1_pd(center_re.lo) };
+    struct dd8 center_im8 = { _mm512_set1_pd(center_im.hi), _mm512_set1_pd(center_im.lo) };
+    int end = first + numPoints;
+
+    for (int p = first; p < end; p += 8) {
+        __mmask8 inRange = end - p >= 8 ? 0xFF : (__mmask8)((1u << (end - p)) - 1);
+        __m512d div = load_u32(points->diverged + p, inRange);
+        __mmask8 active = _mm512_mask_cmp_pd_mask(inRange, div, _mm512_setzero_pd(), _CMP_EQ_OQ);
+        if (!active)
+            continue;
+
+        struct dd8 offset_re = { _mm512_maskz_loadu_pd(inRange, points->c_re + p), _mm512_setzero_pd() };
+        struct dd8 offset_im = { _mm512_maskz_loadu_pd(inRange, points->c_im + p), _mm512_setzero_pd() };
+        struct dd8 cr = dd8_add(center_re8, offset_re);
+        struct dd8 ci = dd8_add(center_im8, offset_im);
+        struct dd8 zr = dd8_load(points->z_re + p, points->z_re_tail[0] + p, inRange);
+        struct dd8 zi = dd8_load(points->z_im + p, points->z_im_tail[0] + p, inRange);
+        __m512d n = load_u32(points->iterations + p, inRange);
+        struct dd8 zr_out = zr;
+        struct dd8 zi_out = zi;
+
+        for (int i = iterations; i--;) {
+            struct dd8 zr2 = dd8_sqr(zr);
+            struct dd8 zi2 = dd8_sqr(zi);
+            struct dd8 zri = dd8_mul(zr, zi);
+            zri.hi = _mm512_add_pd(zri.hi, zri.hi);
+            zri.lo = _mm512_add_pd(zri.lo, zri.lo);
+            zi = dd8_add(zri, ci);
+            zr = dd8_add(dd8_sub(zr2, zi2), cr);
+            __m512d abs2 = _mm512_fmadd_pd(zr.hi, zr.hi, _mm512_mul_pd(zi.hi, zi.hi));
+            __mmask8 escaped = _mm512_mask_cmp_pd_mask(active, abs2, four, _CMP_GT_OQ);
+            div = _mm512_mask_mov_pd(div, escaped, _mm512_add_pd(n, one));
+            zr_out.hi = _mm512_mask_mov_pd(zr_out.hi, escaped, zr.hi);
+            zr_out.lo = _mm512_mask_mov_pd(zr_out.lo, escaped, zr.lo);
+            zi_out.hi = _mm512_mask_mov_pd(zi_out.hi, escaped, zi.hi);
+            zi_out.lo = _mm512_mask_mov_pd(zi_out.lo, escaped, zi.lo);
+            active &= ~escaped;
+            n = _mm512_mask_add_pd(n, active, n, one);
+            if (!active)
+                break;
+        }
+
+        _mm512_mask_storeu_pd(points->z_re + p, inRange, _mm512_mask_mov_pd(zr_out.hi, active, zr.hi));
+        _mm512_mask_storeu_pd(points->z_re_tail[0] + p, inRange, _mm512_mask_mov_pd(zr_out.lo, active, zr.lo));
+        _mm512_mask_storeu_pd(points->z_im + p, inRange, _mm512_mask_mov_pd(zi_out.hi, active, zi.hi));
+        _mm512_mask_storeu_pd(points->z_im_tail[0] + p, inRange, _mm512_mask_mov_pd(zi_out.lo, active, zi.lo));
+        store_u32(points->iterations + p, inRange, n);
+        store_u32(points->diverged + p, inRange, div);
+    }
+}
+
+#endif /* MANDELKERNEL_X86 */
@@ -0,0 +1,95 @@
+/*  Filename:  mandelkernel_extended.c
+ *
+ *  Author:    mandex contributors
+ *  Copyright: (c) 2026 mandex contributors. All rights reserved.
+ *             This work is licensed under the terms of the MIT license.
+ */
+
+#include "mandelkernel.h"
+#include "dd_real.h"
+#include "qd_real.h"
+
+// Scalar kernels in double-double and quad-double precision.
+// They are used on cpus without AVX2 (double-double) and for zoom
+// levels beyond double-double (quad-double, not vectorised).
+
+void iterateDoubleDoubleScalar(struct MandelPoint* points, int first, int numPoints, int iterations)
+{
+    dd_real center_re = qd_to_dd(points->center_re);
+    dd_real center_im = qd_to_dd(points->center_im);
+
+    for (int p = first; p < first + numPoints; ++p) {
+        if (points->diverged[p])
+            continue;
+
+        int i = iterations;
+        dd_real cr = dd_add_d(center_re, points->c_re[p]);
+        dd_real ci = dd_add_d(center_im, points->c_im[p]);
+        dd_real zr = { points->z_re[p], points->z_re_tail[0][p] };
+        dd_real zi = { points->z_im[p], points->z_im_tail[0][p] };
+        uint32_t n = points->iterations[p];
+
+        while (i--) {
+            dd_real zr2 = dd_sqr(zr);
+            dd_real zi2 = dd_sqr(zi);
+            zi = dd_add(dd_mul_pwr2(dd_mul(zr, zi), 2.0), ci);
+            zr = dd_add(dd_sub(zr2, zi2), cr);
+            if (zr.hi * zr.hi + zi.hi * zi.hi > 4.0) {
+                points->diverged[p] = n + 1;
+                break;
+            }
+            else
+                ++n;
+        }
+        points->z_re[p] = zr.hi;
+        points->z_re_tail[0][p] = zr.lo;
+        points->z_im[p] = zi.hi;
+        points->z_im_tail[0][p] = zi.lo;
+        points->iterations[p] = n;
+    }
+}
+
+static inline qd_real loadQD(const double* lane, double* tail[3], int p)
+{
+    qd_real r = {{ lane[p], tail[0][p], tail[1][p], tail[2][p] }};
+    return r;
+}
+
+static inline void storeQD(double* lane, double* tail[3], int p, qd_real v)
+{
+    lane[p] = v.x[0];
+    tail[0][p] = v.x[1];
+    tail[1][p] = v.x[2];
+    tail[2][p] = v.x[3];
+}
+
+void iterateQuadDoubleScalar(struct MandelPoint* points, int first, int numPoints, int iterations)
+{
+    for (int p = first; p < first + numPoints; ++p) {
+        if (points->diverged[p])
+            continue;
+
+        int i = iterations;
+        qd_real cr = qd_add_d(points->center_re, points->c_re[p]);
+        qd_real ci = qd_add_d(points->center_im, points->c_im[p]);
+        qd_real zr = loadQD(points->z_re, points->z_re_tail, p);
+        qd_real zi = loadQD(points->z_im, points->z_im_tail, p);
+        uint32_t n = points->iterations[p];
+
+        while (i--) {
+            qd_real zr2 = qd_sqr(zr);
+            qd_real zi2 = qd_sqr(zi);
+            zi = qd_add(qd_mul_pwr2(qd_mul(zr, zi), 2.0), ci);
+            zr = qd_add(qd_sub(zr2, zi2), cr);
+            if (zr.x[0] * zr.x[0] + zi.x[0] * zi.x[0] > 4.0) {
+                points->diverged[p] = n + 1;
+                break;
+            }
+            else
+                ++n;
+        }
+        storeQD(points->z_re, points->z_re_tail, p, zr);
+        storeQD(points->z_im, points->z_im_tail, p, zi);
+        points->iterations[p] = n;
+    }
+}
@@ -0,0 +1,71 @@
+/*  Filename:  mandelkernel_perturbation.c
+ *
+ *  Author:    mandex contributors
+ *  Copyright: (c) 2026 mandex contributors. All rights reserved.
+ *             This work is licensed under the terms of the MIT license.
+ */
+
+#include "mandelkernel.h"
+
+// Scalar kernel for perturbation. Every point iterates its difference dz
+// to the orbit Z of its reference: dz' = (2Z + dz) * dz + dc
+
+int iteratePerturbationScalar(struct MandelPoint* points, int first, int numPoints, int iterations)
+{
+    const struct MandelReferences* refs = points->references;
+    int glitched = 0;
+
+    for (int p = first; p < first + numPoints; ++p) {
+        uint8_t r = points->reference[p];
+        if (points->diverged[p] || (r & REFERENCE_GLITCHED))
+            continue;
+
+        const struct ReferenceOrbit* orbit = refs->orbit[r];
+        const double* Zr = orbit->z_re;
+        const double* Zi = orbit->z_im;
+        uint32_t length = orbit->length;
+        double dcr = points->c_re[p] - refs->offset_re[r];
+        double dci = points->c_im[p] - refs->offset_im[r];
+        double dzr = points->z_re[p];
+        double dzi = points->z_im[p];
+        uint32_t n = points->iterations[p];
+
+        for (int i = iterations; i--;) {
+            if (n >= length) {
+                // The reference escaped before this point, another one must continue.
+                // Else the orbit is as long as the budget, which the point used up.
+                if (orbit->escaped) {
+                    points->reference[p] = r | REFERENCE_GLITCHED;
+                    ++glitched;
+                }
+                else {
+                    points->diverged[p] = MANDEL_INTERIOR;
+                }
+                break;
+            }
+            double tr = 2.0 * Zr[n] + dzr;
+            double ti = 2.0 * Zi[n] + dzi;
+            double nr = tr * dzr - ti * dzi + dcr;
+            dzi = tr * dzi + ti * dzr + dci;
+            dzr = nr;
+
+            double zr = Zr[n + 1] + dzr;
+            double zi = Zi[n + 1] + dzi;
+            double abs2 = zr * zr + zi * zi;
+            if (abs2 > 4.0) {
+                points->diverged[p] = n + 1;
+                break;
+            }
+            ++n;
+            if (abs2 < GLITCH_TOLERANCE * (Zr[n] * Zr[n] + Zi[n] * Zi[n])) {
+                points->reference[p] = r | REFERENCE_GLITCHED;
+                ++glitched;
+                break;
+            }
+        }
+        points->z_re[p] = dzr;
+        points->z_im[p] = dzi;
+        points->iterations[p] = n;
+    }
+    return glitched;
+}
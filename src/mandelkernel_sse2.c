@@ -0,0 +1,151 @@
+/*  Filename:  mandelkernel_sse2.c
+ *
+ *  Author:    mandex contributors
+ *  Copyright: (c) 2026 mandex contributors. All rights reserved.
+ *             This work is licensed under the terms of the MIT license.
+ */
+
+#include "mandelkernel.h"
+
+#ifdef MANDELKERNEL_X86
+
+#include <immintrin.h>
+
+#define TARGET_SSE2 __attribute__((target("sse2")))
+
+// SSE2 has no blend instruction
+TARGET_SSE2 static inline __m128d select_pd(__m128d mask, __m128d a, __m128d b)
+{
+    return _mm_or_pd(_mm_and_pd(mask, b), _mm_andnot_pd(mask, a));
+}
+
+TARGET_SSE2 void iterateDoubleSSE2(struct MandelPoint* points, int first, int numPoints, int iterations)
+{
+    const __m128d four = _mm_set1_pd(4.0);
+    const __m128d one = _mm_set1_pd(1.0);
+    const __m128d interior = _mm_set1_pd(-1.0);    // all bits set as int32, MANDEL_INTERIOR
+    const __m128d eps = _mm_set1_pd(points->cycleEpsilon);
+    int end = first + numPoints;
+    int p = first;
+
+    for (; p + 2 <= end; p += 2) {
+        __m128d div = _mm_cvtepi32_pd(_mm_loadl_epi64((const __m128i*)(points->diverged + p)));
+        __m128d active = _mm_cmpeq_pd(div, _mm_setzero_pd());
+        if (!_mm_movemask_pd(active))
+            continue;
+
+        startCycleCheck(points, p, 2, iterations);
+        __m128d sr = _mm_loadu_pd(points->zs_re + p);
+        __m128d si = _mm_loadu_pd(points->zs_im + p);
+        __m128d cr = _mm_loadu_pd(points->c_re + p);
+        __m128d ci = _mm_loadu_pd(points->c_im + p);
+        __m128d zr = _mm_loadu_pd(points->z_re + p);
+        __m128d zi = _mm_loadu_pd(points->z_im + p);
+        __m128d n = _mm_cvtepi32_pd(_mm_loadl_epi64((const __m128i*)(points->iterations + p)));
+        __m128d zr2 = _mm_mul_pd(zr, zr);
+        __m128d zi2 = _mm_mul_pd(zi, zi);
+        __m128d zr_out = zr;
+        __m128d zi_out = zi;
+
+        for (int i = iterations; i--;) {
+            zi = _mm_add_pd(_mm_mul_pd(_mm_add_pd(zr, zr), zi), ci);
+            zr = _mm_add_pd(_mm_sub_pd(zr2, zi2), cr);
+            zr2 = _mm_mul_pd(zr, zr);
+            zi2 = _mm_mul_pd(zi, zi);
+            __m128d escaped = _mm_and_pd(_mm_cmpgt_pd(_mm_add_pd(zr2, zi2), four), active);
+            div = select_pd(escaped, div, _mm_add_pd(n, one));
+            zr_out = select_pd(escaped, zr_out, zr);
+            zi_out = select_pd(escaped, zi_out, zi);
+            active = _mm_andnot_pd(escaped, active);
+            n = _mm_add_pd(n, _mm_and_pd(active, one));
+            __m128d dr = _mm_sub_pd(zr, sr);
+            __m128d di = _mm_sub_pd(zi, si);
+            __m128d cycle = _mm_and_pd(_mm_cmplt_pd(_mm_add_pd(_mm_mul_pd(dr, dr), _mm_mul_pd(di, di)), eps), active);
+            div = select_pd(cycle, div, interior);
+            active = _mm_andnot_pd(cycle, active);
+            if (!_mm_movemask_pd(active))
+                break;
+        }
+
+        _mm_storeu_pd(points->z_re + p, select_pd(active, zr_out, zr));
+        _mm_storeu_pd(points->z_im + p, select_pd(active, zi_out, zi));
+        _mm_storel_epi64((__m128i*)(points->iterations + p), _mm_cvttpd_epi32(n));
+        _mm_storel_epi64((__m128i*)(points->diverged + p), _mm_cvttpd_epi32(div));
+    }
+    iterateDoubleScalar(points, p, end - p, iterations);
+}
+
+TARGET_SSE2 static inline __m128 select_ps(__m128 mask, __m128 a, __m128 b)
+{
+    return _mm_or_ps(_mm_and_ps(mask, b), _mm_andnot_ps(mask, a));
+}
+
+TARGET_SSE2 static inline __m128 load_ps(const double* src)
+{
+    return _mm_movelh_ps(_mm_cvtpd_ps(_mm_loadu_pd(src)), _mm_cvtpd_ps(_mm_loadu_pd(src + 2)));
+}
+
+TARGET_SSE2 static inline void store_ps(double* dst, __m128 v)
+{
+    _mm_storeu_pd(dst, _mm_cvtps_pd(v));
+    _mm_storeu_pd(dst + 2, _mm_cvtps_pd(_mm_movehl_ps(v, v)));
+}
+
+TARGET_SSE2 void iterateFloatSSE2(struct MandelPoint* points, int first, int numPoints, int iterations)
+{
+    const __m128 four = _mm_set1_ps(4.0f);
+    const __m128i one = _mm_set1_epi32(1);
+    const __m128 eps = _mm_set1_ps((float)points->cycleEpsilon);
+    const __m128i interior = _mm_set1_epi32((int)MANDEL_INTERIOR);
+    int end = first + numPoints;
+    int p = first;
+
+    for (; p + 4 <= end; p += 4) {
+        // iteration counts stay integers, float can't count beyond 2^24
+        __m128i div = _mm_loadu_si128((const __m128i*)(points->diverged + p));
+        __m128 active = _mm_castsi128_ps(_mm_cmpeq_epi32(div, _mm_setzero_si128()));
+        if (!_mm_movemask_ps(active))
+            continue;
+
+        startCycleCheck(points, p, 4, iterations);
+        __m128 sr = load_ps(points->zs_re + p);
+        __m128 si = load_ps(points->zs_im + p);
+        __m128 cr = load_ps(points->c_re + p);
+        __m128 ci = load_ps(points->c_im + p);
+        __m128 zr = load_ps(points->z_re + p);
+        __m128 zi = load_ps(points->z_im + p);
+        __m128i n = _mm_loadu_si128((const __m128i*)(points->iterations + p));
+        __m128 zr2 = _mm_mul_ps(zr, zr);
+        __m128 zi2 = _mm_mul_ps(zi, zi);
+        __m128 zr_out = zr;
+        __m128 zi_out = zi;
+
+        for (int i = iterations; i--;) {
+            zi = _mm_add_ps(_mm_mul_ps(_mm_add_ps(zr, zr), zi), ci);
+            zr = _mm_add_ps(_mm_sub_ps(zr2, zi2), cr);
+            zr2 = _mm_mul_ps(zr, zr);
+            zi2 = _mm_mul_ps(zi, zi);
+            __m128 escaped = _mm_and_ps(_mm_cmpgt_ps(_mm_add_ps(zr2, zi2), four), active);
+            div = _mm_castps_si128(select_ps(escaped, _mm_castsi128_ps(div), _mm_castsi128_ps(_mm_add_epi32(n, one))));
+            zr_out = select_ps(escaped, zr_out, zr);
+            zi_out = select_ps(escaped, zi_out, zi);
+            active = _mm_andnot_ps(escaped, active);
+            n = _mm_sub_epi32(n, _mm_castps_si128(active));  // mask is -1 for active lanes
+            __m128 dr = _mm_sub_ps(zr, sr);
+            __m128 di = _mm_sub_ps(zi, si);
+            __m128 cycle = _mm_and_ps(_mm_cmplt_ps(_mm_add_ps(_mm_mul_ps(dr, dr), _mm_mul_ps(di, di)), eps), active);
+            div = _mm_castps_si128(select_ps(cycle, _mm_castsi128_ps(div), _mm_castsi128_ps(interior)));
+            active = _mm_andnot_ps(cycle, active);
+            if (!_mm_movemask_ps(active))
+                break;
+        }
+
+        store_ps(points->z_re + p, select_ps(active, zr_out, zr));
+        store_ps(points->z_im + p, select_ps(active, zi_out, zi));
+        _mm_storeu_si128((__m128i*)(points->iterations + p), n);
+        _mm_storeu_si128((__m128i*)(points->diverged + p), div);
+    }
+    iterateFloatScalar(points, p, end - p, iterations);
+}
+
+#endif /* MANDELKERNEL_X86 */
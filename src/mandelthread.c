@@ -9,70 +9,523 @@
 #include <SDL2/SDL.h>
 #include "mandelbrot.h"
 #include "screen_xy.h"
+#include "perturbation.h"
+#include "tilequeue.h"
+#include "tilecache.h"
+#include "tileframes.h"
 
 // Two buffers of MandelPoint so one can get initialised to new
 // values while threads still run on the other
 MandelPoint* mandel_front;
 MandelPoint* mandel_back;
 int numMandelPoints;
+int screenWidth;
+int screenHeight;
 
 // For each cpu core one thread is spawned which calculates the mandelbrot set
 SDL_Thread** threads;
 int numThreads;
 
+// Threads take the tiles of the screen from here
+TileQueue* tileQueue;
+
 // Threads work on this data
 struct ThreadData {
-    MandelPoint* points;
-    int numPoints;
-    int run;        //thread stops if this is zero
+    int index;      // index of the queue of the thread
 };
 struct ThreadData* workData;
 
+// The first thread which takes a tile of a new view creates the references,
+// glitch correction adds more. They are shared by all threads.
+SDL_mutex* glitchLock;
+
+// Epoch of the view the points were last set up for
+SDL_atomic_t readyEpoch;
+
+// Iteration budget, MANDEL_ITERATIONS_AUTO scales it with the zoom depth
+uint32_t maxIterations = MANDEL_ITERATIONS_AUTO;
+
+// Render by subdivision instead of calculating every point. Changes
+// apply to the next view, the threads read the mode of the current one.
+int subdivide = 0;
+SDL_atomic_t subdivideView;
+
+// Tiles are done once their points in every stride-th row and column are,
+// like subdivide set for the next view and read by the threads for the current one
+int motionStride = 1;
+SDL_atomic_t motionStrideView;
+
+// Parts of the views the user will likely change to next: the strips a move
+// in each direction brings into view and the center of the next zoom. They
+// are calculated with background tiles while the threads have nothing else
+// to do, the threads take the points which lie on the new view when they take
+// over its tiles. The background tiles of a view are queued once all of its
+// tiles were taken over, and the first one prepares the points for the part.
+enum { SPECULATE_RIGHT, SPECULATE_LEFT, SPECULATE_DOWN, SPECULATE_UP, SPECULATE_ZOOM, NUM_SPECULATIONS };
+struct SpeculationView {
+    struct ScreenXY part;
+    enum MandelPrecision precision;     // of the whole view, else the part couldn't be merged
+    uint32_t maxIterations;
+};
+struct Speculation {
+    MandelPoint* points;        // NULL if allocation failed
+    struct SpeculationView next;    // set with the view, used when its background tiles are queued
+    struct SpeculationView view;    // the background tiles calculate
+    SDL_atomic_t preparedEpoch; // background epoch the points were prepared for, -1 before the first
+    SDL_atomic_t readyEpoch;    // background epoch the points were set up for
+};
+struct Speculation speculations[NUM_SPECULATIONS];
+
+// Epoch of the queue in which the threads last waited for the background tiles of the speculations
+SDL_atomic_t settledEpoch;
+
+// Rates of the moves and zooms which are calculated in advance, 0 for none
+double speculateMove = 0.0;
+double speculateZoom = 0.0;
+
+// Results of views before the current one. The threads store the last view
+// and look up the current one tile by tile while they hold the lock.
+TileCache* tileCache;
+SDL_mutex* cacheLock;
+size_t cacheBudget = 64 << 20;
+
+// Keeps the tiles of the cache across sessions, only results calculated without guessing
+TileStore* tileStore;
+const char* storePath;
+
+// The threads draw the points of the screen to these frames, with a copy of
+// the palette of the caller. The version counts changes of the palette.
+TileFrames* tileFrames;
+struct ColorPalette drawPalette;
+SDL_atomic_t paletteVersion;
+SDL_mutex* paletteLock;
+
+// One lock for each tile of the frames. A tile is drawn while it is locked and
+// only if the view and palette are still current, so a tile drawn with older
+// ones never covers one drawn with the current ones.
+SDL_SpinLock* drawLocks;
+int frameTilesX;
+
+// The first thread which draws or initialises a tile of the screen takes over
+// what the last view has for it, so the main thread doesn't go through the whole
+// screen at every change of the view. One lock for each tile of the screen, held
+// while it is taken over, and the epoch of the queue it was last taken over in.
+SDL_SpinLock* takeOverLocks;
+int* takeOverEpochs;
+int screenTilesX;
+int numScreenTiles;
+SDL_atomic_t takenOver;     // tiles of the screen taken over for the view
+
+// What the tiles of the view take over, set before they are queued. The points
+// of the last view are read until all tiles of the view were waited for.
+MandelPoint* lastView;
+int shiftView;          // the view moved by whole pixels, the points on both keep their results
+int reprojectView;      // the last view is shown until the points have a result
+int reuseView;          // the last view, if any, is stored in the cache, the cache and speculations are merged
+
+// Points which are done are removed from the live points every few passes
+#define COMPACT_PASSES 4
+
+// A tile goes back to the queue after this many passes, so tiles further
+// out get their turn instead of waiting behind an expensive one
+#define TILE_PASSES 16
+
+// A tile which is returned is split if less than this fraction of its points were done
+#define SPLIT_FRACTION 4
+
+// Reference orbits take up to the whole budget of iterations. They are given
+// up once their tile is stale, so the lock isn't held for a view of the past.
+static int cancelReference(const void* tile)
+{
+    return isTileStale(tileQueue, tile);
+}
+
+static void iteratePoints(const struct Tile* tile, MandelPoint* points, int first, int numPoints)
+{
+    if (iterateMandelbrot(points, first, numPoints, 100)) {
+        SDL_LockMutex(glitchLock);
+        correctGlitches(points, first, numPoints, cancelReference, tile);
+        SDL_UnlockMutex(glitchLock);
+    }
+}
+
+// Sets up the points of a tile once, unless the view changed already. Returns 0 if so.
+static int setupView(const struct Tile* tile, MandelPoint* points, SDL_atomic_t* epoch)
+{
+    int ready = 1;
+    if (SDL_AtomicGet(epoch) != tile->epoch) {
+        SDL_LockMutex(glitchLock);
+        if (isTileStale(tileQueue, tile)) {
+            ready = 0;
+        }
+        else if (SDL_AtomicGet(epoch) != tile->epoch) {
+            ready = setupMandelbrot(points, cancelReference, tile);
+            if (ready)
+                SDL_AtomicSet(epoch, tile->epoch);
+        }
+        SDL_UnlockMutex(glitchLock);
+    }
+    return ready;
+}
+
+// Prepares the points of a speculation for its part once, unless the view changed already. Returns 0 if so.
+static int prepareSpeculation(const struct Tile* tile, struct Speculation* speculation)
+{
+    int ready = 1;
+    if (SDL_AtomicGet(&speculation->preparedEpoch) != tile->epoch) {
+        SDL_LockMutex(glitchLock);
+        if (isTileStale(tileQueue, tile)) {
+            ready = 0;
+        }
+        else if (SDL_AtomicGet(&speculation->preparedEpoch) != tile->epoch) {
+            const struct SpeculationView* view = &speculation->view;
+            prepareMandelbrot(speculation->points, &view->part, view->precision, view->maxIterations);
+            SDL_AtomicSet(&speculation->preparedEpoch, tile->epoch);
+        }
+        SDL_UnlockMutex(glitchLock);
+    }
+    return ready;
+}
+
+// Background tiles of the last view may still be calculated when the view changes.
+// The speculations are merged and prepared again only once they stopped.
+static void settleSpeculations(const struct Tile* tile)
+{
+    if (SDL_AtomicGet(&settledEpoch) == tile->epoch)
+        return;
+    for (int i = 0; i < NUM_SPECULATIONS; ++i)
+        waitForTiles(tileQueue, &speculations[i]);
+    SDL_AtomicSet(&settledEpoch, tile->epoch);
+}
+
+// Queues the background tiles of the speculations of the view. Their points are
+// not merged any more, all tiles of the screen were taken over.
+static void queueSpeculations(const struct Tile* tile)
+{
+    if (isTileStale(tileQueue, tile))
+        return;
+    for (int i = 0; i < NUM_SPECULATIONS; ++i) {
+        struct Speculation* speculation = &speculations[i];
+        if (!speculation->points)
+            continue;
+        speculation->view = speculation->next;
+        addBackgroundTiles(tileQueue, speculation, speculation->view.part.width, speculation->view.part.height);
+    }
+}
+
+// Takes over the tiles of the screen which overlap rect, unless they were
+// already for the view of the tile
+static void takeOverTiles(const struct Tile* tile, const struct MandelTile* rect)
+{
+    settleSpeculations(tile);
+    int lastY = (rect->y + rect->height - 1) / TILE_SIZE;
+    int lastX = (rect->x + rect->width - 1) / TILE_SIZE;
+    for (int ty = rect->y / TILE_SIZE; ty <= lastY; ++ty) {
+        for (int tx = rect->x / TILE_SIZE; tx <= lastX; ++tx) {
+            int index = ty * screenTilesX + tx;
+            SDL_AtomicLock(&takeOverLocks[index]);
+            if (takeOverEpochs[index] != tile->epoch) {
+                struct MandelTile part = {tx * TILE_SIZE, ty * TILE_SIZE, TILE_SIZE, TILE_SIZE};
+                if (part.width > screenWidth - part.x)
+                    part.width = screenWidth - part.x;
+                if (part.height > screenHeight - part.y)
+                    part.height = screenHeight - part.y;
+                if (shiftView)
+                    shiftMandelTile(tile->data, lastView, &part);
+                else if (reprojectView)
+                    reprojectMandelTile(tile->data, lastView, &part);
+                for (int i = 0; reuseView && i < NUM_SPECULATIONS; ++i) {
+                    if (speculations[i].points && SDL_AtomicGet(&speculations[i].preparedEpoch) >= 0)
+                        mergeMandelTile(tile->data, speculations[i].points, &part);
+                }
+                if (tileCache && reuseView) {
+                    SDL_LockMutex(cacheLock);
+                    if (lastView)
+                        storeCacheTiles(tileCache, lastView, &part);
+                    loadCacheTiles(tileCache, tile->data, &part);
+                    SDL_UnlockMutex(cacheLock);
+                }
+                takeOverEpochs[index] = tile->epoch;
+                if (SDL_AtomicAdd(&takenOver, 1) == numScreenTiles - 1)
+                    queueSpeculations(tile);
+            }
+            SDL_AtomicUnlock(&takeOverLocks[index]);
+        }
+    }
+}
+
+// Takes over the points a tile is drawn with, mirrored rows are drawn with the rows they mirror
+static void takeOverDrawn(const struct Tile* tile)
+{
+    struct MandelTile source;
+    takeOverTiles(tile, &tile->rect);
+    if (mirroredMandelSource(tile->data, &tile->rect, &source))
+        takeOverTiles(tile, &source);
+}
+
+// Iterates a copy of the points of a tile which are not done yet, so the
+// work shrinks as points diverge. Returns the number of points not done,
+// -1 if the view changed meanwhile.
+static int iterateLive(const struct Tile* tile, MandelPoint* live, uint32_t* index, int numLive)
+{
+    MandelPoint* points = tile->data;
+    for (int pass = 1; numLive && pass <= TILE_PASSES; ++pass) {
+        if (isTileStale(tileQueue, tile))
+            return -1;
+        iteratePoints(tile, live, 0, numLive);
+        if (pass % COMPACT_PASSES == 0)
+            numLive = compactMandelPoints(points, live, index, numLive);
+    }
+    return scatterMandelPoints(points, live, index, numLive);
+}
+
+// Iterates the rows of a tile in place, if the copy can't be allocated
+static int iterateInPlace(const struct Tile* tile)
+{
+    MandelPoint* points = tile->data;
+    const struct MandelTile* rect = &tile->rect;
+    for (int pass = 0; pass < TILE_PASSES; ++pass) {
+        if (isTileStale(tileQueue, tile))
+            return -1;
+        for (int y = rect->y; y < rect->y + rect->height; ++y)
+            iteratePoints(tile, points, y * screenWidth + rect->x, rect->width);
+    }
+
+    int remaining = 0;
+    for (int y = rect->y; y < rect->y + rect->height; ++y)
+        remaining += countLiveMandelPoints(points, y * screenWidth + rect->x, rect->width);
+    return remaining;
+}
+
+// Calculates the border of a tile and fills the tile if the border has one result.
+// Returns 0 if the tile is done, 1 if it must be split, -1 if the view changed.
+static int guessTile(const struct Tile* tile, MandelPoint* live, uint32_t* index)
+{
+    MandelPoint* points = tile->data;
+    int numLive = gatherMandelBorder(live, index, points, &tile->rect);
+    if (numLive < 0)
+        return 1;
+    for (int pass = 1; numLive; ++pass) {
+        if (isTileStale(tileQueue, tile))
+            return -1;
+        iteratePoints(tile, live, 0, numLive);
+        if (pass % COMPACT_PASSES == 0)
+            numLive = compactMandelPoints(points, live, index, numLive);
+    }
+
+    uint32_t value;
+    if (!uniformMandelBorder(points, &tile->rect, &value))
+        return 1;
+    fillMandelTile(points, &tile->rect, value);
+    return 0;
+}
+
+// Draws the part of a tile which lies in one tile of the frames after the other
+static void drawPart(const struct Tile* tile, const struct MandelTile* rect,
+                     const struct ColorPalette* palette, int version)
+{
+    int lastY = (rect->y + rect->height - 1) / FRAME_TILE_SIZE;
+    int lastX = (rect->x + rect->width - 1) / FRAME_TILE_SIZE;
+    for (int ty = rect->y / FRAME_TILE_SIZE; ty <= lastY; ++ty) {
+        for (int tx = rect->x / FRAME_TILE_SIZE; tx <= lastX; ++tx) {
+            int left = tx * FRAME_TILE_SIZE;
+            int top = ty * FRAME_TILE_SIZE;
+            struct MandelTile part;
+            part.x = left > rect->x ? left : rect->x;
+            part.y = top > rect->y ? top : rect->y;
+            part.width = (left + FRAME_TILE_SIZE < rect->x + rect->width ? left + FRAME_TILE_SIZE : rect->x + rect->width) - part.x;
+            part.height = (top + FRAME_TILE_SIZE < rect->y + rect->height ? top + FRAME_TILE_SIZE : rect->y + rect->height) - part.y;
+
+            SDL_SpinLock* lock = &drawLocks[ty * frameTilesX + tx];
+            SDL_AtomicLock(lock);
+            if (!isTileStale(tileQueue, tile) && SDL_AtomicGet(&paletteVersion) == version) {
+                uint32_t* pixels = drawTileFrame(tileFrames, tx, ty);
+                drawMandelbrot(tile->data, pixels + (part.y - top) * FRAME_TILE_SIZE + (part.x - left),
+                               FRAME_TILE_SIZE, &part, palette);
+                publishTileFrame(tileFrames, tx, ty);
+            }
+            SDL_AtomicUnlock(lock);
+        }
+    }
+}
+
+// Draws the pixels of a tile and of the mirrored rows which show its points
+static void drawTile(const struct Tile* tile)
+{
+    if (isTileStale(tileQueue, tile))
+        return;
+    struct ColorPalette palette;
+    SDL_LockMutex(paletteLock);
+    palette = drawPalette;
+    int version = SDL_AtomicGet(&paletteVersion);
+    SDL_UnlockMutex(paletteLock);
+
+    drawPart(tile, &tile->rect, &palette, version);
+    struct MandelTile image;
+    if (!tile->draw && mirroredMandelTile(tile->data, &tile->rect, &image))
+        drawPart(tile, &image, &palette, version);
+}
+
+// Calculates a background tile of a speculation until it is done, or
+// returns it as soon as there are tiles of the current view
+static void speculateTile(const struct Tile* tile, MandelPoint* live, uint32_t* index, int self)
+{
+    struct Speculation* speculation = tile->data;
+    MandelPoint* points = speculation->points;
+    if (!tile->started) {
+        if (!prepareSpeculation(tile, speculation) || !setupView(tile, points, &speculation->readyEpoch)) {
+            finishTile(tileQueue, self, tile);
+            return;
+        }
+        initMandelTile(points, &tile->rect);
+    }
+
+    int numLive = -1;
+    if (live && index)
+        numLive = gatherMandelPoints(live, index, points, &tile->rect, 1);
+    if (numLive < 0) {
+        finishTile(tileQueue, self, tile);
+        return;
+    }
+
+    for (int pass = 1; numLive && !isTileStale(tileQueue, tile) && !hasQueuedTiles(tileQueue); ++pass) {
+        iteratePoints(tile, live, 0, numLive);
+        if (pass % COMPACT_PASSES == 0)
+            numLive = compactMandelPoints(points, live, index, numLive);
+    }
+
+    if (scatterMandelPoints(points, live, index, numLive) > 0)
+        returnTile(tileQueue, self, tile, 0);
+    else
+        finishTile(tileQueue, self, tile);
+}
+
 // entry point for thread creation
 static int threadFunction(void* data)
 {
     struct ThreadData* trdata = data;
-    while (trdata->run) {
-        iterateMandelbrot(trdata->points, trdata->numPoints, 100);
+
+    MandelPoint* live = createMandelPoint(TILE_SIZE * TILE_SIZE);
+    uint32_t* index = malloc(TILE_SIZE * TILE_SIZE * sizeof(uint32_t));
+    struct Tile tile;
+
+    while (popTile(tileQueue, trdata->index, &tile)) {
+        if (tile.background) {
+            speculateTile(&tile, live, index, trdata->index);
+            continue;
+        }
+        if (tile.draw) {
+            takeOverDrawn(&tile);
+            drawTile(&tile);
+            finishTile(tileQueue, trdata->index, &tile);
+            continue;
+        }
+        MandelPoint* points = tile.data;
+
+        // points are initialised by the first thread which takes their tile
+        int first = !tile.started;
+        if (first) {
+            takeOverDrawn(&tile);
+            if (!setupView(&tile, points, &readyEpoch)) {
+                finishTile(tileQueue, trdata->index, &tile);
+                continue;
+            }
+            initMandelTile(points, &tile.rect);
+        }
+
+        // the progressive passes need the copy, without it all points are calculated at once
+        int stride = live && index ? tile.stride : 1;
+
+        // by subdivision tiles are split until their border has one result or they are small
+        if (stride == 1 && SDL_AtomicGet(&subdivideView) && live && index
+            && (tile.rect.width > MIN_TILE_SIZE || tile.rect.height > MIN_TILE_SIZE)) {
+            if (guessTile(&tile, live, index) > 0) {
+                returnTile(tileQueue, trdata->index, &tile, 1);
+            }
+            else {
+                drawTile(&tile);
+                finishTile(tileQueue, trdata->index, &tile);
+            }
+            continue;
+        }
+
+        int numLive = -1;
+        if (live && index)
+            numLive = gatherMandelPoints(live, index, points, &tile.rect, stride);
+
+        int before = numLive;
+        int remaining;
+        if (numLive < 0) {
+            before = tile.rect.width * tile.rect.height;
+            remaining = iterateInPlace(&tile);
+        }
+        else {
+            remaining = iterateLive(&tile, live, index, numLive);
+        }
+
+        // the tile is drawn if points are done, stale tiles are dropped. On the first pass
+        // it is drawn in any case for the points done by initialising them, e.g. the interior.
+        // A tile whose points hardly escape is expensive and others can help with its parts.
+        if (remaining < before || first)
+            drawTile(&tile);
+        if (remaining > 0)
+            returnTile(tileQueue, trdata->index, &tile, (before - remaining) * SPLIT_FRACTION < before);
+        else if (stride > SDL_AtomicGet(&motionStrideView))
+            refineTile(tileQueue, trdata->index, &tile);
+        else
+            finishTile(tileQueue, trdata->index, &tile);
     }
+
+    freeMandelPoint(live);
+    free(index);
     return 0;
 }
 
 static void initThreadData()
 {
-    MandelPoint* mp = mandel_front;
-    int allPoints = numMandelPoints;
-    int thrdPoints = numMandelPoints / numThreads;
-    for (int i = 0; i < numThreads - 1; ++i) {
-        workData[i].numPoints = thrdPoints;
-        allPoints -= thrdPoints;
-        workData[i].points = mp;
-        mp = indexMandelPoint(mp, thrdPoints);
-        workData[i].run = 1;
-    }
-    workData[numThreads - 1].numPoints = allPoints; // in case numPoints is not divisible by numThreads
-    workData[numThreads - 1].points = mp;
-    workData[numThreads - 1].run = 1;
+    for (int i = 0; i < numThreads; ++i)
+        workData[i].index = i;
 }
 
-static void stopThread(int index)
+static void stopThreads(int num)
 {
-    workData[index].run = 0;
-    SDL_WaitThread(threads[index], NULL);
+    stopTileQueue(tileQueue);
+    for (int i = 0; i < num; ++i)
+        SDL_WaitThread(threads[i], NULL);
 }
 
 void mandelthread_quit(void)
 {
-    for (int i = 0; i < numThreads; ++i) {
-        stopThread(i);
+    stopThreads(numThreads);
+
+    // the view on screen and parts of the one before may not be stored yet
+    if (tileCache) {
+        struct MandelTile screen = {0, 0, screenWidth, screenHeight};
+        setTileCacheStore(tileCache, SDL_AtomicGet(&subdivideView) ? NULL : tileStore);
+        storeCacheTiles(tileCache, mandel_back, &screen);
+        storeCacheTiles(tileCache, mandel_front, &screen);
     }
+    closeTileStore(tileStore);
+    tileStore = NULL;
+    freeTileQueue(tileQueue);
     free(threads);
     free(workData);
-    free(mandel_back);
-    free(mandel_front);
+    freeMandelPoint(mandel_back);
+    freeMandelPoint(mandel_front);
+    for (int i = 0; i < NUM_SPECULATIONS; ++i)
+        freeMandelPoint(speculations[i].points);
+    freeTileCache(tileCache);
+    SDL_DestroyMutex(cacheLock);
+    freeReferenceCache();
+    SDL_DestroyMutex(glitchLock);
+    SDL_DestroyMutex(paletteLock);
+    free(drawLocks);
+    free(takeOverLocks);
+    free(takeOverEpochs);
+    freeTileFrames(tileFrames);
 }
 
-static int allocGlobals(void)
+static int allocGlobals(int width, int height)
 {
     mandel_front = createMandelPoint(numMandelPoints);
     if (!mandel_front) {
@@ -81,35 +534,158 @@ static int allocGlobals(void)
 
     mandel_back = createMandelPoint(numMandelPoints);
     if (!mandel_back) {
-        free(mandel_front);
+        freeMandelPoint(mandel_front);
         return 1;
     }
 
     threads = malloc(numThreads * sizeof(SDL_Thread*));
     if (!threads) {
-        free(mandel_front);
-        free(mandel_back);
+        freeMandelPoint(mandel_front);
+        freeMandelPoint(mandel_back);
         return 1;
     }
 
     workData = malloc(numThreads * sizeof(struct ThreadData));
     if (!workData) {
-        free(mandel_front);
-        free(mandel_back);
+        freeMandelPoint(mandel_front);
+        freeMandelPoint(mandel_back);
+        free(threads);
+        return 1;
+    }
+
+    glitchLock = SDL_CreateMutex();
+    if (!glitchLock) {
+        freeMandelPoint(mandel_front);
+        freeMandelPoint(mandel_back);
+        free(threads);
+        free(workData);
+        return 1;
+    }
+
+    paletteLock = SDL_CreateMutex();
+    if (!paletteLock) {
+        freeMandelPoint(mandel_front);
+        freeMandelPoint(mandel_back);
+        free(threads);
+        free(workData);
+        SDL_DestroyMutex(glitchLock);
+        return 1;
+    }
+
+    frameTilesX = (width + FRAME_TILE_SIZE - 1) / FRAME_TILE_SIZE;
+    drawLocks = calloc((size_t)frameTilesX * ((height + FRAME_TILE_SIZE - 1) / FRAME_TILE_SIZE), sizeof(SDL_SpinLock));
+    tileFrames = createTileFrames(width, height);
+    screenTilesX = (width + TILE_SIZE - 1) / TILE_SIZE;
+    numScreenTiles = screenTilesX * ((height + TILE_SIZE - 1) / TILE_SIZE);
+    takeOverLocks = calloc(numScreenTiles, sizeof(SDL_SpinLock));
+    takeOverEpochs = calloc(numScreenTiles, sizeof(int));
+    if (!drawLocks || !tileFrames || !takeOverLocks || !takeOverEpochs) {
+        freeMandelPoint(mandel_front);
+        freeMandelPoint(mandel_back);
         free(threads);
+        free(workData);
+        SDL_DestroyMutex(glitchLock);
+        SDL_DestroyMutex(paletteLock);
+        free(drawLocks);
+        freeTileFrames(tileFrames);
+        free(takeOverLocks);
+        free(takeOverEpochs);
+        return 1;
+    }
+
+    tileQueue = createTileQueue(numThreads, width, height);
+    if (!tileQueue) {
+        freeMandelPoint(mandel_front);
+        freeMandelPoint(mandel_back);
+        free(threads);
+        free(workData);
+        SDL_DestroyMutex(glitchLock);
+        SDL_DestroyMutex(paletteLock);
+        free(drawLocks);
+        freeTileFrames(tileFrames);
+        free(takeOverLocks);
+        free(takeOverEpochs);
         return 1;
     }
     return 0;
 }
 
+// Size of the part of the next view a speculation calculates
+static struct MandelTile speculationRect(int kind, const struct ScreenXY* screen)
+{
+    int moveX = movePixels(screen->width, speculateMove);
+    int moveY = movePixels(screen->height, speculateMove);
+    struct MandelTile rect = {0, 0, screen->width, screen->height};
+    switch (kind) {
+    case SPECULATE_RIGHT:
+        rect.x = screen->width - moveX;
+        rect.width = moveX;
+        break;
+    case SPECULATE_LEFT:
+        rect.width = moveX;
+        break;
+    case SPECULATE_DOWN:
+        rect.y = screen->height - moveY;
+        rect.height = moveY;
+        break;
+    case SPECULATE_UP:
+        rect.height = moveY;
+        break;
+    case SPECULATE_ZOOM:
+        rect.x = screen->width / 4;
+        rect.y = screen->height / 4;
+        rect.width = screen->width / 2;
+        rect.height = screen->height / 2;
+        break;
+    }
+    return rect;
+}
+
+// Speculations which can't be allocated are left out
+static void allocSpeculations(const struct ScreenXY* screen)
+{
+    for (int i = 0; i < NUM_SPECULATIONS; ++i) {
+        int enabled = i == SPECULATE_ZOOM ? speculateZoom > 0.0 : speculateMove > 0.0;
+        struct MandelTile rect = speculationRect(i, screen);
+        speculations[i].points = enabled ? createMandelPoint(rect.width * rect.height) : NULL;
+        SDL_AtomicSet(&speculations[i].preparedEpoch, -1);
+        SDL_AtomicSet(&speculations[i].readyEpoch, -1);
+    }
+}
+
+// Sets the parts for the moves and zoom from screen on, before the tiles of the
+// view are queued. No thread queues the speculations meanwhile.
+static void speculate(const struct ScreenXY* screen)
+{
+    for (int i = 0; i < NUM_SPECULATIONS; ++i) {
+        struct Speculation* speculation = &speculations[i];
+        if (!speculation->points)
+            continue;
+
+        struct ScreenXY next = *screen;
+        switch (i) {
+        case SPECULATE_RIGHT: moveRight(&next, speculateMove); break;
+        case SPECULATE_LEFT:  moveLeft(&next, speculateMove); break;
+        case SPECULATE_DOWN:  moveDown(&next, speculateMove); break;
+        case SPECULATE_UP:    moveUp(&next, speculateMove); break;
+        case SPECULATE_ZOOM:  zoomIn(&next, speculateZoom); break;
+        }
+        alignToPixels(&next);
+
+        struct MandelTile rect = speculationRect(i, screen);
+        partOfScreen(&speculation->next.part, &next, rect.x, rect.y, rect.width, rect.height);
+        speculation->next.precision = selectPrecision(&next);
+        speculation->next.maxIterations = selectMaxIterations(&next, maxIterations);
+    }
+}
+
 static int startThreads()
 {
     for (int i = 0; i < numThreads; ++i) {
         threads[i] = SDL_CreateThread(threadFunction, "calculate Mandelbrot", &workData[i]);
         if (!threads[i]) {
-            for (int j = 0; j < i; ++j) {  // close already spawned threads
-                stopThread(j);
-            }
+            stopThreads(i);     // close already spawned threads
+            freeTileQueue(tileQueue);
             free(threads);
             free(workData);
             return 1;
@@ -118,16 +694,51 @@ static int startThreads()
     return 0;
 }
 
-int mandelthread_run(const struct ScreenXY* screen)
+int mandelthread_run(const struct ScreenXY* screen_xy, const struct ColorPalette* palette)
 {
+    // views lie on the grid of the cache
+    struct ScreenXY view = *screen_xy;
+    alignToPixels(&view);
+    const struct ScreenXY* screen = &view;
+
     numMandelPoints = screen->height * screen->width;
+    screenWidth = screen->width;
+    screenHeight = screen->height;
     numThreads = SDL_GetCPUCount();
+    drawPalette = *palette;
+    SDL_AtomicSet(&subdivideView, subdivide);
+    SDL_AtomicSet(&motionStrideView, motionStride);
+    // the epochs of a new queue start again, the points of a run before are not set up for them
+    SDL_AtomicSet(&readyEpoch, -1);
 
-    if (allocGlobals())
+    if (allocGlobals(screen->width, screen->height))
         return 1;
+    allocSpeculations(screen);
+    tileCache = createTileCache(cacheBudget);
+    cacheLock = SDL_CreateMutex();
+    if (!cacheLock) {
+        freeTileCache(tileCache);
+        tileCache = NULL;
+    }
+    if (tileCache && storePath)
+        tileStore = openTileStore(storePath);
+    if (tileCache)
+        setTileCacheStore(tileCache, subdivide ? NULL : tileStore);
 
-    initMandelbrot(mandel_front, screen);
+    // the back buffer has no results until it was the front one
+    prepareMandelbrot(mandel_front, screen, selectPrecision(screen), selectMaxIterations(screen, maxIterations));
+    prepareMandelbrot(mandel_back, screen, selectPrecision(screen), selectMaxIterations(screen, maxIterations));
+    lastView = NULL;
+    shiftView = 0;
+    reprojectView = 0;
+    reuseView = 1;
+    SDL_AtomicSet(&settledEpoch, -1);
+    SDL_AtomicSet(&takenOver, 0);
+    speculate(screen);
     initThreadData();
+    struct MandelTile mirrored;
+    resetTileQueue(tileQueue, mandel_front, &mirrored, mirroredMandelRows(mandel_front, &mirrored));
+    redrawTiles(tileQueue);
 
     if(startThreads())
         return 2;
@@ -142,26 +753,165 @@ static inline void swap(MandelPoint** a, MandelPoint** b)
     *b = tmp;
 }
 
-static void changeThreadData(void)
+void changeMandel(const struct ScreenXY* screen_xy)
 {
-    MandelPoint* tmp = mandel_front;
-    int thrdPoints = numMandelPoints / numThreads;
-    for (int i = 0; i < numThreads; ++i) {
-        SDL_AtomicSetPtr((void**)&workData[i].points, tmp);
-        tmp = indexMandelPoint(tmp, thrdPoints);
+    struct ScreenXY view = *screen_xy;
+    alignToPixels(&view);
+    const struct ScreenXY* screen = &view;
+
+    // only points of a view complete at full resolution are sure to be
+    // done, and after the mode changed all points are calculated again
+    int complete = isTileQueueDone(tileQueue) && SDL_AtomicGet(&motionStrideView) == 1;
+    int reuse = SDL_AtomicGet(&subdivideView) == subdivide;
+    SDL_AtomicSet(&subdivideView, subdivide);
+    SDL_AtomicSet(&motionStrideView, motionStride);
+    swap(&mandel_front, &mandel_back);
+
+    // Threads may still iterate stale tiles of these points. They stop after
+    // the pass they are in, the tiles are initialised again by the threads.
+    // The tiles of the last view are made stale as well and waited for, its
+    // points are read below and by the threads which take over the tiles of
+    // the new view. Speculations are stopped once no tile of the last view
+    // queues them any more, the threads wait for them before they merge them.
+    clearTiles(tileQueue);
+    waitForTiles(tileQueue, mandel_front);
+    waitForTiles(tileQueue, mandel_back);
+    clearBackgroundTiles(tileQueue);
+
+    // The threads store the last view in the cache while they take over its
+    // tiles, if it was calculated in the mode of this one. Results of another
+    // mode are dropped. No thread uses the cache until the tiles are queued.
+    if (tileCache) {
+        setTileCacheStore(tileCache, subdivide ? NULL : tileStore);
+        if (!reuse)
+            clearTileCache(tileCache);
     }
+
+    // float while the zoom is shallow, double once pixels get too small
+    prepareMandelbrot(mandel_front, screen, selectPrecision(screen), selectMaxIterations(screen, maxIterations));
+
+    // After a move the points which are still on the screen keep their results,
+    // the threads copy them when they take over the tiles. Only the tiles which
+    // came into view are calculated then, the others are taken over when they
+    // are drawn. If the old view wasn't complete, tiles whose points are done
+    // finish at once. After a zoom the old view is shown until the points are
+    // calculated, the threads reproject it when they take over the tiles. Rows
+    // mirrored at the real axis are not calculated. The tiles take the points
+    // of the speculations and of the cache when they are taken over as well.
+    struct MandelTile done[2];
+    int numDone = 0;
+    int shifted = reuse && shiftedMandelRect(mandel_front, mandel_back, &done[numDone]);
+    lastView = mandel_back;
+    shiftView = shifted;
+    reprojectView = reuse && !shifted;
+    reuseView = reuse;
+    SDL_AtomicSet(&takenOver, 0);
+    if (shifted && complete)
+        ++numDone;
+    numDone += mirroredMandelRows(mandel_front, &done[numDone]);
+    speculate(screen);
+    resetTileQueue(tileQueue, mandel_front, done, numDone);
+    redrawTiles(tileQueue);
 }
 
-void changeMandel(const struct ScreenXY* screen)
+int mandelthread_takeDirty(const struct MandelTile** rects)
 {
-    swap(&mandel_front, &mandel_back);
+    return takeTileFrames(tileFrames, rects);
+}
+
+void mandelthread_copyPixels(const struct MandelTile* rect, uint32_t* pixels, int pitch)
+{
+    copyTileFrames(tileFrames, rect, pixels, pitch);
+}
+
+FrameSnapshot* mandelthread_snapshot(void)
+{
+    return snapshotTileFrames(tileFrames);
+}
+
+void mandelthread_copySnapshot(FrameSnapshot* snapshot, uint32_t* pixels)
+{
+    copyFrameSnapshot(snapshot, pixels);
+}
+
+void mandelthread_setPalette(const struct ColorPalette* palette)
+{
+    SDL_LockMutex(paletteLock);
+    drawPalette = *palette;
+    SDL_AtomicAdd(&paletteVersion, 1);
+    SDL_UnlockMutex(paletteLock);
+    redrawTiles(tileQueue);
+}
+
+void mandelthread_setSpeculation(double move_rate, double zoom_rate)
+{
+    speculateMove = move_rate;
+    speculateZoom = zoom_rate;
+}
+
+void mandelthread_setCacheBudget(size_t bytes)
+{
+    cacheBudget = bytes;
+}
+
+void mandelthread_getCacheStats(uint64_t* hits, uint64_t* misses, size_t* bytes)
+{
+    *hits = 0;
+    *misses = 0;
+    *bytes = 0;
+    if (tileCache) {
+        SDL_LockMutex(cacheLock);
+        getTileCacheStats(tileCache, hits, misses, bytes);
+        SDL_UnlockMutex(cacheLock);
+    }
+}
 
-    initMandelbrot(mandel_front, screen);
+void mandelthread_setStorePath(const char* path)
+{
+    storePath = path;
+}
 
-    changeThreadData();
+int mandelthread_getStoreStats(uint64_t* read, uint64_t* written)
+{
+    *read = 0;
+    *written = 0;
+    if (!tileStore)
+        return 0;
+    getTileStoreStats(tileStore, read, written);
+    return 1;
 }
 
-void mandelthread_draw(uint32_t* buffer_out, const uint32_t* colors, int num_colors)
+void mandelthread_setMaxIterations(uint32_t max_iterations)
 {
-    drawMandelbrot(mandel_front, buffer_out, numMandelPoints, colors, num_colors);
-}
\ No newline at end of file
+    maxIterations = max_iterations;
+}
+
+void mandelthread_setSubdivide(int enable)
+{
+    subdivide = enable;
+}
+
+int mandelthread_getSubdivide(void)
+{
+    return subdivide;
+}
+
+void mandelthread_setStride(int stride)
+{
+    motionStride = stride < 1 ? 1 : stride;
+}
+
+int mandelthread_getStride(void)
+{
+    return motionStride;
+}
+
+uint32_t mandelthread_getViewTime(void)
+{
+    return getTileQueueTime(tileQueue);
+}
+
+int mandelthread_isComplete(void)
+{
+    return isTileQueueDone(tileQueue);
+}
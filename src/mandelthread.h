@@ -14,15 +14,24 @@
 #ifndef MANDELTHREAD_H
 #define MANDELTHREAD_H
 
+#include <stddef.h>
+#include <stdint.h>
 #include "screen_xy.h"
+#include "color_palette.h"
+#include "mandelbrot.h"
+#include "tileframes.h"
 
 /** @brief  Starts calculating the mandelbrotset with threads in the background
  *
- *  @param  screen Information about wich pixel represents wich point in xy coordinates
+ *          The threads also draw it: each tile as soon as they calculated more
+ *          of its points, and the whole screen after it changed.
+ *
+ *  @param  screen  Information about wich pixel represents wich point in xy coordinates
+ *  @param  palette The color palette, it is copied
  *  @return 0 if success
  */
 
-int mandelthread_run(const struct ScreenXY* screen);
+int mandelthread_run(const struct ScreenXY* screen, const struct ColorPalette* palette);
 
 /** @brief  Changes the points for wich the mandelbrotset is calculated
  *
@@ -31,14 +40,167 @@ int mandelthread_run(const struct ScreenXY* screen);
 
 void changeMandel(const struct ScreenXY* screen);
 
-/** @brief  Draws the calculated mandelbrotset to the buffer according to color palette
+/** @brief  Sets which views are calculated in advance
+ *
+ *          While the threads have nothing else to do, they calculate the parts
+ *          of the screen a move in each direction and a zoom in would bring
+ *          into view. They stop as soon as the screen is changed, the parts
+ *          which are done are used if the change matches. Must be called
+ *          before mandelthread_run().
+ *
+ *  @param  move_rate Rate of the moves, like for moveUp(). 0 for none.
+ *  @param  zoom_rate Rate of the zoom, like for zoomIn(). 0 for none.
+ */
+
+void mandelthread_setSpeculation(double move_rate, double zoom_rate);
+
+/** @brief  Sets how much memory the results of earlier views may use
+ *
+ *          Results of views the screen comes back to are taken from the cache
+ *          instead of being calculated again. Must be called before mandelthread_run().
+ *
+ *  @param  bytes Memory budget of the cache, 0 for no cache
+ */
+
+void mandelthread_setCacheBudget(size_t bytes);
+
+/** @brief  Tells how well the cache works
+ *
+ *  @param  hits   Receives how many tiles of views were found in the cache
+ *  @param  misses Receives how many tiles of views were not found
+ *  @param  bytes  Receives the memory the cache uses now
+ */
+
+void mandelthread_getCacheStats(uint64_t* hits, uint64_t* misses, size_t* bytes);
+
+/** @brief  Sets the file which keeps the results of the cache across sessions
+ *
+ *          Views found in the file are not calculated again, new results are
+ *          appended to it in the background. Results guessed by subdivision are not kept.
+ *          Must be called before mandelthread_run(), the file is used only with a cache.
+ *
+ *  @param  path Path of the file, it must stay valid. NULL for none.
+ */
+
+void mandelthread_setStorePath(const char* path);
+
+/** @brief  Tells how many tiles were read from the file and appended to it
+ *
+ *  @param  read    Receives the number of tiles read
+ *  @param  written Receives the number of tiles appended
+ *  @return 1 if the file is used, 0 if it couldn't be opened or none is set
+ */
+
+int mandelthread_getStoreStats(uint64_t* read, uint64_t* written);
+
+/** @brief  Sets the maximum iterations for the points of the next change
+ *
+ *  @param  max_iterations Fixed budget, or MANDEL_ITERATIONS_AUTO to scale it with the zoom depth
+ */
+
+void mandelthread_setMaxIterations(uint32_t max_iterations);
+
+/** @brief  Selects how the points of the next change are rendered
+ *
+ *          By subdivision the border of a tile is calculated first. If all of
+ *          its points have the same result, the points inside get it without
+ *          being iterated. Otherwise the tile is split and its parts are
+ *          rendered the same way until they are small. This is much faster for
+ *          large uniform areas, but can miss details which don't reach the border.
+ *
+ *  @param  enable 1 to render by subdivision, 0 to calculate every point
+ */
+
+void mandelthread_setSubdivide(int enable);
+
+/** @brief  Returns the mode set with mandelthread_setSubdivide()
+ *
+ *  @return 1 if rendering by subdivision, else 0
+ */
+
+int mandelthread_getSubdivide(void);
+
+/** @brief  Sets the resolution of the next change
+ *
+ *          Only every stride-th point in both directions is calculated, the
+ *          others are drawn like their nearest calculated point. Used while
+ *          the view moves, so every view is done in time. The view is not
+ *          complete at full resolution until it is changed with a stride of 1.
+ *
+ *  @param  stride 1 for full resolution, up to MANDEL_COARSE_STRIDE
+ */
+
+void mandelthread_setStride(int stride);
+
+/** @brief  Returns the stride set with mandelthread_setStride()
+ *
+ *  @return The stride of the next change
+ */
+
+int mandelthread_getStride(void);
+
+/** @brief  Tells how long the current points took
+ *
+ *  @return Milliseconds from the last change until the points were
+ *          complete, until now if they are not complete yet
+ */
+
+uint32_t mandelthread_getViewTime(void);
+
+/** @brief  Tells if all threads finished the current points
+ *
+ *          Finished threads sleep until the points are changed.
+ *
+ *  @return 1 if the mandelbrotset on screen is complete, else 0
+ */
+
+int mandelthread_isComplete(void);
+
+/** @brief  Takes the parts of the screen drawn since the last call for presenting
+ *
+ *          The threads draw to other pixels meanwhile, the taken ones stay
+ *          as they are until the next call. Only one thread may present.
+ *
+ *  @param  rects Receives the parts, they are valid until the next call
+ *  @return Number of parts, 0 if no pixel changed
+ */
+
+int mandelthread_takeDirty(const struct MandelTile** rects);
+
+/** @brief  Copies the pixels taken for presenting
+ *
+ *  @param  rect   Part of the screen
+ *  @param  pixels The pixel of the top left of rect
+ *  @param  pitch  Pixels from one row to the next
+ */
+
+void mandelthread_copyPixels(const struct MandelTile* rect, uint32_t* pixels, int pitch);
+
+/** @brief  Takes a snapshot of the pixels taken for presenting, see snapshotTileFrames()
+ *
+ *          Only the thread which presents may call this.
+ *
+ *  @return The snapshot, NULL if allocation failed. Must be passed to
+ *          mandelthread_copySnapshot() once, before mandelthread_quit().
+ */
+
+FrameSnapshot* mandelthread_snapshot(void);
+
+/** @brief  Copies the pixels of a snapshot and releases it, from any thread
+ *
+ *  @param  snapshot
+ *  @param  pixels   Receives the whole screen, rows are its width apart.
+ *                   May be NULL to only release the snapshot.
+ */
+
+void mandelthread_copySnapshot(FrameSnapshot* snapshot, uint32_t* pixels);
+
+/** @brief  Changes the color palette, the threads draw the whole screen with it
  *
- *  @param  buffer_out The drawn mandelbrotset goes here. Size must be width * height
- *  @param  colors     The color palette
- *  @param  num_colors The size of the color palette
+ *  @param  palette The color palette, it is copied
  */
 
-void mandelthread_draw(uint32_t* buffer_out, const uint32_t* colors, int num_colors);
+void mandelthread_setPalette(const struct ColorPalette* palette);
 
 /** @brief  Stops all threads and frees all resources
  */
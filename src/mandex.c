@@ -5,15 +5,59 @@
  *             This work is licensed under the terms of the MIT license.
  */
 
+#include <stdlib.h>
+#include <string.h>
 #include <SDL2/SDL.h>
 #include "mdx.h"
 #include "window.h"
 
 #define FRAMERATE 30        //period in ms
 
+// Iterations after which the colors repeat
+#define COLOR_PERIOD 128
+
+#define TILE_FILE "mandex.tiles"
+
+#define TITLE "Fractal Explorer"
+#define TITLE_CALCULATING "Fractal Explorer - calculating..."
+#define TITLE_SAVING "Fractal Explorer - saving image..."
+#define TITLE_SAVED "Fractal Explorer - image saved"
+#define TITLE_FAILED "Fractal Explorer - saving image failed"
+
+// How long the title tells that an image was saved, in ms
+#define SAVED_TIME 3000
+
+// Images are saved in the background, the title tells when they are done
+static const char* selectTitle(void)
+{
+    static int done = 0;
+    static int failed = 0;
+    static int failedLast = 0;
+    static uint32_t doneTicks = 0;
+
+    int queued, saved, numFailed;
+    mdx_getImageStats(&queued, &saved, &numFailed);
+    if (saved + numFailed != done) {
+        done = saved + numFailed;
+        failedLast = numFailed != failed;
+        failed = numFailed;
+        doneTicks = SDL_GetTicks();
+    }
+    if (queued)
+        return TITLE_SAVING;
+    if (done && SDL_GetTicks() - doneTicks < SAVED_TIME)
+        return failedLast ? TITLE_FAILED : TITLE_SAVED;
+    return mdx_isComplete() ? TITLE : TITLE_CALCULATING;
+}
+
 int main(int argc, char* argv[])
 {
-    Window* window = window_create("Fractal Explorer");
+    // mandex poster <file> [width [height [megabytes]]] renders a poster without a window
+    if (argc > 2 && strcmp(argv[1], "poster") == 0)
+        return mdx_renderPoster(argv[2], argc > 3 ? atoi(argv[3]) : 0, argc > 4 ? atoi(argv[4]) : 0,
+                                argc > 5 ? atoi(argv[5]) : 0);
+
+    Window* window = window_create(TITLE);
     if (window == NULL) {
         fprintf(stderr, "Create window failed %s\n", window_getError());
         return 1;
@@ -21,11 +65,28 @@ int main(int argc, char* argv[])
     int width = window_getWidth(window);
     int height = window_getHeight(window);
 
-    mdx_run(width, height, 1000000, MDX_COLOR_SMOOTH);
+    // optional maximum iterations, without them they scale with the zoom depth
+    if (argc > 1)
+        mdx_setMaxIterations(atoi(argv[1]));
+    // optional size of the cache in megabytes
+    if (argc > 2)
+        mdx_setCacheSize(atoi(argv[2]));
+    // optional file which keeps the cache across sessions
+    mdx_setTileFile(argc > 3 ? argv[3] : TILE_FILE);
+
+    mdx_run(width, height, COLOR_PERIOD, MDX_COLOR_SMOOTH);
+    const char* title = TITLE;
     for (;;) {
         uint32_t frame_start = SDL_GetTicks();
-        uint32_t* pixels = mdx_render();
-        window_update(window, pixels);
+        const char* next = selectTitle();
+        if (next != title) {
+            title = next;
+            window_setTitle(window, title);
+        }
+        // only parts which were drawn are copied, nothing if the image is complete
+        const struct WindowRect* dirty;
+        int numDirty = mdx_render(&dirty);
+        window_update(window, dirty, numDirty, mdx_draw, NULL);
         if (mdx_event())
             break;
         uint32_t frame_time = SDL_GetTicks() - frame_start;
@@ -33,6 +94,15 @@ int main(int argc, char* argv[])
             SDL_Delay(FRAMERATE - frame_time);
     }
 
+    uint64_t hits, misses;
+    double megabytes;
+    mdx_getCacheStats(&hits, &misses, &megabytes);
+    printf("Tile cache: %llu hits, %llu misses, %.1f MB\n",
+           (unsigned long long)hits, (unsigned long long)misses, megabytes);
+    uint64_t read, written;
+    if (mdx_getTileFileStats(&read, &written))
+        printf("Tile file: %llu tiles read, %llu appended\n", (unsigned long long)read, (unsigned long long)written);
+
     mdx_quit();
     window_destroy(window);
     return 0;
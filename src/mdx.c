@@ -13,29 +13,45 @@
 #include "screen_xy.h"
 #include "color_palette.h"
 #include "mandelthread.h"
-#include "saveBmp.h"
+#include "mandelbrot.h"
+#include "imagewriter.h"
+#include "poster.h"
 
-// Part of xy-plane which is displayed on the screen
+// Part of xy-plane which is displayed on the screen,
+// the center is set in mdx_run()
 struct ScreenXY screen = {
-    .xMin = -2.5,
-    .xMax = 1.0,
-    .yMin = -1.0,
-    .yMax = 1.0
+    .xSpan = 3.5,
+    .ySpan = 2.0
 };
 
 // Rate (percent) screen is modified at event
 const double move_rate = 0.1;
 const double zoom_rate = 0.05;
 
-// Mandelbrot set is colored according to this palette
-uint32_t* colorPalette;
-int numColors;
+// While a key moves the screen a view should take at most this many ms,
+// about the time between two repeated key events
+#define MOTION_TIME 30
 
-// Contains the image
-uint32_t* image_buffer;
+// Iteration budget as set, MANDEL_ITERATIONS_AUTO scales it with the zoom depth
+uint32_t maxIterationSetting = MANDEL_ITERATIONS_AUTO;
 
-// filename for .bmp file is saved here
-char image_name[51];
+// Mandelbrot set is colored according to this palette,
+// smooth palettes repeat after colorIterations
+struct ColorPalette colorPalette;
+int colorIterations;
+
+// Parts of the image which changed, grown when more are needed
+struct WindowRect* dirty_rects;
+int max_dirty_rects;
+
+// filename for .png file is saved here
+char image_name[IMAGE_NAME_SIZE];
+
+// filename for .poster file is saved here
+char poster_name[IMAGE_NAME_SIZE];
+
+// Saves images in the background, NULL if it couldn't be started
+ImageWriter* image_writer;
 
 // Contains error message
 const char* errstr = "mdx: No error occured\n";
@@ -43,41 +59,37 @@ const char* errstr = "mdx: No error occured\n";
 const char* erralloc = "mdx: Memory allocation failed\n";
 const char* errthrd = "mdx: Thread creation failed\n";
 
-static void initColorPalette(uint32_t* colors, int depth, int style)
+// Random palettes change the color every iteration, like a sharp image
+static void initColorPalette(int style)
 {
-    colorPalette = colors;
-    numColors = depth;
     switch (style) {
     case MDX_COLOR_RANDOM:
-        colorRandom(colors, depth);
+        colorRandom(colorPalette.stops, COLOR_STOPS);
+        colorBlend(&colorPalette, COLOR_STOPS);
         break;
     case MDX_COLOR_SMOOTH:
-        colorSmooth(colors, depth);
+        colorSmooth(colorPalette.stops, COLOR_STOPS);
+        colorBlend(&colorPalette, colorIterations);
         break;
     }
 }
 
-int mdx_run(int screen_width, int screen_height, int color_depth, int color_style)
+int mdx_run(int screen_width, int screen_height, int color_period, int color_style)
 {
+    screen.xCenter = bigfixFromDouble(-0.75);
+    screen.yCenter = bigfixFromDouble(0.0);
     screen.width = screen_width;
     screen.height = screen_height;
 
-    uint32_t* colors = malloc(sizeof(uint32_t) * color_depth);
-    if (!colors) {
-        errstr = erralloc;
-        return 1;
-    }
-    initColorPalette(colors, color_depth, color_style);
+    colorIterations = color_period;
+    initColorPalette(color_style);
 
-    image_buffer = malloc(screen_width * screen_height * sizeof(uint32_t));
-    if (!image_buffer) {
-        free(colors);
-        errstr = erralloc;
-    }
+    // without the writer images are saved at once
+    image_writer = createImageWriter();
 
-    if (mandelthread_run(&screen)) {
-        free(colors);
-        free(image_buffer);
+    mandelthread_setSpeculation(move_rate, zoom_rate);
+    if (mandelthread_run(&screen, &colorPalette)) {
+        freeImageWriter(image_writer);
         errstr = errthrd;
         return 1;
     }
@@ -85,30 +97,156 @@ int mdx_run(int screen_width, int screen_height, int color_depth, int color_styl
     return 0;
 }
 
+void mdx_setMaxIterations(int max_iterations)
+{
+    maxIterationSetting = max_iterations > 0 ? (uint32_t)max_iterations : MANDEL_ITERATIONS_AUTO;
+    mandelthread_setMaxIterations(maxIterationSetting);
+}
+
+void mdx_setCacheSize(int megabytes)
+{
+    mandelthread_setCacheBudget(megabytes > 0 ? (size_t)megabytes << 20 : 0);
+}
+
+void mdx_setTileFile(const char* path)
+{
+    mandelthread_setStorePath(path);
+}
+
+int mdx_getTileFileStats(uint64_t* read, uint64_t* written)
+{
+    return mandelthread_getStoreStats(read, written);
+}
+
+void mdx_getCacheStats(uint64_t* hits, uint64_t* misses, double* megabytes)
+{
+    size_t bytes;
+    mandelthread_getCacheStats(hits, misses, &bytes);
+    *megabytes = bytes / (1024.0 * 1024.0);
+}
+
+int mdx_isComplete(void)
+{
+    return mandelthread_isComplete();
+}
+
 void mdx_quit(void)
 {
+    // queued snapshots are copied from the frames of the threads
+    freeImageWriter(image_writer);
     mandelthread_quit();
-    free(colorPalette);
-    free(image_buffer);
+    free(dirty_rects);
 }
 
+// Copies a snapshot of the screen for the image writer
+static void copySnapshot(void* snapshot, uint32_t* pixels)
+{
+    mandelthread_copySnapshot(snapshot, pixels);
+}
+
+// Saves the image on screen in the background. The writer copies a snapshot,
+// here only the tiles are copied which are presented anew before that.
 static void printMandel(void)
 {
-    sprintf(image_name, "%li.bmp", time(NULL));
-    saveBMP(image_name, image_buffer, screen.width, -screen.height);
+    sprintf(image_name, "%li.png", time(NULL));
+    FrameSnapshot* snapshot = image_writer ? mandelthread_snapshot() : NULL;
+    if (snapshot) {
+        queueImageCopy(image_writer, image_name, copySnapshot, snapshot, screen.width, -screen.height);
+        return;
+    }
+
+    uint32_t* image = malloc((size_t)screen.width * screen.height * sizeof(uint32_t));
+    if (!image) {
+        errstr = erralloc;
+        return;
+    }
+    struct MandelTile whole = {0, 0, screen.width, screen.height};
+    mandelthread_copyPixels(&whole, image, screen.width);
+    if (image_writer) {
+        queueImage(image_writer, image_name, image, screen.width, -screen.height);
+    }
+    else {
+        saveImage(image_name, image, screen.width, -screen.height);
+        free(image);
+    }
+}
+
+// Saves the view to render it as poster later
+static void savePoster(void)
+{
+    sprintf(poster_name, "%li.poster", time(NULL));
+    if (createPoster(poster_name, &screen, &colorPalette, selectMaxIterations(&screen, maxIterationSetting)))
+        fprintf(stderr, "mdx: Saving %s failed\n", poster_name);
+    else
+        printf("Saved %s, render it with: mandex poster %s <width> <height>\n", poster_name, poster_name);
+}
+
+int mdx_renderPoster(const char* path, int width, int height, int megabytes)
+{
+    size_t memory = (size_t)(megabytes > 0 ? megabytes : MDX_POSTER_MEMORY) << 20;
+    switch (renderPoster(path, width > 0 ? width : 0, height > 0 ? height : 0, memory)) {
+    case 0:
+        return 0;
+    case -1:
+        fprintf(stderr, "mdx: %s is no poster file or the image couldn't be opened\n", path);
+        break;
+    case -2:
+        fprintf(stderr, "%s", erralloc);
+        break;
+    case -3:
+        fprintf(stderr, "mdx: Writing the image of %s failed\n", path);
+        break;
+    case -4:
+        fprintf(stderr, "mdx: %s was started with another size\n", path);
+        break;
+    }
+    return 1;
+}
+
+void mdx_getImageStats(int* queued, int* saved, int* failed)
+{
+    *queued = 0;
+    *saved = 0;
+    *failed = 0;
+    if (image_writer)
+        getImageWriterStats(image_writer, queued, saved, failed);
 }
 
 static void randomColorPalette(void)
 {
     srand(time(NULL));
     if (rand() & 3)       // higher change for smooth colors
-        colorSmooth(colorPalette, numColors);
+        initColorPalette(MDX_COLOR_SMOOTH);
     else
-        colorRandom(colorPalette, numColors);
+        initColorPalette(MDX_COLOR_RANDOM);
+    mandelthread_setPalette(&colorPalette);
+}
+
+// Tells if a key which moves the screen is held down
+static int isMoving(void)
+{
+    const Uint8* keys = SDL_GetKeyboardState(NULL);
+    return keys[SDL_SCANCODE_UP] || keys[SDL_SCANCODE_DOWN]
+        || keys[SDL_SCANCODE_LEFT] || keys[SDL_SCANCODE_RIGHT]
+        || keys[SDL_SCANCODE_I] || keys[SDL_SCANCODE_O];
+}
+
+// Picks the finest stride at which the next view takes at most MOTION_TIME,
+// estimated from the time of the last view. The work shrinks with the square of the stride.
+static int selectMotionStride(void)
+{
+    uint32_t last = mandelthread_getStride();
+    uint32_t time = mandelthread_getViewTime() * last * last;
+    int stride = 1;
+    while (stride < MANDEL_COARSE_STRIDE && time > (uint32_t)(MOTION_TIME * stride * stride))
+        stride *= 2;
+    return stride;
 }
 
 int mdx_event(void)
 {
+    // all events since the last call change the view only once
+    int changed = 0;
     SDL_Event event;
     while (SDL_PollEvent(&event)) {
         switch (event.type) {
@@ -120,43 +258,92 @@ int mdx_event(void)
                 return 1;
             case SDLK_DOWN:
                 moveDown(&screen, move_rate);
-                changeMandel(&screen);
+                changed = 1;
                 break;
             case SDLK_UP:
                 moveUp(&screen, move_rate);
-                changeMandel(&screen);
+                changed = 1;
                 break;
             case SDLK_RIGHT:
                 moveRight(&screen, move_rate);
-                changeMandel(&screen);
+                changed = 1;
                 break;
             case SDLK_LEFT:
                 moveLeft(&screen, move_rate);
-                changeMandel(&screen);
+                changed = 1;
                 break;
             case SDLK_i:
                 zoomIn(&screen, zoom_rate);
-                changeMandel(&screen);
+                changed = 1;
                 break;
             case SDLK_o:
                 zoomOut(&screen, zoom_rate);
-                changeMandel(&screen);
+                changed = 1;
                 break;
             case SDLK_p:
                 printMandel();
                 break;
+            case SDLK_v:
+                savePoster();
+                break;
             case SDLK_c:
                 randomColorPalette();
                 break;
+            case SDLK_g:
+                mandelthread_setSubdivide(!mandelthread_getSubdivide());
+                changed = 1;
+                break;
             }
             break;
         }
    }
+    // moving views are rendered coarser and refined once the keys are released
+    int moving = isMoving();
+    if (changed) {
+        mandelthread_setStride(moving ? selectMotionStride() : 1);
+        changeMandel(&screen);
+    }
+    else if (!moving && mandelthread_getStride() > 1) {
+        mandelthread_setStride(1);
+        changeMandel(&screen);
+    }
    return 0;
 }
 
-uint32_t* mdx_render(void)
+int mdx_render(const struct WindowRect** dirty)
+{
+    const struct MandelTile* tiles;
+    int numTiles = mandelthread_takeDirty(&tiles);
+    if (numTiles > max_dirty_rects) {
+        struct WindowRect* rects = realloc(dirty_rects, numTiles * sizeof(struct WindowRect));
+        if (rects) {
+            dirty_rects = rects;
+            max_dirty_rects = numTiles;
+        }
+    }
+
+    // without room for the parts the whole image changed
+    if (numTiles > max_dirty_rects) {
+        static struct WindowRect whole;
+        whole.width = screen.width;
+        whole.height = screen.height;
+        *dirty = &whole;
+        return 1;
+    }
+
+    for (int i = 0; i < numTiles; ++i) {
+        dirty_rects[i].x = tiles[i].x;
+        dirty_rects[i].y = tiles[i].y;
+        dirty_rects[i].width = tiles[i].width;
+        dirty_rects[i].height = tiles[i].height;
+    }
+    *dirty = dirty_rects;
+    return numTiles;
+}
+
+void mdx_draw(void* data, const struct WindowRect* rect, uint32_t* pixels, int pitch)
 {
-    mandelthread_draw(image_buffer, colorPalette, numColors);
-    return image_buffer;
+    (void)data;
+    struct MandelTile part = {rect->x, rect->y, rect->width, rect->height};
+    mandelthread_copyPixels(&part, pixels, pitch);
 }
@@ -14,6 +14,7 @@
 #ifndef MDX_H
 
 #include <stdint.h>
+#include "window.h"
 
 /** @brief Possible styles for the color palette.
 *
@@ -31,12 +32,87 @@ enum color_style {
  *
  *  @param screen_width Width of the screen to render
  *  @param screen_height Height of the screen to render
- *  @param The depth of the color palette (number of differnt colors)
+ *  @param Iterations after which the colors of a smooth palette repeat
  *  @param The style of the color palette (e.g. COLOR_RANDOM or COLOR_SMOOTH)
  *  @return 0 if success
  */
 
-int mdx_run(int screen_width, int screen_height, int color_depth, int color_style);
+int mdx_run(int screen_width, int screen_height, int color_period, int color_style);
+
+/** @brief Sets how many iterations a point may take before it counts as inside the set.
+ *         Applies from the next change of the screen, so call it before mdx_run().
+ *
+ *  @param max_iterations The maximum iterations, 0 to scale them with the zoom depth
+ */
+
+void mdx_setMaxIterations(int max_iterations);
+
+/** @brief Sets how much memory results of earlier views may use, so that
+ *         views which come back to a place don't calculate it again. Call it before mdx_run().
+ *
+ *  @param megabytes Size of the cache, 0 for none
+ */
+
+void mdx_setCacheSize(int megabytes);
+
+/** @brief Sets the file which keeps the cache across sessions, so places calculated
+ *         before are shown at once. Call it before mdx_run().
+ *
+ *  @param path Path of the file, it must stay valid. NULL for none.
+ */
+
+void mdx_setTileFile(const char* path);
+
+/** @brief Tells how many tiles were read from the file of the cache and appended to it
+ *
+ *  @param read    Receives the number of tiles read
+ *  @param written Receives the number of tiles appended
+ *  @return 1 if the file is used, else 0
+ */
+
+int mdx_getTileFileStats(uint64_t* read, uint64_t* written);
+
+/** @brief Tells how often tiles of a view were found in the cache
+ *
+ *  @param hits      Receives the number of tiles found
+ *  @param misses    Receives the number of tiles calculated again
+ *  @param megabytes Receives the memory the cache uses now
+ */
+
+void mdx_getCacheStats(uint64_t* hits, uint64_t* misses, double* megabytes);
+
+/** @brief Tells how many of the images saved with key p are done
+ *
+ *  Images are saved in the background, so the screen goes on meanwhile.
+ *
+ *  @param queued Receives the number of images not saved yet
+ *  @param saved  Receives the number of images saved so far
+ *  @param failed Receives the number of images which couldn't be saved
+ */
+
+void mdx_getImageStats(int* queued, int* saved, int* failed);
+
+// Memory for the points of a poster strip if none is given, in megabytes
+#define MDX_POSTER_MEMORY 1024
+
+/** @brief Renders a poster saved with key v to a png file of the same name,
+ *         or continues it where it was stopped. Works without mdx_run().
+ *
+ *  @param path      The poster file
+ *  @param width     Width of the image, 0 for the one it was started with or a default
+ *  @param height    Height of the image, 0 to take it from the width and the view
+ *  @param megabytes Memory for the points of a strip, 0 for MDX_POSTER_MEMORY
+ *  @return 0 if the image is complete, else 1 and an error message is printed
+ */
+
+int mdx_renderPoster(const char* path, int width, int height, int megabytes);
+
+/** @brief Tells if the mandelbrotset on screen is completely calculated
+ *
+ *  @return true if all points are done and the background threads sleep
+ */
+
+int mdx_isComplete(void);
 
 /** @brief Stops the background threads and frees resources
  */
@@ -50,12 +126,27 @@ void mdx_quit(void);
 
 int mdx_event(void);
 
-/** @brief Renders the screen to a pixel buffer
+/** @brief Takes the parts of the screen which changed since the last call
+ *
+ *  The background threads draw the mandelbrotset whenever parts of it are
+ *  calculated and after the view or color palette changed. The taken parts
+ *  stay as they are until the next call, draw them with mdx_draw().
+ *
+ *  @param dirty Receives the parts, valid until the next call
+ *  @return Number of parts, 0 if no pixel changed
+ */
+
+int mdx_render(const struct WindowRect** dirty);
+
+/** @brief Draws a part of the screen as taken by mdx_render(), a WindowDraw for window_update()
  *
- *  @return Pointer to buffer containg the rendered image
+ *  @param data   Not used
+ *  @param rect   The part
+ *  @param pixels The pixel of the top left of rect
+ *  @param pitch  Pixels from one row to the next
  */
 
-uint32_t* mdx_render();
+void mdx_draw(void* data, const struct WindowRect* rect, uint32_t* pixels, int pitch);
 
 #define MDX_H
 #endif /* MDX_H */
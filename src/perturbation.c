@@ -0,0 +1,318 @@
+/*  Filename:  perturbation.c
+ *
+ *  Author:    mandex contributors
+ *  Copyright: (c) 2026 mandex contributors. All rights reserved.
+ *             This work is licensed under the terms of the MIT license.
+ */
+
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include "perturbation.h"
+
+// The series is used while it differs from the exact difference
+// of all probes by less than this (relative, squared)
+#define SERIES_TOLERANCE 1e-18
+
+// Coefficients beyond this would overflow when squared
+#define SERIES_LIMIT 1e100
+
+// Iterations of an orbit between two checks if it was cancelled
+#define CANCEL_INTERVAL 1024
+
+// The primary orbit of the last view, reused while it is close enough
+static struct ReferenceOrbit* cachedOrbit;
+
+static inline double absDouble(double a)
+{
+    return a < 0.0 ? -a : a;
+}
+
+static void releaseOrbit(struct ReferenceOrbit* orbit)
+{
+    if (orbit && --orbit->users == 0) {
+        free(orbit->z_re);
+        free(orbit->z_im);
+        free(orbit->series);
+        free(orbit);
+    }
+}
+
+// Appends the coefficients for the next iteration, returns 1 when the
+// series can't be continued
+static int appendSeries(struct ReferenceOrbit* orbit, int* capacity, const double coeff[6])
+{
+    if (orbit->seriesLength == *capacity) {
+        int grown = *capacity ? 2 * *capacity : 1024;
+        double* series = realloc(orbit->series, 6 * grown * sizeof(double));
+        if (!series)
+            return 1;
+        orbit->series = series;
+        *capacity = grown;
+    }
+    memcpy(orbit->series + 6 * orbit->seriesLength, coeff, 6 * sizeof(double));
+    ++orbit->seriesLength;
+    return 0;
+}
+
+// Makes room for Z_0 ... Z_n, returns 1 if memory allocation failed
+static int growOrbit(struct ReferenceOrbit* orbit, int* capacity, int n, int maxLength)
+{
+    if (n < *capacity)
+        return 0;
+    int grown = *capacity ? *capacity : REFERENCE_CAPACITY / 2;
+    grown = grown > maxLength / 2 ? maxLength + 1 : 2 * grown;
+    double* z_re = realloc(orbit->z_re, (size_t)grown * sizeof(double));
+    if (!z_re)
+        return 1;
+    orbit->z_re = z_re;
+    double* z_im = realloc(orbit->z_im, (size_t)grown * sizeof(double));
+    if (!z_im)
+        return 1;
+    orbit->z_im = z_im;
+    *capacity = grown;
+    return 0;
+}
+
+// Calculates the orbit of c until it escapes or maxLength iterations are reached,
+// a point never needs more of it than its budget of iterations.
+// The series is only calculated if seriesScale is not zero.
+// Returns NULL if memory allocation failed or the orbit was cancelled.
+static struct ReferenceOrbit* computeOrbit(const BigFix* c_re, const BigFix* c_im,
+                                           int limbs, double seriesScale, int maxLength,
+                                           ReferenceCancel cancel, const void* data)
+{
+    struct ReferenceOrbit* orbit = calloc(1, sizeof(struct ReferenceOrbit));
+    if (!orbit)
+        return NULL;
+    orbit->users = 1;
+    orbit->limbs = limbs;
+    orbit->seriesScale = seriesScale;
+
+    // bits below the used limbs are ignored by the arithmetic anyway
+    memset(&orbit->c_re, 0, sizeof(BigFix));
+    memset(&orbit->c_im, 0, sizeof(BigFix));
+    memcpy(orbit->c_re.limb, c_re->limb, limbs * sizeof(uint32_t));
+    memcpy(orbit->c_im.limb, c_im->limb, limbs * sizeof(uint32_t));
+
+    BigFix zr, zi, zr2, zi2, zri;
+    memset(&zr, 0, sizeof(BigFix));
+    memset(&zi, 0, sizeof(BigFix));
+
+    // A, B, C scaled by seriesScale, seriesScale^2, seriesScale^3
+    double coeff[6] = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+    int capacity = 0;
+    int series = seriesScale != 0.0;
+    int zCapacity = 0;
+
+    for (int n = 0; ; ++n) {
+        if (growOrbit(orbit, &zCapacity, n, maxLength)
+            || (cancel && n % CANCEL_INTERVAL == 0 && cancel(data))) {
+            releaseOrbit(orbit);
+            return NULL;
+        }
+        double Zr = bigfixToDouble(&zr);
+        double Zi = bigfixToDouble(&zi);
+        orbit->z_re[n] = Zr;
+        orbit->z_im[n] = Zi;
+
+        if (series) {
+            series = !appendSeries(orbit, &capacity, coeff);
+            double ar = coeff[0], ai = coeff[1];
+            double br = coeff[2], bi = coeff[3];
+            double cr = coeff[4], ci = coeff[5];
+            // A' = 2ZA + 1, B' = 2ZB + A^2, C' = 2ZC + 2AB
+            coeff[0] = 2.0 * (Zr * ar - Zi * ai) + seriesScale;
+            coeff[1] = 2.0 * (Zr * ai + Zi * ar);
+            coeff[2] = 2.0 * (Zr * br - Zi * bi) + ar * ar - ai * ai;
+            coeff[3] = 2.0 * (Zr * bi + Zi * br) + 2.0 * ar * ai;
+            coeff[4] = 2.0 * (Zr * cr - Zi * ci + ar * br - ai * bi);
+            coeff[5] = 2.0 * (Zr * ci + Zi * cr + ar * bi + ai * br);
+            for (int i = 0; i < 6; ++i)
+                series &= absDouble(coeff[i]) < SERIES_LIMIT;
+        }
+
+        if (Zr * Zr + Zi * Zi > 4.0) {
+            orbit->escaped = 1;
+            orbit->length = n;
+            break;
+        }
+        if (n == maxLength) {
+            orbit->length = n;
+            break;
+        }
+
+        bigfixMul(&zr2, &zr, &zr, limbs);
+        bigfixMul(&zi2, &zi, &zi, limbs);
+        bigfixMul(&zri, &zr, &zi, limbs);
+        bigfixAdd(&zi, &zri, &zri, limbs);
+        bigfixAdd(&zi, &zi, &orbit->c_im, limbs);
+        bigfixSub(&zr, &zr2, &zi2, limbs);
+        bigfixAdd(&zr, &zr, &orbit->c_re, limbs);
+    }
+    return orbit;
+}
+
+static void seriesAt(const struct ReferenceOrbit* orbit, int n,
+                     double u_re, double u_im, double* s_re, double* s_im)
+{
+    const double* coeff = orbit->series + 6 * n;
+    // u * (A + u * (B + u * C))
+    double tr = coeff[2] + u_re * coeff[4] - u_im * coeff[5];
+    double ti = coeff[3] + u_re * coeff[5] + u_im * coeff[4];
+    double sr = coeff[0] + u_re * tr - u_im * ti;
+    double si = coeff[1] + u_re * ti + u_im * tr;
+    *s_re = u_re * sr - u_im * si;
+    *s_im = u_re * si + u_im * sr;
+}
+
+// Iterates probes at the border of the view exactly and returns the
+// last iteration at which the series still matches all of them
+static int findSeriesSkip(const struct MandelReferences* refs, double halfX, double halfY)
+{
+    const struct ReferenceOrbit* orbit = refs->orbit[0];
+    int skip = orbit->seriesLength - 1;
+    if (skip > orbit->length - 1)
+        skip = orbit->length - 1;
+    if (skip <= 0)
+        return 0;
+
+    static const double probes[8][2] = {
+        { -1.0, -1.0 }, { 0.0, -1.0 }, { 1.0, -1.0 }, { -1.0, 0.0 },
+        {  1.0,  0.0 }, { -1.0, 1.0 }, { 0.0,  1.0 }, {  1.0, 1.0 }
+    };
+    for (int p = 0; p < 8; ++p) {
+        double dcr = probes[p][0] * halfX - refs->offset_re[0];
+        double dci = probes[p][1] * halfY - refs->offset_im[0];
+        double ur = dcr / orbit->seriesScale;
+        double ui = dci / orbit->seriesScale;
+        double dzr = 0.0;
+        double dzi = 0.0;
+        for (int n = 0; n < skip; ++n) {
+            double tr = 2.0 * orbit->z_re[n] + dzr;
+            double ti = 2.0 * orbit->z_im[n] + dzi;
+            double nr = tr * dzr - ti * dzi + dcr;
+            dzi = tr * dzi + ti * dzr + dci;
+            dzr = nr;
+
+            double zr = orbit->z_re[n + 1] + dzr;
+            double zi = orbit->z_im[n + 1] + dzi;
+            double sr, si;
+            seriesAt(orbit, n + 1, ur, ui, &sr, &si);
+            double er = sr - dzr;
+            double ei = si - dzi;
+            if (zr * zr + zi * zi > 4.0
+                || er * er + ei * ei > SERIES_TOLERANCE * (dzr * dzr + dzi * dzi)) {
+                skip = n;
+                break;
+            }
+        }
+    }
+    return skip;
+}
+
+// Difference of two fixed point numbers as double
+static double difference(const BigFix* a, const BigFix* b)
+{
+    BigFix d;
+    bigfixSub(&d, a, b, BIGFIX_LIMBS);
+    return bigfixToDouble(&d);
+}
+
+struct MandelReferences* createReferences(const struct ScreenXY* screen, uint32_t maxIterations,
+                                          ReferenceCancel cancel, const void* data)
+{
+    struct MandelReferences* refs = calloc(1, sizeof(struct MandelReferences));
+    if (!refs)
+        return NULL;
+    refs->center_re = screen->xCenter;
+    refs->center_im = screen->yCenter;
+    refs->limbs = bigfixLimbs(pixelSpacing(screen));
+    refs->maxLength = maxIterations < INT_MAX ? (int)maxIterations : INT_MAX - 1;
+
+    double halfX = 0.5 * screen->xSpan;
+    double halfY = 0.5 * screen->ySpan;
+
+    // Small moves keep the reference inside the view,
+    // only its offset to the new center changes.
+    if (cachedOrbit && cachedOrbit->limbs >= refs->limbs
+        && (cachedOrbit->escaped || cachedOrbit->length >= refs->maxLength)) {
+        double dx = difference(&cachedOrbit->c_re, &screen->xCenter);
+        double dy = difference(&cachedOrbit->c_im, &screen->yCenter);
+        if (absDouble(dx) <= halfX && absDouble(dy) <= halfY) {
+            refs->orbit[0] = cachedOrbit;
+            refs->offset_re[0] = dx;
+            refs->offset_im[0] = dy;
+            ++cachedOrbit->users;
+        }
+    }
+
+    if (!refs->orbit[0]) {
+        double scale = halfX > halfY ? halfX : halfY;
+        refs->orbit[0] = computeOrbit(&screen->xCenter, &screen->yCenter, refs->limbs, scale, refs->maxLength,
+                                      cancel, data);
+        if (!refs->orbit[0]) {
+            free(refs);
+            return NULL;
+        }
+        refs->offset_re[0] = difference(&refs->orbit[0]->c_re, &screen->xCenter);
+        refs->offset_im[0] = difference(&refs->orbit[0]->c_im, &screen->yCenter);
+        releaseOrbit(cachedOrbit);
+        cachedOrbit = refs->orbit[0];
+        ++cachedOrbit->users;
+    }
+    refs->count = 1;
+    refs->seriesSkip = findSeriesSkip(refs, halfX, halfY);
+    return refs;
+}
+
+void freeReferences(struct MandelReferences* refs)
+{
+    if (!refs)
+        return;
+    for (int i = 0; i < refs->count; ++i)
+        releaseOrbit(refs->orbit[i]);
+    free(refs);
+}
+
+void freeReferenceCache(void)
+{
+    releaseOrbit(cachedOrbit);
+    cachedOrbit = NULL;
+}
+
+int addReference(struct MandelReferences* refs, double offset_re, double offset_im,
+                 ReferenceCancel cancel, const void* data)
+{
+    if (refs->count == MAX_REFERENCES)
+        return -1;
+
+    BigFix c_re, c_im;
+    bigfixAddDouble(&c_re, &refs->center_re, offset_re);
+    bigfixAddDouble(&c_im, &refs->center_im, offset_im);
+    struct ReferenceOrbit* orbit = computeOrbit(&c_re, &c_im, refs->limbs, 0.0, refs->maxLength, cancel, data);
+    if (!orbit)
+        return -1;
+
+    int index = refs->count;
+    refs->orbit[index] = orbit;
+    refs->offset_re[index] = difference(&orbit->c_re, &refs->center_re);
+    refs->offset_im[index] = difference(&orbit->c_im, &refs->center_im);
+    refs->count = index + 1;
+    return index;
+}
+
+void evaluateSeries(const struct MandelReferences* refs,
+                    double dc_re, double dc_im,
+                    double* dz_re, double* dz_im)
+{
+    const struct ReferenceOrbit* orbit = refs->orbit[0];
+    if (refs->seriesSkip == 0) {
+        *dz_re = 0.0;
+        *dz_im = 0.0;
+        return;
+    }
+    double ur = (dc_re - refs->offset_re[0]) / orbit->seriesScale;
+    double ui = (dc_im - refs->offset_im[0]) / orbit->seriesScale;
+    seriesAt(orbit, refs->seriesSkip, ur, ui, dz_re, dz_im);
+}
@@ -0,0 +1,146 @@
+/** @file        perturbation.h
+ *
+ *  @brief       Reference orbits for calculating deep zooms with perturbation theory.
+ *
+ *               One reference orbit Z is calculated with arbitrary precision. Every pixel
+ *               c = C + dc then only iterates its difference to the reference in double:
+ *               dz' = 2 * Z * dz + dz^2 + dc
+ *
+ *               A series approximation dz = A * dc + B * dc^2 + C * dc^3 skips the first
+ *               iterations for all pixels at once. Pixels whose difference loses precision
+ *               (glitches) are detected and recalculated with secondary references.
+ *
+ *  @version     1.0
+ *  @date        10/17/2026
+ *  Revision:    -
+ *
+ *  @author      mandex contributors
+ *  @copyright   Copyright (c) 2026 mandex contributors. All rights reserved.
+ *               This work is licensed under the terms of the MIT license.
+ */
+
+#ifndef PERTURBATION_H
+#define PERTURBATION_H
+
+#include <stdint.h>
+#include "bigfix.h"
+#include "screen_xy.h"
+
+// Maximum number of references (primary and secondary) for one view
+#define MAX_REFERENCES 16
+
+// Iterations a reference orbit first has room for, it grows up to the budget of the view
+#define REFERENCE_CAPACITY 4096
+
+// Flag in the reference lane of a point which needs another reference
+#define REFERENCE_GLITCHED 0x80
+
+// Value of the reference lane if no reference could fix the glitch, the point is rebased on the primary reference then
+#define REFERENCE_FAILED 0xFF
+
+// A point glitches if |z|^2 < GLITCH_TOLERANCE * |Z|^2 (Pauldelbrot's criterion)
+#define GLITCH_TOLERANCE 1e-6
+
+/** @brief Tells if an orbit is not needed anymore, e.g. because the view changed
+ *
+ *         Checked every few iterations while an orbit is calculated.
+ *
+ *  @param data Passed with the function
+ *  @return 1 to stop calculating the orbit, else 0
+ */
+
+typedef int (*ReferenceCancel)(const void* data);
+
+/** @brief The orbit of one reference point
+ */
+
+struct ReferenceOrbit {
+    BigFix c_re;
+    BigFix c_im;
+    int limbs;          // precision the orbit was calculated with
+    double* z_re;       // Z_0 ... Z_length rounded to double
+    double* z_im;
+    int length;         // a point at iteration n needs Z_n and Z_n+1, so n < length
+    int escaped;        // if the reference escaped at Z_length, else length is the budget
+
+    // Coefficients of the series approximation, scaled by seriesScale^k so
+    // they stay in range of double. Valid for n < seriesLength.
+    double* series;     // a_re, a_im, b_re, b_im, c_re, c_im interleaved per iteration
+    int seriesLength;
+    double seriesScale;
+
+    int users;          // number of MandelReferences sharing this orbit
+};
+
+/** @brief The references for one view
+ */
+
+struct MandelReferences {
+    struct ReferenceOrbit* orbit[MAX_REFERENCES];
+    double offset_re[MAX_REFERENCES];   // reference - view center
+    double offset_im[MAX_REFERENCES];
+    int count;
+    int seriesSkip;     // iterations skipped with the series of the primary reference
+    BigFix center_re;   // the view center
+    BigFix center_im;
+    int limbs;
+    int maxLength;      // the iteration budget of the view
+};
+
+/** @brief Creates the references for a view.
+ *
+ *         The primary reference orbit of the last view is reused if it is
+ *         still close to the view, precise enough and long enough, so small
+ *         moves don't recalculate it.
+ *
+ *  @param screen        The view
+ *  @param maxIterations The iteration budget of the view, the orbits are
+ *                       calculated until they escape or reach it
+ *  @param cancel        Stops calculating the orbit, may be NULL
+ *  @param data          Passed to cancel
+ *  @return              The references or NULL if memory allocation failed
+ *                       or the orbit was cancelled. Must be freed with freeReferences().
+ */
+
+struct MandelReferences* createReferences(const struct ScreenXY* screen, uint32_t maxIterations,
+                                          ReferenceCancel cancel, const void* data);
+
+/** @brief Frees the references and the orbits no other view uses.
+ *
+ *  @param refs May be NULL.
+ */
+
+void freeReferences(struct MandelReferences* refs);
+
+/** @brief Adds a secondary reference.
+ *
+ *  @param refs      The references of the view
+ *  @param offset_re Offset of the reference to the view center
+ *  @param offset_im Offset of the reference to the view center
+ *  @param cancel    Stops calculating the orbit, may be NULL
+ *  @param data      Passed to cancel
+ *  @return          Index of the new reference or -1 on failure or if the orbit was cancelled
+ */
+
+int addReference(struct MandelReferences* refs, double offset_re, double offset_im,
+                 ReferenceCancel cancel, const void* data);
+
+/** @brief Evaluates the series approximation of the primary reference.
+ *
+ *  @param refs  The references of the view
+ *  @param dc_re Offset of the point to the view center
+ *  @param dc_im Offset of the point to the view center
+ *  @param dz_re The difference to the reference at iteration seriesSkip
+ *  @param dz_im The difference to the reference at iteration seriesSkip
+ */
+
+void evaluateSeries(const struct MandelReferences* refs,
+                    double dc_re, double dc_im,
+                    double* dz_re, double* dz_im);
+
+/** @brief Releases the orbit cached for reuse by the next view.
+ */
+
+void freeReferenceCache(void);
+
+#endif /* PERTURBATION_H */
@@ -0,0 +1,59 @@
+/*  Filename:  pixelformat.c
+ *
+ *  Author:    mandex contributors
+ *  Copyright: (c) 2026 mandex contributors. All rights reserved.
+ *             This work is licensed under the terms of the MIT license.
+ */
+
+#include "pixelformat.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define PIXELFORMAT_X86
+#endif
+
+static void packPixelsScalar(const uint32_t* pixels, uint8_t* bytes, int count, enum PixelOrder order)
+{
+    int first = order == PIXEL_RGB ? 24 : 8;
+    int last = 32 - first;
+    for (int i = 0; i < count; ++i) {
+        bytes[3 * i] = pixels[i] >> first;
+        bytes[3 * i + 1] = pixels[i] >> 16;
+        bytes[3 * i + 2] = pixels[i] >> last;
+    }
+}
+
+#ifdef PIXELFORMAT_X86
+
+#include <immintrin.h>
+
+#define TARGET_SSSE3 __attribute__((target("ssse3")))
+
+// Shuffles 4 pixels to 12 bytes, x86 is little endian so the alpha is the first byte
+TARGET_SSSE3 static void packPixelsSSSE3(const uint32_t* pixels, uint8_t* bytes, int count, enum PixelOrder order)
+{
+    const __m128i shuffle = order == PIXEL_RGB
+        ? _mm_setr_epi8(3, 2, 1, 7, 6, 5, 11, 10, 9, 15, 14, 13, -1, -1, -1, -1)
+        : _mm_setr_epi8(1, 2, 3, 5, 6, 7, 9, 10, 11, 13, 14, 15, -1, -1, -1, -1);
+    int i = 0;
+
+    // each store writes 16 bytes, the last 4 are overwritten by the next one
+    for (; i + 6 <= count; i += 4) {
+        __m128i four = _mm_loadu_si128((const __m128i*)(pixels + i));
+        _mm_storeu_si128((__m128i*)(bytes + 3 * i), _mm_shuffle_epi8(four, shuffle));
+    }
+    packPixelsScalar(pixels + i, bytes + 3 * i, count - i, order);
+}
+
+#endif
+
+void packPixels(const uint32_t* pixels, uint8_t* bytes, int count, enum PixelOrder order)
+{
+#ifdef PIXELFORMAT_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("ssse3")) {
+        packPixelsSSSE3(pixels, bytes, count, order);
+        return;
+    }
+#endif
+    packPixelsScalar(pixels, bytes, count, order);
+}
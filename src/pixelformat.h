@@ -0,0 +1,37 @@
+/** @file        pixelformat.h
+ *
+ *  @brief       Converts the pixels drawn on screen to the bytes of image files.
+ *
+ *  @version     1.0
+ *  @date        10/17/2026
+ *  Revision:    -
+ *
+ *  @author      mandex contributors
+ *  @copyright   Copyright (c) 2026 mandex contributors. All rights reserved.
+ *               This work is licensed under the terms of the MIT license.
+ */
+
+#ifndef PIXELFORMAT_H
+#define PIXELFORMAT_H
+
+#include <stdint.h>
+
+// Order of the color bytes of a packed pixel
+enum PixelOrder {
+    PIXEL_RGB,      // png
+    PIXEL_BGR       // bmp
+};
+
+/** @brief Packs rgba pixels to three bytes each, the alpha is dropped
+ *
+ *         Uses SSSE3 if the cpu has it.
+ *
+ *  @param pixels Pixels in the format of the screen, red in the highest byte
+ *  @param bytes  Receives 3 * count bytes
+ *  @param count  Number of pixels
+ *  @param order  Order of the bytes of a pixel
+ */
+
+void packPixels(const uint32_t* pixels, uint8_t* bytes, int count, enum PixelOrder order);
+
+#endif /* PIXELFORMAT_H */
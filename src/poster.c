@@ -0,0 +1,259 @@
+/*  Filename:  poster.c
+ *
+ *  Author:    mandex contributors
+ *  Copyright: (c) 2026 mandex contributors. All rights reserved.
+ *             This work is licensed under the terms of the MIT license.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <SDL2/SDL.h>
+#include "poster.h"
+#include "savePng.h"
+#include "mandelthread.h"
+
+#define POSTER_MAGIC "MDXPOSTR"
+#define POSTER_VERSION 1
+
+// Width if none is given when the poster is started
+#define POSTER_WIDTH 16384
+
+// Memory of a pixel of a strip: two buffers of points, the frames of the
+// tiles and the copy which is compressed, more for deep zooms
+#define POSTER_PIXEL_BYTES 200
+
+// How often the main thread looks if a strip is complete, in ms
+#define POSTER_POLL_TIME 50
+
+// The poster file, files of other versions or byte orders are not used
+struct PosterFile {
+    char magic[8];
+    uint32_t version;
+    uint32_t maxIterations;
+    BigFix xCenter;
+    BigFix yCenter;
+    double xSpan;               // of the view, the poster shows all of it
+    double ySpan;
+    struct ColorPalette palette;
+
+    // 0 until the poster is started
+    int32_t width;
+    int32_t height;
+    int32_t rowsDone;           // rows in the png file
+    uint32_t adler;             // see struct PngResume
+    uint64_t pngSize;
+};
+
+static int readPosterFile(const char* path, struct PosterFile* poster)
+{
+    FILE* file = fopen(path, "rb");
+    if (!file)
+        return -1;
+    int valid = fread(poster, sizeof(struct PosterFile), 1, file) == 1
+                && memcmp(poster->magic, POSTER_MAGIC, sizeof(poster->magic)) == 0
+                && poster->version == POSTER_VERSION;
+    fclose(file);
+    return valid ? 0 : -1;
+}
+
+// Writes a new file and replaces the old one, so a stop leaves either of them
+static int writePosterFile(const char* path, const struct PosterFile* poster)
+{
+    char tmpPath[FILENAME_MAX];
+    if (snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", path) >= (int)sizeof(tmpPath))
+        return -1;
+    FILE* file = fopen(tmpPath, "wb");
+    if (!file)
+        return -1;
+    int written = fwrite(poster, sizeof(struct PosterFile), 1, file) == 1;
+    if (fclose(file) || !written) {
+        remove(tmpPath);
+        return -1;
+    }
+#ifdef _WIN32
+    // rename doesn't replace files on windows
+    remove(path);
+#endif
+    return rename(tmpPath, path) ? -1 : 0;
+}
+
+int createPoster(const char* path, const struct ScreenXY* view, const struct ColorPalette* palette,
+                 uint32_t maxIterations)
+{
+    struct PosterFile poster;
+    memset(&poster, 0, sizeof(poster));
+    memcpy(poster.magic, POSTER_MAGIC, sizeof(poster.magic));
+    poster.version = POSTER_VERSION;
+    poster.maxIterations = maxIterations;
+    poster.xCenter = view->xCenter;
+    poster.yCenter = view->yCenter;
+    poster.xSpan = view->xSpan;
+    poster.ySpan = view->ySpan;
+    poster.palette = *palette;
+    return writePosterFile(path, &poster);
+}
+
+// The name of the poster file with .png instead of .poster
+static int pngPath(char* png, size_t size, const char* path)
+{
+    size_t length = strlen(path);
+    if (length > 7 && strcmp(path + length - 7, ".poster") == 0)
+        length -= 7;
+    if (length + 5 > size)
+        return -1;
+    memcpy(png, path, length);
+    strcpy(png + length, ".png");
+    return 0;
+}
+
+// The whole image with square pixels, the view fits into it
+static void posterScreen(struct ScreenXY* screen, const struct PosterFile* poster)
+{
+    double mapX = poster->xSpan / poster->width;
+    double mapY = poster->ySpan / poster->height;
+    double map = mapX > mapY ? mapX : mapY;
+    screen->xCenter = poster->xCenter;
+    screen->yCenter = poster->yCenter;
+    screen->xSpan = map * poster->width;
+    screen->ySpan = map * poster->height;
+    screen->width = poster->width;
+    screen->height = poster->height;
+    alignToPixels(screen);
+}
+
+// Rows of a strip whose points fit into memory. The threads align each strip to
+// the pixels, so the center of the strip must lie on a pixel exactly where the
+// one of the poster does: both have an even or both an odd number of rows.
+static int32_t selectStripRows(const struct PosterFile* poster, size_t memory)
+{
+    size_t rows = memory / ((size_t)poster->width * POSTER_PIXEL_BYTES);
+    if (rows > (size_t)poster->height)
+        rows = poster->height;
+    if (rows < 2)
+        rows = 2;
+    if ((rows ^ poster->height) & 1)
+        --rows;
+    return (int32_t)rows;
+}
+
+// Starts the poster with its size on the first call, later the size must stay
+static int selectSize(struct PosterFile* poster, int32_t width, int32_t height)
+{
+    if (poster->width) {
+        if ((width && width != poster->width) || (height && height != poster->height))
+            return -4;
+        return 0;
+    }
+    if (width <= 0)
+        width = POSTER_WIDTH;
+    if (height <= 0)
+        height = (int32_t)(width * poster->ySpan / poster->xSpan + 0.5);
+    if (height <= 0)
+        return -4;
+    poster->width = width;
+    poster->height = height;
+    return 0;
+}
+
+static void printProgress(const struct PosterFile* poster, time_t start)
+{
+    printf("\rPoster: %d of %d rows (%.1f%%), %lds  ", poster->rowsDone, poster->height,
+           100.0 * poster->rowsDone / poster->height, (long)(time(NULL) - start));
+    fflush(stdout);
+}
+
+// Calculates the strips after the rows in the file and adds them to it, the
+// threads calculate the next strip while one is compressed
+static int renderStrips(struct PosterFile* poster, const char* path, PngWriter* writer, size_t memory)
+{
+    struct ScreenXY screen;
+    posterScreen(&screen, poster);
+    int32_t stripRows = selectStripRows(poster, memory);
+    uint32_t* pixels = malloc((size_t)poster->width * stripRows * sizeof(uint32_t));
+    if (!pixels)
+        return -2;
+
+    // the last strip may reach below the poster, the rows below are not written
+    struct ScreenXY strip;
+    partOfScreen(&strip, &screen, 0, poster->rowsDone, poster->width, stripRows);
+    mandelthread_setMaxIterations(poster->maxIterations);
+    mandelthread_setCacheBudget(0);
+    mandelthread_setSpeculation(0.0, 0.0);
+    if (mandelthread_run(&strip, &poster->palette)) {
+        mandelthread_quit();
+        free(pixels);
+        return -2;
+    }
+
+    int error = 0;
+    time_t start = time(NULL);
+    printProgress(poster, start);
+    while (!error && poster->rowsDone < poster->height) {
+        while (!mandelthread_isComplete())
+            SDL_Delay(POSTER_POLL_TIME);
+        const struct MandelTile* rects;
+        mandelthread_takeDirty(&rects);
+        struct MandelTile whole = {0, 0, poster->width, stripRows};
+        mandelthread_copyPixels(&whole, pixels, poster->width);
+
+        int32_t rows = poster->height - poster->rowsDone;
+        if (rows > stripRows)
+            rows = stripRows;
+        if (poster->rowsDone + rows < poster->height) {
+            partOfScreen(&strip, &screen, 0, poster->rowsDone + rows, poster->width, stripRows);
+            changeMandel(&strip);
+        }
+
+        writePNGRows(writer, pixels, poster->width, rows);
+        struct PngResume resume;
+        error = flushPNG(writer, &resume);
+        poster->rowsDone = resume.rows;
+        poster->adler = resume.adler;
+        poster->pngSize = resume.fileSize;
+        if (!error && writePosterFile(path, poster))
+            error = -3;
+        printProgress(poster, start);
+    }
+    printf("\n");
+
+    mandelthread_quit();
+    free(pixels);
+    return error;
+}
+
+int renderPoster(const char* path, int32_t width, int32_t height, size_t memory)
+{
+    struct PosterFile poster;
+    char png[FILENAME_MAX];
+    if (readPosterFile(path, &poster) || pngPath(png, sizeof(png), path))
+        return -1;
+    int error = selectSize(&poster, width, height);
+    if (error)
+        return error;
+
+    // the file is started once its header is in the poster file
+    PngWriter* writer;
+    if (poster.pngSize) {
+        struct PngResume resume = {poster.pngSize, poster.adler, poster.rowsDone};
+        writer = resumePNG(png, poster.width, poster.height, &resume, &error);
+    }
+    else {
+        writer = openPNG(png, poster.width, poster.height, &error);
+        struct PngResume resume;
+        if (writer && !(error = flushPNG(writer, &resume))) {
+            poster.pngSize = resume.fileSize;
+            poster.adler = resume.adler;
+            if (writePosterFile(path, &poster))
+                error = -3;
+        }
+    }
+    if (!writer)
+        return error;
+
+    if (!error && poster.rowsDone < poster.height)
+        error = renderStrips(&poster, path, writer, memory);
+    int closed = closePNG(writer);
+    return error ? error : closed;
+}
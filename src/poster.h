@@ -0,0 +1,55 @@
+/** @file        poster.h
+ *
+ *  @brief       Renders views as png images much larger than the memory would hold.
+ *
+ *               The image is calculated in strips of rows by the threads of the
+ *               explorer, each strip is compressed to the file when it is done.
+ *               A small poster file keeps the view and how far the image got, so
+ *               a render which was stopped continues with the next strip.
+ *
+ *  @version     1.0
+ *  @date        10/17/2026
+ *  Revision:    -
+ *
+ *  @author      mandex contributors
+ *  @copyright   Copyright (c) 2026 mandex contributors. All rights reserved.
+ *               This work is licensed under the terms of the MIT license.
+ */
+
+#ifndef POSTER_H
+#define POSTER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "screen_xy.h"
+#include "color_palette.h"
+
+/** @brief Saves a view to render as poster later
+ *
+ *  @param path          The name or path of the poster file, should end with .poster
+ *  @param view          The view, the poster shows all of it
+ *  @param palette       The color palette
+ *  @param maxIterations The iteration budget of the view
+ *  @return 0 on success, -1 if the file couldn't be written
+ */
+
+int createPoster(const char* path, const struct ScreenXY* view, const struct ColorPalette* palette,
+                 uint32_t maxIterations);
+
+/** @brief Renders a poster file to a png file, or continues where it was stopped
+ *
+ *         The png file has the name of the poster file with .png instead of .poster.
+ *         The poster file is updated after every strip, rendering it again after
+ *         a stop continues from there. Prints the progress.
+ *
+ *  @param path   The name or path of the poster file
+ *  @param width  Width of the image in pixels, 0 for the one it was started with or 16384 pixels
+ *  @param height Height of the image in pixels, 0 to take it from the width and the view
+ *  @param memory Bytes the points of a strip may use
+ *  @return 0 if the image is complete, -1 if the poster file is invalid or a file couldn't be opened,
+ *          -2 if allocation failed, -3 if writing failed, -4 if the size differs from the one it was started with
+ */
+
+int renderPoster(const char* path, int32_t width, int32_t height, size_t memory);
+
+#endif /* POSTER_H */
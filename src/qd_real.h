@@ -0,0 +1,222 @@
+/** @file        qd_real.h
+ *
+ *  @brief       Quad-double arithmetic. A number is the unevaluated sum of four
+ *               doubles, which gives about 212 bits of mantissa.
+ *
+ *               The algorithms are the "sloppy" variants of the QD library by
+ *               Hida, Li and Bailey, which are accurate enough for iterating
+ *               and considerably faster.
+ *
+ *  @version     1.0
+ *  @date        10/17/2026
+ *  Revision:    -
+ *
+ *  @author      mandex contributors
+ *  @copyright   Copyright (c) 2026 mandex contributors. All rights reserved.
+ *               This work is licensed under the terms of the MIT license.
+ */
+
+#ifndef QD_REAL_H
+#define QD_REAL_H
+
+#include "dd_real.h"
+
+/** @brief A quad-double number, x[0] is the most significant part
+ */
+
+typedef struct {
+    double x[4];
+} qd_real;
+
+static inline qd_real qd_from_double(double a)
+{
+    qd_real r = {{ a, 0.0, 0.0, 0.0 }};
+    return r;
+}
+
+static inline double qd_to_double(qd_real a)
+{
+    return a.x[0];
+}
+
+static inline dd_real qd_to_dd(qd_real a)
+{
+    dd_real r;
+    r.hi = quick_two_sum(a.x[0], a.x[1] + a.x[2], &r.lo);
+    return r;
+}
+
+static inline void three_sum(double* a, double* b, double* c)
+{
+    double t1, t2, t3;
+    t1 = two_sum(*a, *b, &t2);
+    *a = two_sum(*c, t1, &t3);
+    *b = two_sum(t2, t3, c);
+}
+
+static inline void three_sum2(double* a, double* b, double* c)
+{
+    double t1, t2, t3;
+    t1 = two_sum(*a, *b, &t2);
+    *a = two_sum(*c, t1, &t3);
+    *b = t2 + t3;
+}
+
+// Renormalises five overlapping parts to four non overlapping ones
+static inline qd_real qd_renorm(double c0, double c1, double c2, double c3, double c4)
+{
+    double s0, s1, s2 = 0.0, s3 = 0.0;
+
+    s0 = quick_two_sum(c3, c4, &c4);
+    s0 = quick_two_sum(c2, s0, &c3);
+    s0 = quick_two_sum(c1, s0, &c2);
+    c0 = quick_two_sum(c0, s0, &c1);
+
+    s0 = c0;
+    s1 = c1;
+    if (s1 != 0.0) {
+        s1 = quick_two_sum(s1, c2, &s2);
+        if (s2 != 0.0) {
+            s2 = quick_two_sum(s2, c3, &s3);
+            if (s3 != 0.0)
+                s3 += c4;
+            else
+                s2 += c4;
+        } else {
+            s1 = quick_two_sum(s1, c3, &s2);
+            if (s2 != 0.0)
+                s2 = quick_two_sum(s2, c4, &s3);
+            else
+                s1 = quick_two_sum(s1, c4, &s2);
+        }
+    } else {
+        s0 = quick_two_sum(s0, c2, &s1);
+        if (s1 != 0.0) {
+            s1 = quick_two_sum(s1, c3, &s2);
+            if (s2 != 0.0)
+                s2 = quick_two_sum(s2, c4, &s3);
+            else
+                s1 = quick_two_sum(s1, c4, &s2);
+        } else {
+            s0 = quick_two_sum(s0, c3, &s1);
+            if (s1 != 0.0)
+                s1 = quick_two_sum(s1, c4, &s2);
+            else
+                s0 = quick_two_sum(s0, c4, &s1);
+        }
+    }
+    qd_real r = {{ s0, s1, s2, s3 }};
+    return r;
+}
+
+static inline qd_real qd_add(qd_real a, qd_real b)
+{
+    double s0, s1, s2, s3;
+    double t0, t1, t2, t3;
+
+    s0 = two_sum(a.x[0], b.x[0], &t0);
+    s1 = two_sum(a.x[1], b.x[1], &t1);
+    s2 = two_sum(a.x[2], b.x[2], &t2);
+    s3 = two_sum(a.x[3], b.x[3], &t3);
+
+    s1 = two_sum(s1, t0, &t0);
+    three_sum(&s2, &t0, &t1);
+    three_sum2(&s3, &t0, &t2);
+    t0 = t0 + t1 + t3;
+
+    return qd_renorm(s0, s1, s2, s3, t0);
+}
+
+static inline qd_real qd_neg(qd_real a)
+{
+    qd_real r = {{ -a.x[0], -a.x[1], -a.x[2], -a.x[3] }};
+    return r;
+}
+
+static inline qd_real qd_sub(qd_real a, qd_real b)
+{
+    return qd_add(a, qd_neg(b));
+}
+
+static inline qd_real qd_add_d(qd_real a, double b)
+{
+    double c0, c1, c2, c3, e;
+    c0 = two_sum(a.x[0], b, &e);
+    c1 = two_sum(a.x[1], e, &e);
+    c2 = two_sum(a.x[2], e, &e);
+    c3 = two_sum(a.x[3], e, &e);
+    return qd_renorm(c0, c1, c2, c3, e);
+}
+
+static inline qd_real qd_mul(qd_real a, qd_real b)
+{
+    double p0, p1, p2, p3, p4, p5;
+    double q0, q1, q2, q3, q4, q5;
+    double t0, t1;
+    double s0, s1, s2;
+
+    p0 = two_prod(a.x[0], b.x[0], &q0);
+
+    p1 = two_prod(a.x[0], b.x[1], &q1);
+    p2 = two_prod(a.x[1], b.x[0], &q2);
+
+    p3 = two_prod(a.x[0], b.x[2], &q3);
+    p4 = two_prod(a.x[1], b.x[1], &q4);
+    p5 = two_prod(a.x[2], b.x[0], &q5);
+
+    three_sum(&p1, &p2, &q0);
+
+    // Six-three sum of p2, q1, q2, p3, p4, p5
+    three_sum(&p2, &q1, &q2);
+    three_sum(&p3, &p4, &p5);
+    s0 = two_sum(p2, p3, &t0);
+    s1 = two_sum(q1, p4, &t1);
+    s2 = q2 + p5;
+    s1 = two_sum(s1, t0, &t0);
+    s2 += (t0 + t1);
+
+    // terms of order eps^3
+    s1 += a.x[0] * b.x[3] + a.x[1] * b.x[2] + a.x[2] * b.x[1] + a.x[3] * b.x[0] + q0 + q3 + q4 + q5;
+
+    return qd_renorm(p0, p1, s0, s1, s2);
+}
+
+static inline qd_real qd_sqr(qd_real a)
+{
+    return qd_mul(a, a);
+}
+
+/** @brief Multiplication with a double
+ */
+
+static inline qd_real qd_mul_d(qd_real a, double b)
+{
+    double p0, p1, p2, p3;
+    double q0, q1, q2;
+    double s0, s1, s2, s3, s4;
+
+    p0 = two_prod(a.x[0], b, &q0);
+    p1 = two_prod(a.x[1], b, &q1);
+    p2 = two_prod(a.x[2], b, &q2);
+    p3 = a.x[3] * b;
+
+    s0 = p0;
+    s1 = two_sum(q0, p1, &s2);
+    three_sum(&s2, &q1, &p2);
+    three_sum2(&q1, &q2, &p3);
+    s3 = q1;
+    s4 = q2 + p2;
+
+    return qd_renorm(s0, s1, s2, s3, s4);
+}
+
+/** @brief Multiplication with a power of two, which is exact
+ */
+
+static inline qd_real qd_mul_pwr2(qd_real a, double b)
+{
+    qd_real r = {{ a.x[0] * b, a.x[1] * b, a.x[2] * b, a.x[3] * b }};
+    return r;
+}
+
+#endif /* QD_REAL_H */
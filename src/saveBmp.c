@@ -1,7 +1,9 @@
 #include <malloc.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <string.h>
 #include "saveBmp.h"
+#include "pixelformat.h"
 
 
 #define SIZE_BMP_HEADER 54 // size without padding
@@ -29,17 +31,6 @@ struct BmpHeader {
     uint32_t numImportantColors;
 };
 
-// for byte access
-typedef union {
-    uint32_t four;
-    struct {
-        uint8_t alpha;
-        uint8_t blue;
-        uint8_t green;
-        uint8_t red;
-    };
-} Pixel;
-
 void writeBMP_header(struct BmpHeader* bmpHeader,
                      int32_t width,
                      int32_t height,
@@ -66,18 +57,16 @@ void writeBMP_header(struct BmpHeader* bmpHeader,
     (*bmpHeader).numImportantColors     = 0;
 }
 
-void writeBMP_body(const Pixel* source,
+void writeBMP_body(const uint32_t* source,
                    uint8_t* target,
                    int32_t width,
                    int32_t height,
                    uint32_t paddedWidth)
 {
     for (int32_t row = 0; row < height; row++) {
-        for (int32_t column = 0; column < width; column++) {
-            target[row * paddedWidth + column * 3]     = source[row * width + column].blue;
-            target[row * paddedWidth + column * 3 + 1] = source[row * width + column].green;
-            target[row * paddedWidth + column * 3 + 2] = source[row * width + column].red;
-        }
+        uint8_t* targetRow = target + (size_t)row * paddedWidth;
+        packPixels(source + (size_t)row * width, targetRow, width, PIXEL_BGR);
+        memset(targetRow + width * 3, 0, paddedWidth - width * 3);
     }
 }
 
@@ -108,29 +97,41 @@ uint8_t* createBMP(const uint32_t* pixels, int32_t width, int32_t height, uint32
 
     writeBMP_header((struct BmpHeader*)bmpBuffer, width, height * y_direction, sizePixelArray);
 
-    writeBMP_body((Pixel*)pixels, bmpBuffer + sizeof(struct BmpHeader), width, height, paddedWidth);
+    writeBMP_body(pixels, bmpBuffer + sizeof(struct BmpHeader), width, height, paddedWidth);
 
     return bmpBuffer;
 }
 
 
+// Written row by row, so only one row is converted at a time
 int saveBMP(const char* filename, const uint32_t* pixels, int32_t width, int32_t height)
 {
+    if (width <= 0 || height == 0 || pixels == NULL)
+        return -2;
+    int32_t rows = height < 0 ? -height : height;
+    uint32_t paddedWidth = roundMultipleOf4(width);
+    struct BmpHeader bmpHeader;
+    writeBMP_header(&bmpHeader, width, height, paddedWidth * rows);
+    uint8_t* row = malloc(paddedWidth);
+    if (row == NULL)
+        return -2;
+
     FILE* f = fopen(filename, "wb");
-    if ( f == NULL )
+    if ( f == NULL ) {
+        free(row);
         return -1;
-    uint32_t bmpSize;
-    uint8_t* bmpBuffer = createBMP(pixels, width, height, &bmpSize);
-    if (bmpBuffer == NULL) {
-        fclose(f);
-        return -2;
     }
-    if (fwrite(bmpBuffer + 2, 1, bmpSize, f) != bmpSize) {  // BMP Data starts with offset two because of alignment
-        fclose(f);
-        free(bmpBuffer);
-        return -3;
+    int result = 0;
+    // BMP Data starts with offset two because of alignment
+    if (fwrite((uint8_t*)&bmpHeader + 2, 1, SIZE_BMP_HEADER, f) != SIZE_BMP_HEADER)
+        result = -3;
+    for (int32_t r = 0; r < rows && result == 0; r++) {
+        writeBMP_body(pixels + (size_t)r * width, row, width, 1, paddedWidth);
+        if (fwrite(row, 1, paddedWidth, f) != paddedWidth)
+            result = -3;
     }
-    fclose(f);
-    free(bmpBuffer);
-    return 0;
+    if (fclose(f) && result == 0)
+        result = -3;
+    free(row);
+    return result;
 }
@@ -25,7 +25,7 @@
  *  @param width      The image width in pixels
  *  @param height     The image height in pixels. Can be negative to invert y-axis
  *
- *  @return 0 on sucess
+ *  @return 0 on sucess, -1 if the file couldn't be created, -2 if allocation failed, -3 if writing failed
  */
 
 int saveBMP(const char* filename, const uint32_t* pixels, int32_t width, int32_t height);
@@ -33,7 +33,7 @@ int saveBMP(const char* filename, const uint32_t* pixels, int32_t width, int32_t
 /** @brief Converts an image from an rgba buffer to bmp file format and loads it
  *         into a malloced buffer
  *
- *  This function is called by saveBMP internally.
+ *  saveBMP writes the same data row by row instead of the whole file at once.
  *  Notice that the bmp data starts at an offset of two bytes
  *  because of alingment reasons.
  *
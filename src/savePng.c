@@ -0,0 +1,517 @@
+/*  Filename:  savePng.c
+ *
+ *  Author:    mandex contributors
+ *  Copyright: (c) 2026 mandex contributors. All rights reserved.
+ *             This work is licensed under the terms of the MIT license.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <SDL2/SDL.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+#include "savePng.h"
+#include "deflate.h"
+#include "pixelformat.h"
+
+// Filtered bytes of a strip, each strip has at least one row
+#define PNG_STRIP_SIZE (1 << 20)
+#define PNG_MAX_THREADS 8
+// Bytes per pixel, 8 bit rgb
+#define PNG_BPP 3
+// Length, type and crc of a chunk and the zlib header in the first one
+#define PNG_CHUNK_OVERHEAD 14
+
+enum PngFilter {
+    FILTER_NONE,
+    FILTER_SUB,
+    FILTER_UP,
+    FILTER_AVERAGE,
+    FILTER_PAETH
+};
+
+struct PngStrip {
+    uint8_t* rgb;           // the row above the strip, then its rows
+    uint8_t* filtered;      // each row starts with its filter
+    uint8_t* chunk;         // IDAT chunk with the compressed rows
+    size_t chunkSize;       // 0 if compressing failed
+    size_t filteredSize;
+    uint32_t adler;         // of the filtered rows
+    int rows;
+    int first;              // starts the zlib stream
+    int noAbove;            // the row above is in the file only, after resumePNG()
+    int last;               // ends it
+    int done;               // compressed, guarded by the lock
+};
+
+struct PngWriter {
+    FILE* file;
+    uint64_t fileSize;      // bytes written to the file
+    int32_t width;
+    int32_t height;
+    int32_t rowsWritten;
+    size_t rowSize;         // bytes of a packed row
+    int stripRows;
+    int fillRows;           // rows of the strip being filled
+    struct PngStrip* strips;
+    int numStrips;
+
+    // strips are numbered from the top, the slot of a strip is its number modulo numStrips
+    int filling;            // strip the rows are packed into
+    int compressing;        // next strip a thread takes
+    int written;            // next strip written to the file
+    uint32_t adler;         // of the strips written
+    int error;
+
+    SDL_Thread* threads[PNG_MAX_THREADS];
+    int numThreads;
+    SDL_mutex* lock;
+    SDL_cond* queued;       // a strip was queued or the writer closes
+    SDL_cond* compressed;   // a strip was compressed
+    int closing;
+};
+
+// crc of png chunks, four bits at a time
+static const uint32_t crcTable[16] = {
+    0x00000000, 0x1db71064, 0x3b6e20c8, 0x26d930ac, 0x76dc4190, 0x6b6b51f4, 0x4db26158, 0x5005713c,
+    0xedb88320, 0xf00f9344, 0xd6d6a3e8, 0xcb61b38c, 0x9b64c2b0, 0x86d3d2d4, 0xa00ae278, 0xbdbdf21c
+};
+
+static uint32_t crcUpdate(uint32_t crc, const uint8_t* data, size_t size)
+{
+    crc = ~crc;
+    while (size--) {
+        crc ^= *data++;
+        crc = crc >> 4 ^ crcTable[crc & 15];
+        crc = crc >> 4 ^ crcTable[crc & 15];
+    }
+    return ~crc;
+}
+
+static inline void putUint32(uint8_t* bytes, uint32_t value)
+{
+    bytes[0] = value >> 24;
+    bytes[1] = value >> 16;
+    bytes[2] = value >> 8;
+    bytes[3] = value;
+}
+
+static void writeChunk(PngWriter* writer, const char* type, const uint8_t* data, uint32_t size)
+{
+    uint8_t header[8];
+    uint8_t crc[4];
+    putUint32(header, size);
+    memcpy(header + 4, type, 4);
+    putUint32(crc, crcUpdate(crcUpdate(0, header + 4, 4), data, size));
+    if (fwrite(header, 1, 8, writer->file) != 8 || (size && fwrite(data, 1, size, writer->file) != size)
+        || fwrite(crc, 1, 4, writer->file) != 4)
+        writer->error = -3;
+    writer->fileSize += size + 12;
+}
+
+static inline uint8_t paeth(uint8_t a, uint8_t b, uint8_t c)
+{
+    int p = a + b - c;
+    int pa = abs(p - a);
+    int pb = abs(p - b);
+    int pc = abs(p - c);
+    if (pa <= pb && pa <= pc)
+        return a;
+    return pb <= pc ? b : c;
+}
+
+// The bytes left of the first pixel and above the first row are 0
+static void applyFilter(enum PngFilter filter, const uint8_t* row, const uint8_t* above, size_t size, uint8_t* out)
+{
+    size_t i = 0;
+    switch (filter) {
+    case FILTER_NONE:
+        memcpy(out, row, size);
+        break;
+    case FILTER_SUB:
+        for (; i < PNG_BPP; ++i)
+            out[i] = row[i];
+        for (; i < size; ++i)
+            out[i] = row[i] - row[i - PNG_BPP];
+        break;
+    case FILTER_UP:
+        for (; i < size; ++i)
+            out[i] = row[i] - above[i];
+        break;
+    case FILTER_AVERAGE:
+        for (; i < PNG_BPP; ++i)
+            out[i] = row[i] - (above[i] >> 1);
+        for (; i < size; ++i)
+            out[i] = row[i] - ((row[i - PNG_BPP] + above[i]) >> 1);
+        break;
+    case FILTER_PAETH:
+        for (; i < PNG_BPP; ++i)
+            out[i] = row[i] - above[i];
+        for (; i < size; ++i)
+            out[i] = row[i] - paeth(row[i - PNG_BPP], above[i], above[i - PNG_BPP]);
+        break;
+    }
+}
+
+// Takes the filter whose bytes are closest to 0 as signed values, which mostly compresses best.
+// Without the row above only the filters which don't use it are tried.
+static void filterRow(const uint8_t* row, const uint8_t* above, size_t size, uint8_t* out, int noAbove)
+{
+    enum PngFilter best = FILTER_NONE;
+    enum PngFilter lastFilter = noAbove ? FILTER_SUB : FILTER_PAETH;
+    uint64_t bestSum = UINT64_MAX;
+    for (enum PngFilter filter = FILTER_NONE; filter <= lastFilter; ++filter) {
+        applyFilter(filter, row, above, size, out + 1);
+        uint64_t sum = 0;
+        for (size_t i = 1; i <= size; ++i)
+            sum += out[i] < 128 ? out[i] : 256 - out[i];
+        if (sum < bestSum) {
+            bestSum = sum;
+            best = filter;
+        }
+    }
+    if (best != lastFilter)
+        applyFilter(best, row, above, size, out + 1);
+    out[0] = best;
+}
+
+static void compressStrip(const PngWriter* writer, struct PngStrip* strip)
+{
+    size_t rowSize = writer->rowSize;
+    for (int r = 0; r < strip->rows; ++r)
+        filterRow(strip->rgb + (r + 1) * rowSize, strip->rgb + r * rowSize, rowSize, strip->filtered + r * (rowSize + 1),
+                  r == 0 && strip->noAbove);
+    strip->filteredSize = strip->rows * (rowSize + 1);
+    strip->adler = adler32Update(ADLER32_INIT, strip->filtered, strip->filteredSize);
+
+    uint8_t* data = strip->chunk + 8;
+    size_t size = 0;
+    if (strip->first) {
+        data[size++] = 0x78;    // deflate with 32 kB window
+        data[size++] = 0x5e;
+    }
+    size_t compressed = deflateStrip(strip->filtered, strip->filteredSize, strip->last, data + size);
+    if (!compressed) {
+        strip->chunkSize = 0;
+        return;
+    }
+    size += compressed;
+    putUint32(strip->chunk, size);
+    memcpy(strip->chunk + 4, "IDAT", 4);
+    putUint32(data + size, crcUpdate(0, strip->chunk + 4, size + 4));
+    strip->chunkSize = size + 12;
+}
+
+static int compressStrips(void* data)
+{
+    PngWriter* writer = data;
+    SDL_LockMutex(writer->lock);
+    for (;;) {
+        while (writer->compressing == writer->filling && !writer->closing)
+            SDL_CondWait(writer->queued, writer->lock);
+        if (writer->compressing == writer->filling)
+            break;
+        struct PngStrip* strip = &writer->strips[writer->compressing++ % writer->numStrips];
+        SDL_UnlockMutex(writer->lock);
+
+        compressStrip(writer, strip);
+
+        SDL_LockMutex(writer->lock);
+        strip->done = 1;
+        SDL_CondSignal(writer->compressed);
+    }
+    SDL_UnlockMutex(writer->lock);
+    return 0;
+}
+
+// Writes the next strip if it is compressed, waits for it if wait is set
+static int writeStrip(PngWriter* writer, int wait)
+{
+    struct PngStrip* strip = &writer->strips[writer->written % writer->numStrips];
+    SDL_LockMutex(writer->lock);
+    while (!strip->done && wait)
+        SDL_CondWait(writer->compressed, writer->lock);
+    int done = strip->done;
+    SDL_UnlockMutex(writer->lock);
+    if (!done)
+        return 0;
+
+    if (!strip->chunkSize)
+        writer->error = -2;
+    else if (!writer->error && fwrite(strip->chunk, 1, strip->chunkSize, writer->file) != strip->chunkSize)
+        writer->error = -3;
+    writer->fileSize += strip->chunkSize;
+    writer->adler = adler32Combine(writer->adler, strip->adler, strip->filteredSize);
+    ++writer->written;
+    return 1;
+}
+
+static void queueStrip(PngWriter* writer, struct PngStrip* strip)
+{
+    strip->rows = writer->fillRows;
+    strip->first = writer->rowsWritten == strip->rows;
+    strip->last = writer->rowsWritten == writer->height;
+    strip->done = 0;
+    writer->fillRows = 0;
+
+    if (writer->numThreads) {
+        SDL_LockMutex(writer->lock);
+        ++writer->filling;
+        SDL_CondSignal(writer->queued);
+        SDL_UnlockMutex(writer->lock);
+    }
+    else {
+        compressStrip(writer, strip);
+        strip->done = 1;
+        ++writer->filling;
+    }
+    while (writer->written < writer->filling && writeStrip(writer, 0))
+        ;
+}
+
+// Stops the threads and frees the writer, the file stays open
+static void freePngWriter(PngWriter* writer)
+{
+    if (writer->numThreads) {
+        SDL_LockMutex(writer->lock);
+        writer->closing = 1;
+        SDL_CondBroadcast(writer->queued);
+        SDL_UnlockMutex(writer->lock);
+        for (int i = 0; i < writer->numThreads; ++i)
+            SDL_WaitThread(writer->threads[i], NULL);
+    }
+    if (writer->compressed)
+        SDL_DestroyCond(writer->compressed);
+    if (writer->queued)
+        SDL_DestroyCond(writer->queued);
+    if (writer->lock)
+        SDL_DestroyMutex(writer->lock);
+    if (writer->strips) {
+        for (int i = 0; i < writer->numStrips; ++i) {
+            free(writer->strips[i].rgb);
+            free(writer->strips[i].filtered);
+            free(writer->strips[i].chunk);
+        }
+    }
+    free(writer->strips);
+    free(writer);
+}
+
+// Allocates the writer and the strips, without the file and the threads
+static PngWriter* createPngWriter(int32_t width, int32_t height, int* error)
+{
+    *error = -2;
+    if (width <= 0 || height <= 0)
+        return NULL;
+    PngWriter* writer = calloc(1, sizeof(PngWriter));
+    if (!writer)
+        return NULL;
+    writer->width = width;
+    writer->height = height;
+    writer->rowSize = (size_t)width * PNG_BPP;
+    writer->stripRows = PNG_STRIP_SIZE / (writer->rowSize + 1);
+    if (writer->stripRows < 1)
+        writer->stripRows = 1;
+    writer->adler = ADLER32_INIT;
+
+    // the threads compress the strips before the one being filled, one more is being written
+    int numThreads = SDL_GetCPUCount();
+    if (numThreads > PNG_MAX_THREADS)
+        numThreads = PNG_MAX_THREADS;
+    writer->numStrips = numThreads + 2;
+    writer->strips = calloc(writer->numStrips, sizeof(struct PngStrip));
+    writer->lock = SDL_CreateMutex();
+    writer->queued = SDL_CreateCond();
+    writer->compressed = SDL_CreateCond();
+    if (!writer->strips || !writer->lock || !writer->queued || !writer->compressed) {
+        freePngWriter(writer);
+        return NULL;
+    }
+    size_t filteredSize = writer->stripRows * (writer->rowSize + 1);
+    for (int i = 0; i < writer->numStrips; ++i) {
+        struct PngStrip* strip = &writer->strips[i];
+        strip->rgb = malloc((writer->stripRows + 1) * writer->rowSize);
+        strip->filtered = malloc(filteredSize);
+        strip->chunk = malloc(deflateStripBound(filteredSize) + PNG_CHUNK_OVERHEAD);
+        if (!strip->rgb || !strip->filtered || !strip->chunk) {
+            freePngWriter(writer);
+            return NULL;
+        }
+    }
+    return writer;
+}
+
+// Starts the threads once the file is open
+static PngWriter* startPngWriter(PngWriter* writer, int* error)
+{
+    // without threads the strips are compressed when they are full
+    for (int i = 0; i < writer->numStrips - 2; ++i) {
+        writer->threads[i] = SDL_CreateThread(compressStrips, "pngwriter", writer);
+        if (!writer->threads[i])
+            break;
+        ++writer->numThreads;
+    }
+    *error = 0;
+    return writer;
+}
+
+PngWriter* openPNG(const char* filename, int32_t width, int32_t height, int* error)
+{
+    PngWriter* writer = createPngWriter(width, height, error);
+    if (!writer)
+        return NULL;
+    writer->file = fopen(filename, "wb");
+    if (!writer->file) {
+        *error = -1;
+        freePngWriter(writer);
+        return NULL;
+    }
+    static const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+    uint8_t header[13];
+    putUint32(header, width);
+    putUint32(header + 4, height);
+    header[8] = 8;      // bits per channel
+    header[9] = 2;      // rgb
+    header[10] = 0;     // deflate
+    header[11] = 0;     // filter per row
+    header[12] = 0;     // not interlaced
+    if (fwrite(signature, 1, sizeof(signature), writer->file) != sizeof(signature))
+        writer->error = -3;
+    writer->fileSize = sizeof(signature);
+    writeChunk(writer, "IHDR", header, sizeof(header));
+    return startPngWriter(writer, error);
+}
+
+// Cuts the file to size, fails if it is shorter
+static int truncateFile(const char* filename, uint64_t size)
+{
+#ifdef _WIN32
+    HANDLE file = CreateFileA(filename, GENERIC_READ | GENERIC_WRITE, 0, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+        return -1;
+    LARGE_INTEGER fileSize;
+    LARGE_INTEGER end;
+    end.QuadPart = size;
+    int ok = GetFileSizeEx(file, &fileSize) && (uint64_t)fileSize.QuadPart >= size
+             && SetFilePointerEx(file, end, NULL, FILE_BEGIN) && SetEndOfFile(file);
+    CloseHandle(file);
+    return ok ? 0 : -1;
+#else
+    FILE* file = fopen(filename, "rb");
+    if (!file)
+        return -1;
+    int shorter = fseeko(file, 0, SEEK_END) || (uint64_t)ftello(file) < size;
+    fclose(file);
+    if (shorter || truncate(filename, size))
+        return -1;
+    return 0;
+#endif
+}
+
+PngWriter* resumePNG(const char* filename, int32_t width, int32_t height, const struct PngResume* resume, int* error)
+{
+    if (resume->rows < 0 || resume->rows > height) {
+        *error = -1;
+        return NULL;
+    }
+    PngWriter* writer = createPngWriter(width, height, error);
+    if (!writer)
+        return NULL;
+    if (truncateFile(filename, resume->fileSize) || !(writer->file = fopen(filename, "ab"))) {
+        *error = -1;
+        freePngWriter(writer);
+        return NULL;
+    }
+    writer->fileSize = resume->fileSize;
+    writer->rowsWritten = resume->rows;
+    writer->adler = resume->adler;
+    return startPngWriter(writer, error);
+}
+
+void writePNGRows(PngWriter* writer, const uint32_t* pixels, int pitch, int32_t rows)
+{
+    for (int32_t r = 0; r < rows && writer->rowsWritten < writer->height; ++r) {
+        struct PngStrip* strip = &writer->strips[writer->filling % writer->numStrips];
+        if (!writer->fillRows) {
+            // the strip which had the slot before must be written
+            while (writer->filling - writer->written >= writer->numStrips)
+                writeStrip(writer, 1);
+            if (writer->filling) {
+                const struct PngStrip* above = &writer->strips[(writer->filling - 1) % writer->numStrips];
+                memcpy(strip->rgb, above->rgb + above->rows * writer->rowSize, writer->rowSize);
+                strip->noAbove = 0;
+            }
+            else {
+                memset(strip->rgb, 0, writer->rowSize);
+                strip->noAbove = writer->rowsWritten > 0;
+            }
+        }
+
+        packPixels(pixels + (ptrdiff_t)r * pitch, strip->rgb + (writer->fillRows + 1) * writer->rowSize,
+                   writer->width, PIXEL_RGB);
+        ++writer->fillRows;
+        ++writer->rowsWritten;
+        if (writer->fillRows == writer->stripRows || writer->rowsWritten == writer->height)
+            queueStrip(writer, strip);
+    }
+}
+
+int flushPNG(PngWriter* writer, struct PngResume* resume)
+{
+    if (writer->fillRows)
+        queueStrip(writer, &writer->strips[writer->filling % writer->numStrips]);
+    while (writer->written < writer->filling)
+        writeStrip(writer, 1);
+    if (fflush(writer->file) && !writer->error)
+        writer->error = -3;
+
+    resume->fileSize = writer->fileSize;
+    resume->adler = writer->adler;
+    resume->rows = writer->rowsWritten;
+    return writer->error;
+}
+
+int closePNG(PngWriter* writer)
+{
+    if (!writer)
+        return 0;
+    while (writer->written < writer->filling)
+        writeStrip(writer, 1);
+
+    if (writer->rowsWritten < writer->height) {
+        writer->error = -3;
+    }
+    else {
+        uint8_t adler[4];
+        putUint32(adler, writer->adler);
+        writeChunk(writer, "IDAT", adler, sizeof(adler));
+        writeChunk(writer, "IEND", NULL, 0);
+    }
+    if (fclose(writer->file) && !writer->error)
+        writer->error = -3;
+
+    int error = writer->error;
+    freePngWriter(writer);
+    return error;
+}
+
+int savePNG(const char* filename, const uint32_t* pixels, int32_t width, int32_t height)
+{
+    if (pixels == NULL)
+        return -2;
+    int error;
+    int32_t rows = height < 0 ? -height : height;
+    PngWriter* writer = openPNG(filename, width, rows, &error);
+    if (!writer)
+        return error;
+
+    if (height < 0)
+        writePNGRows(writer, pixels, width, rows);
+    else
+        writePNGRows(writer, pixels + (size_t)(rows - 1) * width, -width, rows);
+    return closePNG(writer);
+}
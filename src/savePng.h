@@ -0,0 +1,105 @@
+/** @file        savePng.h
+ *
+ *  @brief       Saves images as png files, compressed by several threads.
+ *
+ *               The rows are packed and handed to the threads in strips, which
+ *               filter and compress them on their own. The compressed strips
+ *               are written in order as soon as they are done, so only a few
+ *               strips are in memory however large the image is.
+ *
+ *  @version     1.0
+ *  @date        10/17/2026
+ *  Revision:    -
+ *
+ *  @author      mandex contributors
+ *  @copyright   Copyright (c) 2026 mandex contributors. All rights reserved.
+ *               This work is licensed under the terms of the MIT license.
+ */
+
+#ifndef SAVEPNG_H
+#define SAVEPNG_H
+
+#include <stdint.h>
+
+typedef struct PngWriter PngWriter;
+
+// Where a png file can be continued, see flushPNG()
+struct PngResume {
+    uint64_t fileSize;  // bytes of the file up to the rows written
+    uint32_t adler;     // checksum of the compressed rows
+    int32_t rows;       // number of rows written
+};
+
+/** @brief Creates a png file and starts the threads which compress it
+ *
+ *  @param filename The name or path of the file
+ *  @param width    The image width in pixels
+ *  @param height   The image height in pixels
+ *  @param error    Receives -1 if the file couldn't be created, -2 if allocation failed or the size is 0
+ *  @return Pointer to the writer, NULL on error. Must be closed with closePNG().
+ */
+
+PngWriter* openPNG(const char* filename, int32_t width, int32_t height, int* error);
+
+/** @brief Continues a png file which was not closed, e.g. because the program was stopped
+ *
+ *         The file is cut to the size it had when flushPNG() returned resume.
+ *         The next rows are written as if the file had not been closed.
+ *
+ *  @param filename The name or path of the file
+ *  @param width    The image width in pixels, as it was opened with
+ *  @param height   The image height in pixels, as it was opened with
+ *  @param resume   Returned by flushPNG() before
+ *  @param error    Receives -1 if the file couldn't be opened or is shorter, -2 if allocation failed
+ *  @return Pointer to the writer, NULL on error. Must be closed with closePNG().
+ */
+
+PngWriter* resumePNG(const char* filename, int32_t width, int32_t height, const struct PngResume* resume, int* error);
+
+/** @brief Adds rows to the image, from the top down
+ *
+ *         Waits only if the threads are behind by more strips than there are threads.
+ *
+ *  @param writer
+ *  @param pixels The pixels of the first row, rgba as on screen
+ *  @param pitch  Pixels from one row to the next, negative for rows from the bottom up
+ *  @param rows   Number of rows, all rows together must not be more than the height
+ */
+
+void writePNGRows(PngWriter* writer, const uint32_t* pixels, int pitch, int32_t rows);
+
+/** @brief Writes all rows added so far to the file
+ *
+ *         Waits until the threads compressed them. The file can be continued
+ *         from here with resumePNG(), whatever happens to the program later.
+ *
+ *  @param writer
+ *  @param resume Receives where the file can be continued
+ *  @return 0 if the rows were written, -2 if allocation failed, -3 if writing failed
+ */
+
+int flushPNG(PngWriter* writer, struct PngResume* resume);
+
+/** @brief Writes the rest of the image and closes the file
+ *
+ *  @param writer May be NULL.
+ *  @return 0 if the whole image was written, -2 if allocation failed, -3 if writing failed or rows were missing
+ */
+
+int closePNG(PngWriter* writer);
+
+/** @brief Converts an image from an rgba buffer to png file format and saves it.
+ *
+ *  If height is negative the y-axis starts at the top of the screen and increases downwards.
+ *
+ *  @param filename   The name or path of the file.
+ *  @param pixels     Array of pixels containing the image.
+ *  @param width      The image width in pixels
+ *  @param height     The image height in pixels. Can be negative to invert y-axis
+ *
+ *  @return 0 on sucess, -1 if the file couldn't be created, -2 if allocation failed, -3 if writing failed
+ */
+
+int savePNG(const char* filename, const uint32_t* pixels, int32_t width, int32_t height);
+
+#endif /* SAVEPNG_H */
@@ -5,53 +5,113 @@
  *             This work is licensed under the terms of the MIT license.
  */
 
+#include <string.h>
 #include "screen_xy.h"
 
 
+double pixelSpacing(const struct ScreenXY* screen)
+{
+    double mapX = screen->xSpan / (double)screen->width;
+    double mapY = screen->ySpan / (double)screen->height;
+    return mapX < mapY ? mapX : mapY;
+}
+
+// Moves are rounded to whole pixels, so the points which stay on
+// the screen keep their value and don't need to be calculated again
+static double snapToPixels(double span, int pixels, double rate)
+{
+    return movePixels(pixels, rate) * (span / pixels);
+}
+
+int movePixels(int pixels, double rate)
+{
+    int steps = (int)(rate * pixels + 0.5);
+    return steps < 1 ? 1 : steps;
+}
+
 void moveUp(struct ScreenXY* screen, double rate)
 {
-    double temp = (screen->yMax - screen->yMin) * rate;
-    screen->yMax -= temp;
-    screen->yMin -= temp;
+    bigfixAddDouble(&screen->yCenter, &screen->yCenter, -snapToPixels(screen->ySpan, screen->height, rate));
 }
 
 void moveDown(struct ScreenXY* screen, double rate)
 {
-    double temp = (screen->yMax - screen->yMin) * rate;
-    screen->yMax += temp;
-    screen->yMin += temp;
+    bigfixAddDouble(&screen->yCenter, &screen->yCenter, snapToPixels(screen->ySpan, screen->height, rate));
 }
 
 void moveLeft(struct ScreenXY* screen, double rate)
 {
-    double temp = (screen->xMax - screen->xMin) * rate;
-    screen->xMax -= temp;
-    screen->xMin -= temp;
+    bigfixAddDouble(&screen->xCenter, &screen->xCenter, -snapToPixels(screen->xSpan, screen->width, rate));
 }
 
 void moveRight(struct ScreenXY* screen, double rate)
 {
-    double temp = (screen->xMax - screen->xMin) * rate;
-    screen->xMax += temp;
-    screen->xMin += temp;
+    bigfixAddDouble(&screen->xCenter, &screen->xCenter, snapToPixels(screen->xSpan, screen->width, rate));
 }
 
 void zoomIn(struct ScreenXY* screen, double rate)
 {
-    double temp = (screen->xMax - screen->xMin) * rate;
-    screen->xMax -= temp;
-    screen->xMin += temp;
-    temp = (screen->yMax - screen->yMin) * rate;
-    screen->yMax -= temp;
-    screen->yMin += temp;
+    screen->xSpan *= 1.0 - 2.0 * rate;
+    screen->ySpan *= 1.0 - 2.0 * rate;
 }
 
 void zoomOut(struct ScreenXY* screen, double rate)
 {
-    double temp = (screen->xMax - screen->xMin) * rate;
-    screen->xMax += temp;
-    screen->xMin -= temp;
-    temp = (screen->yMax - screen->yMin) * rate;
-    screen->yMax += temp;
-    screen->yMin -= temp;
+    screen->xSpan /= 1.0 - 2.0 * rate;
+    screen->ySpan /= 1.0 - 2.0 * rate;
+}
+
+void partOfScreen(struct ScreenXY* part, const struct ScreenXY* screen, int x, int y, int width, int height)
+{
+    double mapX = screen->xSpan / screen->width;
+    double mapY = screen->ySpan / screen->height;
+    bigfixAddDouble(&part->xCenter, &screen->xCenter, (x + 0.5 * width - 0.5 * screen->width) * mapX);
+    bigfixAddDouble(&part->yCenter, &screen->yCenter, (y + 0.5 * height - 0.5 * screen->height) * mapY);
+    part->xSpan = width * mapX;
+    part->ySpan = height * mapY;
+    part->width = width;
+    part->height = height;
+}
+
+// Pixel size rounded to 32 bits of mantissa, like the levels of the grid
+static double gridPixelSize(double map)
+{
+    uint64_t bits;
+    memcpy(&bits, &map, sizeof(bits));
+    bits = (bits + (1u << 19)) >> 20 << 20;
+    memcpy(&map, &bits, sizeof(map));
+    return map;
+}
+
+// FNV-1a of the limbs of the region, the bits of the offset are cleared
+static uint64_t hashRegion(uint32_t* multiple)
+{
+    multiple[BIGFIX_LIMBS - 1] = 0;
+    multiple[BIGFIX_LIMBS - 2] &= ~((1u << (GRID_REGION_BITS - 32)) - 1);
+    uint64_t hash = 14695981039346656037u;
+    for (int i = 0; i < BIGFIX_LIMBS; ++i)
+        hash = (hash ^ multiple[i]) * 1099511628211u;
+    return hash;
+}
+
+int snapToGrid(BigFix* center, double map, struct GridPosition* position)
+{
+    uint32_t multiple[BIGFIX_LIMBS];
+    double distance;
+    BigFix snapped;
+    if (!bigfixRoundToMultiple(&snapped, center, gridPixelSize(map), multiple, &distance))
+        return 0;
+    *center = snapped;
+    if (position) {
+        position->offset = (int64_t)(multiple[BIGFIX_LIMBS - 2] & ((1u << (GRID_REGION_BITS - 32)) - 1)) << 32
+                           | multiple[BIGFIX_LIMBS - 1];
+        position->region = hashRegion(multiple);
+    }
+    return distance > -1e-3 && distance < 1e-3;
+}
+
+void alignToPixels(struct ScreenXY* screen)
+{
+    snapToGrid(&screen->xCenter, screen->xSpan / screen->width, NULL);
+    snapToGrid(&screen->yCenter, screen->ySpan / screen->height, NULL);
 }
@@ -13,19 +13,35 @@
 
 #ifndef SCREEN_XY_H
 
+#include "bigfix.h"
+
 /** @brief Information about how pixels are mapped to xy coordinates
+ *
+ *  The center is stored in fixed point with enough limbs for any zoom depth, so it
+ *  can be moved by amounts far below the precision of double when zoomed in deeply.
+ *  The span only needs to be relatively precise and stays a double.
  */
 
 struct ScreenXY {
-    double xMin;
-    double xMax;
-    double yMin;
-    double yMax;
+    BigFix xCenter;
+    BigFix yCenter;
+    double xSpan;       // displayed width in the xy-plane
+    double ySpan;       // displayed height in the xy-plane
     int width;
     int height;
 };
 
+/** @brief Returns the distance between two neighbouring pixels in the xy-plane
+ *
+ *  @param screen The screen
+ *  @return       The smaller distance of x and y direction
+ */
+
+double pixelSpacing(const struct ScreenXY* screen);
+
 /** @brief Moves up in xy-plane by a percentage of the displayed span
+ *
+ *         The move is rounded to whole pixels, at least one.
  *
  *  @param screen The screen to modify
  *  @param rate   The move rate in percent
@@ -35,6 +51,8 @@ struct ScreenXY {
 void moveUp(struct ScreenXY* screen, double rate);
 
 /** @brief Moves down in xy-plane by a percentage of the displayed span
+ *
+ *         The move is rounded to whole pixels, at least one.
  *
  *  @param screen The screen to modify
  *  @param rate   The move rate in percent
@@ -44,6 +62,8 @@ void moveUp(struct ScreenXY* screen, double rate);
 void moveDown(struct ScreenXY* screen, double rate);
 
 /** @brief Moves left in xy-plane by a percentage of the displayed span
+ *
+ *         The move is rounded to whole pixels, at least one.
  *
  *  @param screen The screen to modify
  *  @param rate   The move rate in percent
@@ -53,6 +73,8 @@ void moveDown(struct ScreenXY* screen, double rate);
 void moveLeft(struct ScreenXY* screen, double rate);
 
 /** @brief Moves right in xy-plane by a percentage of the displayed span
+ *
+ *         The move is rounded to whole pixels, at least one.
  *
  *  @param screen The screen to modify
  *  @param rate   The move rate in percent
@@ -69,7 +91,9 @@ void moveRight(struct ScreenXY* screen, double rate);
 
 void zoomIn(struct ScreenXY* screen, double rate);
 
-/** @brief Zooms in the xy-plane by a percantage of the displayed span
+/** @brief Zooms out in the xy-plane by a percantage of the displayed span
+ *
+ *         Undoes zoomIn() with the same rate, so both lead back to the same depth.
  *
  *  @param screen The screen to modify
  *  @param rate   The zoom rate in percent
@@ -78,5 +102,69 @@ void zoomIn(struct ScreenXY* screen, double rate);
 
 void zoomOut(struct ScreenXY* screen, double rate);
 
+/** @brief Returns how many pixels a move by a percentage of the displayed span moves
+ *
+ *  @param pixels Width or height of the screen in pixels
+ *  @param rate   The move rate in percent
+ *  @return       The rounded move, at least one pixel
+ */
+
+int movePixels(int pixels, double rate);
+
+/** @brief Returns the part of the screen covered by a rectangle of its pixels
+ *
+ *         The pixels of the part lie on the pixels of the screen.
+ *
+ *  @param part   Receives the part
+ *  @param screen The screen
+ *  @param x      Left column of the rectangle
+ *  @param y      Top row of the rectangle
+ *  @param width  Width of the rectangle in pixels
+ *  @param height Height of the rectangle in pixels
+ *  @return
+ */
+
+void partOfScreen(struct ScreenXY* part, const struct ScreenXY* screen, int x, int y, int width, int height);
+
+/** @brief Where a center lies on the grid of a pixel size
+ *
+ *         Zoomed in deeply a position has far more bits than an integer, so it is
+ *         split into the region of 2^GRID_REGION_BITS pixels which contains it, of
+ *         which only a hash is kept, and the offset of the position in the region.
+ */
+
+#define GRID_REGION_BITS 40
+
+struct GridPosition {
+    uint64_t region;    // hash of the region
+    int64_t offset;     // pixels from the start of the region
+};
+
+/** @brief Moves a center to the nearest point of the grid of a pixel size
+ *
+ *         The grid has the pixel size rounded to 32 bits of mantissa, so screens
+ *         whose pixel sizes differ only by rounding share it. It is calculated
+ *         exactly however deep the zoom. Centers finer than BigFix resolves are
+ *         left as they are.
+ *
+ *  @param center   The center to modify
+ *  @param map      The pixel size
+ *  @param position Receives the position on the grid, may be NULL
+ *  @return 1 if the center lay on the grid already, else 0
+ */
+
+int snapToGrid(BigFix* center, double map, struct GridPosition* position);
+
+/** @brief Moves the center to the nearest point of the grid of its pixel size
+ *
+ *         The pixels of all screens with the same pixel size then lie on one
+ *         grid. Moves by less than half a pixel, see snapToGrid().
+ *
+ *  @param screen The screen to modify
+ *  @return
+ */
+
+void alignToPixels(struct ScreenXY* screen);
+
 #define SCREEN_XY_H
 #endif /* SCREEN_XY_H */
@@ -0,0 +1,265 @@
+/*  Filename:  tilecache.c
+ *
+ *  Author:    mandex contributors
+ *  Copyright: (c) 2026 mandex contributors. All rights reserved.
+ *             This work is licensed under the terms of the MIT license.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "tilecache.h"
+
+struct CacheEntry {
+    struct TileKey key;
+    struct CacheEntry* next;    // in the same bucket
+    struct CacheEntry* newer;   // in the order of use
+    struct CacheEntry* older;
+    uint32_t values[CACHE_TILE_SIZE * CACHE_TILE_SIZE];
+    uint8_t smooth[CACHE_TILE_SIZE * CACHE_TILE_SIZE];
+};
+
+struct TileCache {
+    struct CacheEntry** buckets;
+    size_t numBuckets;          // power of two
+    size_t numEntries;
+    size_t maxEntries;
+
+    // used most recently first
+    struct CacheEntry* newest;
+    struct CacheEntry* oldest;
+
+    // a tile which turned out not to be done, reused for the next one
+    struct CacheEntry* spare;
+
+    // keeps the tiles across sessions, may be NULL
+    TileStore* store;
+
+    uint64_t hits;
+    uint64_t misses;
+};
+
+TileCache* createTileCache(size_t budget)
+{
+    TileCache* cache = calloc(1, sizeof(TileCache));
+    if (!cache)
+        return NULL;
+
+    cache->maxEntries = budget / sizeof(struct CacheEntry);
+    cache->numBuckets = 256;
+    while (cache->numBuckets < cache->maxEntries)
+        cache->numBuckets *= 2;
+    cache->buckets = calloc(cache->numBuckets, sizeof(struct CacheEntry*));
+    if (!cache->buckets) {
+        free(cache);
+        return NULL;
+    }
+    return cache;
+}
+
+void freeTileCache(TileCache* cache)
+{
+    if (!cache)
+        return;
+    struct CacheEntry* entry = cache->newest;
+    while (entry) {
+        struct CacheEntry* older = entry->older;
+        free(entry);
+        entry = older;
+    }
+    free(cache->spare);
+    free(cache->buckets);
+    free(cache);
+}
+
+static struct CacheEntry** findSlot(TileCache* cache, const struct TileKey* key)
+{
+    struct CacheEntry** slot = &cache->buckets[hashTileKey(key) & (cache->numBuckets - 1)];
+    while (*slot && !sameTileKey(&(*slot)->key, key))
+        slot = &(*slot)->next;
+    return slot;
+}
+
+static void unlinkUse(TileCache* cache, struct CacheEntry* entry)
+{
+    if (entry->newer)
+        entry->newer->older = entry->older;
+    else
+        cache->newest = entry->older;
+    if (entry->older)
+        entry->older->newer = entry->newer;
+    else
+        cache->oldest = entry->newer;
+}
+
+static void linkNewest(TileCache* cache, struct CacheEntry* entry)
+{
+    entry->newer = NULL;
+    entry->older = cache->newest;
+    if (cache->newest)
+        cache->newest->newer = entry;
+    else
+        cache->oldest = entry;
+    cache->newest = entry;
+}
+
+// Takes the tile used least recently out of the cache
+static struct CacheEntry* evictOldest(TileCache* cache)
+{
+    struct CacheEntry* entry = cache->oldest;
+    *findSlot(cache, &entry->key) = entry->next;
+    unlinkUse(cache, entry);
+    --cache->numEntries;
+    return entry;
+}
+
+// A tile to fill, NULL if the budget allows none
+static struct CacheEntry* takeEntry(TileCache* cache)
+{
+    struct CacheEntry* entry = cache->spare;
+    cache->spare = NULL;
+    if (!entry && cache->numEntries >= cache->maxEntries && cache->oldest)
+        entry = evictOldest(cache);
+    if (!entry && cache->numEntries < cache->maxEntries)
+        entry = malloc(sizeof(struct CacheEntry));
+    return entry;
+}
+
+static void insertEntry(TileCache* cache, struct CacheEntry* entry, const struct TileKey* key)
+{
+    // the slot may have moved if the evicted tile was in the same bucket
+    entry->key = *key;
+    entry->next = NULL;
+    *findSlot(cache, key) = entry;
+    linkNewest(cache, entry);
+    ++cache->numEntries;
+}
+
+// Tile which contains a column or row of the grid
+static int64_t floorTile(int64_t pixel)
+{
+    return pixel >= 0 ? pixel / CACHE_TILE_SIZE : -((-pixel + CACHE_TILE_SIZE - 1) / CACHE_TILE_SIZE);
+}
+
+static void initKey(struct TileKey* key, const struct MandelGrid* grid)
+{
+    key->levelX = grid->levelX;
+    key->levelY = grid->levelY;
+    key->precision = grid->precision;
+    key->maxIterations = grid->maxIterations;
+    key->regionX = grid->regionX;
+    key->regionY = grid->regionY;
+}
+
+void storeCacheTiles(TileCache* cache, const MandelPoint* points, const struct MandelTile* rect)
+{
+    struct MandelGrid grid;
+    if (!cache->maxEntries || !getMandelGrid(points, &grid))
+        return;
+
+    struct TileKey key;
+    initKey(&key, &grid);
+    // tiles which begin in rect and end on the points
+    int64_t firstX = floorTile(grid.x + rect->x + CACHE_TILE_SIZE - 1);
+    int64_t firstY = floorTile(grid.y + rect->y + CACHE_TILE_SIZE - 1);
+    int64_t endX = floorTile(grid.x + rect->x + rect->width + CACHE_TILE_SIZE - 1);
+    int64_t endY = floorTile(grid.y + rect->y + rect->height + CACHE_TILE_SIZE - 1);
+    if (endX > floorTile(grid.x + grid.width))
+        endX = floorTile(grid.x + grid.width);
+    if (endY > floorTile(grid.y + grid.height))
+        endY = floorTile(grid.y + grid.height);
+    for (key.y = firstY; key.y < endY; ++key.y) {
+        for (key.x = firstX; key.x < endX; ++key.x) {
+            struct CacheEntry** slot = findSlot(cache, &key);
+            if (*slot) {
+                unlinkUse(cache, *slot);
+                linkNewest(cache, *slot);
+                continue;
+            }
+
+            struct CacheEntry* entry = takeEntry(cache);
+            if (!entry)
+                return;
+            struct MandelTile block = {
+                (int)(key.x * CACHE_TILE_SIZE - grid.x), (int)(key.y * CACHE_TILE_SIZE - grid.y),
+                CACHE_TILE_SIZE, CACHE_TILE_SIZE
+            };
+            if (!readMandelBlock(points, &block, entry->values, entry->smooth, CACHE_TILE_SIZE)) {
+                cache->spare = entry;
+                continue;
+            }
+
+            insertEntry(cache, entry, &key);
+            if (cache->store)
+                writeStoreTile(cache->store, &key, entry->values, entry->smooth);
+        }
+    }
+}
+
+int loadCacheTiles(TileCache* cache, MandelPoint* points, const struct MandelTile* rect)
+{
+    struct MandelGrid grid;
+    if (!cache->maxEntries || !getMandelGrid(points, &grid))
+        return 0;
+
+    struct TileKey key;
+    initKey(&key, &grid);
+    int loaded = 0;
+    uint32_t stored[CACHE_TILE_SIZE * CACHE_TILE_SIZE];
+    uint8_t storedSmooth[CACHE_TILE_SIZE * CACHE_TILE_SIZE];
+    int right = rect->x + rect->width;
+    int bottom = rect->y + rect->height;
+    int64_t endX = floorTile(grid.x + right - 1) + 1;
+    int64_t endY = floorTile(grid.y + bottom - 1) + 1;
+    for (key.y = floorTile(grid.y + rect->y); key.y < endY; ++key.y) {
+        for (key.x = floorTile(grid.x + rect->x); key.x < endX; ++key.x) {
+            // the part of the tile in rect
+            int left = (int)(key.x * CACHE_TILE_SIZE - grid.x);
+            int top = (int)(key.y * CACHE_TILE_SIZE - grid.y);
+            struct MandelTile block = {left < rect->x ? rect->x : left, top < rect->y ? rect->y : top, 0, 0};
+            block.width = (left + CACHE_TILE_SIZE < right ? left + CACHE_TILE_SIZE : right) - block.x;
+            block.height = (top + CACHE_TILE_SIZE < bottom ? top + CACHE_TILE_SIZE : bottom) - block.y;
+            if (readMandelBlock(points, &block, NULL, NULL, 0))
+                continue;
+
+            struct CacheEntry* entry = *findSlot(cache, &key);
+            if (entry) {
+                unlinkUse(cache, entry);
+                linkNewest(cache, entry);
+            } else if (cache->store && readStoreTile(cache->store, &key, stored, storedSmooth)) {
+                // no tile of the cache is dropped for tiles which are not stored
+                entry = takeEntry(cache);
+                if (entry) {
+                    memcpy(entry->values, stored, sizeof(stored));
+                    memcpy(entry->smooth, storedSmooth, sizeof(storedSmooth));
+                    insertEntry(cache, entry, &key);
+                }
+            }
+            if (!entry) {
+                ++cache->misses;
+                continue;
+            }
+            ++cache->hits;
+            int offset = (block.y - top) * CACHE_TILE_SIZE + (block.x - left);
+            loaded += writeMandelBlock(points, &block, entry->values + offset, entry->smooth + offset, CACHE_TILE_SIZE);
+        }
+    }
+    return loaded;
+}
+
+void setTileCacheStore(TileCache* cache, TileStore* store)
+{
+    cache->store = store;
+}
+
+void clearTileCache(TileCache* cache)
+{
+    while (cache->oldest)
+        free(evictOldest(cache));
+}
+
+void getTileCacheStats(const TileCache* cache, uint64_t* hits, uint64_t* misses, size_t* bytes)
+{
+    *hits = cache->hits;
+    *misses = cache->misses;
+    *bytes = cache->numEntries * sizeof(struct CacheEntry);
+}
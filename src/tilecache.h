@@ -0,0 +1,99 @@
+/** @file        tilecache.h
+ *
+ *  @brief       Keeps the results of views calculated before.
+ *
+ *               The results are stored in tiles of a grid for every zoom depth,
+ *               keyed by the depth and the position of the tile on the grid, so
+ *               views which come back to a place reuse them. The tiles used least
+ *               recently are dropped when the cache grows over its memory budget.
+ *
+ *  @version     1.0
+ *  @date        10/17/2026
+ *  Revision:    -
+ *
+ *  @author      mandex contributors
+ *  @copyright   Copyright (c) 2026 mandex contributors. All rights reserved.
+ *               This work is licensed under the terms of the MIT license.
+ */
+
+#ifndef TILECACHE_H
+#define TILECACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "mandelbrot.h"
+#include "tilestore.h"
+
+typedef struct TileCache TileCache;
+
+/** @brief Creates an empty cache
+ *
+ *  @param budget Memory the tiles may use in bytes
+ *  @return Pointer to the cache, NULL if allocation failed. Must be freed with freeTileCache().
+ */
+
+TileCache* createTileCache(size_t budget);
+
+/** @brief Frees the cache created with createTileCache()
+ *
+ *  @param cache May be NULL.
+ */
+
+void freeTileCache(TileCache* cache);
+
+/** @brief Keeps the tiles of the cache in a store too
+ *
+ *         Tiles which are not in memory are read from the store, new tiles are written to it.
+ *
+ *  @param cache
+ *  @param store May be NULL for none. It must stay open while it is used.
+ */
+
+void setTileCacheStore(TileCache* cache, TileStore* store);
+
+/** @brief Stores the tiles of the grid which lie completely on the points, are done and begin in rect
+ *
+ *         Views which don't lie on the grid are not stored. Each tile begins in
+ *         one tile of the screen, so the screen can be stored tile by tile.
+ *
+ *  @param cache
+ *  @param points The points, no thread may change them meanwhile
+ *  @param rect   Part of the screen the tiles begin in
+ */
+
+void storeCacheTiles(TileCache* cache, const MandelPoint* points, const struct MandelTile* rect);
+
+/** @brief Gives points in rect without result the results of the tiles in the cache
+ *
+ *         Must be called after prepareMandelbrot(), initMandelTile() keeps the
+ *         points with a result. Every part of a tile of the grid in rect which
+ *         is not done counts as a hit if the tile is in the cache, else as a miss.
+ *
+ *  @param cache
+ *  @param points The prepared points
+ *  @param rect   Part of the screen to look up
+ *  @return Number of points which got a result
+ */
+
+int loadCacheTiles(TileCache* cache, MandelPoint* points, const struct MandelTile* rect);
+
+/** @brief Removes all tiles from the cache
+ *
+ *         E.g. if the results are calculated another way from now on.
+ *
+ *  @param cache
+ */
+
+void clearTileCache(TileCache* cache);
+
+/** @brief Returns how often tiles were found in the cache
+ *
+ *  @param cache
+ *  @param hits   Receives the number of tiles found
+ *  @param misses Receives the number of tiles not found
+ *  @param bytes  Receives the memory the tiles use now
+ */
+
+void getTileCacheStats(const TileCache* cache, uint64_t* hits, uint64_t* misses, size_t* bytes);
+
+#endif /* TILECACHE_H */
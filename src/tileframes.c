@@ -0,0 +1,288 @@
+/*  Filename:  tileframes.c
+ *
+ *  Author:    mandex contributors
+ *  Copyright: (c) 2026 mandex contributors. All rights reserved.
+ *             This work is licensed under the terms of the MIT license.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <SDL2/SDL.h>
+#include "tileframes.h"
+
+#define FRAME_PIXELS (FRAME_TILE_SIZE * FRAME_TILE_SIZE)
+
+// Set in the middle frame of a tile while it wasn't taken by the presenter
+#define FRAME_FRESH 4
+
+// States of a tile of a snapshot
+#define SNAPSHOT_PINNED 0   // the front frame is the one of the snapshot
+#define SNAPSHOT_READING 1  // the snapshot is copied from the front frame
+#define SNAPSHOT_DONE 2     // the snapshot was copied from the front frame
+#define SNAPSHOT_COPYING 3  // the presenter copies the front frame before it takes another one
+#define SNAPSHOT_OWN 4      // the snapshot has its own copy of the tile
+
+struct FrameTile {
+    SDL_atomic_t middle;    // index of the middle frame, with FRAME_FRESH
+    int back;               // frame drawn to, only used by the drawing thread
+    int latest;             // frame published last
+    int front;              // frame presented, only used by the presenter
+};
+
+struct TileFrames {
+    struct FrameTile* tiles;
+    uint32_t* pixels;       // the three frames of each tile after each other
+    int tilesX;
+    int tilesY;
+    int width;
+    int height;
+    struct MandelTile* rects;
+    FrameSnapshot* snapshots;   // only used by the presenter
+};
+
+struct FrameSnapshot {
+    FrameSnapshot* next;
+    const TileFrames* frames;
+    const uint32_t** source;    // of each tile, the front frame or the own copy
+    SDL_atomic_t* state;        // of each tile
+    SDL_atomic_t finished;      // set once copied, the presenter frees it then
+};
+
+static void freeSnapshot(FrameSnapshot* snapshot)
+{
+    int numTiles = snapshot->frames->tilesX * snapshot->frames->tilesY;
+    for (int i = 0; i < numTiles; ++i) {
+        if (SDL_AtomicGet(&snapshot->state[i]) == SNAPSHOT_OWN)
+            free((uint32_t*)snapshot->source[i]);
+    }
+    free(snapshot->source);
+    free(snapshot->state);
+    free(snapshot);
+}
+
+TileFrames* createTileFrames(int width, int height)
+{
+    TileFrames* frames = calloc(1, sizeof(TileFrames));
+    if (!frames)
+        return NULL;
+
+    frames->width = width;
+    frames->height = height;
+    frames->tilesX = (width + FRAME_TILE_SIZE - 1) / FRAME_TILE_SIZE;
+    frames->tilesY = (height + FRAME_TILE_SIZE - 1) / FRAME_TILE_SIZE;
+    size_t numTiles = (size_t)frames->tilesX * frames->tilesY;
+    frames->tiles = malloc(numTiles * sizeof(struct FrameTile));
+    frames->pixels = calloc(numTiles * 3, FRAME_PIXELS * sizeof(uint32_t));
+    frames->rects = malloc(numTiles * sizeof(struct MandelTile));
+    if (!frames->tiles || !frames->pixels || !frames->rects) {
+        freeTileFrames(frames);
+        return NULL;
+    }
+
+    for (size_t i = 0; i < numTiles; ++i) {
+        frames->tiles[i].front = 0;
+        SDL_AtomicSet(&frames->tiles[i].middle, 1);
+        frames->tiles[i].back = 2;
+        frames->tiles[i].latest = 0;
+    }
+    return frames;
+}
+
+void freeTileFrames(TileFrames* frames)
+{
+    if (!frames)
+        return;
+    while (frames->snapshots) {
+        FrameSnapshot* next = frames->snapshots->next;
+        freeSnapshot(frames->snapshots);
+        frames->snapshots = next;
+    }
+    free(frames->tiles);
+    free(frames->pixels);
+    free(frames->rects);
+    free(frames);
+}
+
+static inline uint32_t* framePixels(const TileFrames* frames, int tile, int frame)
+{
+    return frames->pixels + ((size_t)tile * 3 + frame) * FRAME_PIXELS;
+}
+
+uint32_t* drawTileFrame(TileFrames* frames, int tileX, int tileY)
+{
+    int tile = tileY * frames->tilesX + tileX;
+    struct FrameTile* frame = &frames->tiles[tile];
+
+    // the latest frame is only read, by the presenter too if it is the front one
+    uint32_t* back = framePixels(frames, tile, frame->back);
+    memcpy(back, framePixels(frames, tile, frame->latest), FRAME_PIXELS * sizeof(uint32_t));
+    return back;
+}
+
+void publishTileFrame(TileFrames* frames, int tileX, int tileY)
+{
+    struct FrameTile* frame = &frames->tiles[tileY * frames->tilesX + tileX];
+    frame->latest = frame->back;
+    frame->back = SDL_AtomicSet(&frame->middle, frame->back | FRAME_FRESH) & ~FRAME_FRESH;
+}
+
+// Frees the snapshots which were copied
+static void freeFinishedSnapshots(TileFrames* frames)
+{
+    FrameSnapshot** link = &frames->snapshots;
+    while (*link) {
+        FrameSnapshot* snapshot = *link;
+        if (SDL_AtomicGet(&snapshot->finished)) {
+            *link = snapshot->next;
+            freeSnapshot(snapshot);
+        }
+        else {
+            link = &snapshot->next;
+        }
+    }
+}
+
+// Gives the snapshots which still need the front frame of a tile their own copy of
+// it. Returns 0 if a snapshot is copied from it right now or there is no memory for
+// the copy, the frame stays in front then.
+static int releaseFront(TileFrames* frames, int tile)
+{
+    for (FrameSnapshot* snapshot = frames->snapshots; snapshot; snapshot = snapshot->next) {
+        if (!SDL_AtomicCAS(&snapshot->state[tile], SNAPSHOT_PINNED, SNAPSHOT_COPYING)) {
+            if (SDL_AtomicGet(&snapshot->state[tile]) == SNAPSHOT_READING)
+                return 0;
+            continue;
+        }
+        uint32_t* copy = malloc(FRAME_PIXELS * sizeof(uint32_t));
+        if (!copy) {
+            SDL_AtomicSet(&snapshot->state[tile], SNAPSHOT_PINNED);
+            return 0;
+        }
+        memcpy(copy, snapshot->source[tile], FRAME_PIXELS * sizeof(uint32_t));
+        snapshot->source[tile] = copy;
+        SDL_AtomicSet(&snapshot->state[tile], SNAPSHOT_OWN);
+    }
+    return 1;
+}
+
+// Dirty tiles next to each other in a row of tiles form one rectangle. It
+// grows downwards while the rows below have the same one.
+int takeTileFrames(TileFrames* frames, const struct MandelTile** rects)
+{
+    freeFinishedSnapshots(frames);
+    struct MandelTile* taken = frames->rects;
+    int numRects = 0;
+    int merged = 0;     // rectangles of the row before
+    for (int ty = 0; ty < frames->tilesY; ++ty) {
+        int first = numRects;
+        for (int tx = 0; tx < frames->tilesX; ++tx) {
+            struct FrameTile* frame = &frames->tiles[ty * frames->tilesX + tx];
+            if (!(SDL_AtomicGet(&frame->middle) & FRAME_FRESH)
+                || !releaseFront(frames, ty * frames->tilesX + tx))
+                continue;
+            frame->front = SDL_AtomicSet(&frame->middle, frame->front) & ~FRAME_FRESH;
+
+            if (numRects > first && taken[numRects - 1].x + taken[numRects - 1].width == tx * FRAME_TILE_SIZE) {
+                taken[numRects - 1].width += FRAME_TILE_SIZE;
+                continue;
+            }
+            struct MandelTile* rect = &taken[numRects++];
+            rect->x = tx * FRAME_TILE_SIZE;
+            rect->y = ty * FRAME_TILE_SIZE;
+            rect->width = FRAME_TILE_SIZE;
+            rect->height = FRAME_TILE_SIZE;
+        }
+
+        // the rectangle of the row before takes the one of this row if it is the only one of both
+        if (merged == 1 && numRects == first + 1 && taken[first - 1].x == taken[first].x
+            && taken[first - 1].width == taken[first].width) {
+            taken[first - 1].height += FRAME_TILE_SIZE;
+            numRects = first;
+            continue;
+        }
+        merged = numRects - first;
+    }
+
+    // tiles at the right and bottom border are cut off by the screen
+    for (int i = 0; i < numRects; ++i) {
+        if (taken[i].x + taken[i].width > frames->width)
+            taken[i].width = frames->width - taken[i].x;
+        if (taken[i].y + taken[i].height > frames->height)
+            taken[i].height = frames->height - taken[i].y;
+    }
+    *rects = taken;
+    return numRects;
+}
+
+void copyTileFrames(const TileFrames* frames, const struct MandelTile* rect, uint32_t* pixels, int pitch)
+{
+    for (int y = rect->y; y < rect->y + rect->height; ++y) {
+        uint32_t* row = pixels + (ptrdiff_t)(y - rect->y) * pitch;
+        int ty = y / FRAME_TILE_SIZE;
+        int x = rect->x;
+        while (x < rect->x + rect->width) {
+            int tx = x / FRAME_TILE_SIZE;
+            int tile = ty * frames->tilesX + tx;
+            int end = (tx + 1) * FRAME_TILE_SIZE < rect->x + rect->width ? (tx + 1) * FRAME_TILE_SIZE : rect->x + rect->width;
+            const uint32_t* source = framePixels(frames, tile, frames->tiles[tile].front)
+                                   + (y - ty * FRAME_TILE_SIZE) * FRAME_TILE_SIZE + (x - tx * FRAME_TILE_SIZE);
+            memcpy(row + (x - rect->x), source, (end - x) * sizeof(uint32_t));
+            x = end;
+        }
+    }
+}
+
+FrameSnapshot* snapshotTileFrames(TileFrames* frames)
+{
+    FrameSnapshot* snapshot = calloc(1, sizeof(FrameSnapshot));
+    if (!snapshot)
+        return NULL;
+    int numTiles = frames->tilesX * frames->tilesY;
+    snapshot->frames = frames;
+    snapshot->source = malloc(numTiles * sizeof(const uint32_t*));
+    snapshot->state = calloc(numTiles, sizeof(SDL_atomic_t));
+    if (!snapshot->source || !snapshot->state) {
+        free(snapshot->source);
+        free(snapshot->state);
+        free(snapshot);
+        return NULL;
+    }
+    for (int i = 0; i < numTiles; ++i)
+        snapshot->source[i] = framePixels(frames, i, frames->tiles[i].front);
+    snapshot->next = frames->snapshots;
+    frames->snapshots = snapshot;
+    return snapshot;
+}
+
+// Copies one tile, cut off by the screen at the right and bottom border
+static void copySnapshotTile(const FrameSnapshot* snapshot, const uint32_t* source, int tileX, int tileY, uint32_t* pixels)
+{
+    const TileFrames* frames = snapshot->frames;
+    int x = tileX * FRAME_TILE_SIZE;
+    int y = tileY * FRAME_TILE_SIZE;
+    int width = frames->width - x < FRAME_TILE_SIZE ? frames->width - x : FRAME_TILE_SIZE;
+    int height = frames->height - y < FRAME_TILE_SIZE ? frames->height - y : FRAME_TILE_SIZE;
+    for (int row = 0; row < height; ++row)
+        memcpy(pixels + (ptrdiff_t)(y + row) * frames->width + x, source + row * FRAME_TILE_SIZE, width * sizeof(uint32_t));
+}
+
+void copyFrameSnapshot(FrameSnapshot* snapshot, uint32_t* pixels)
+{
+    const TileFrames* frames = snapshot->frames;
+    for (int ty = 0; pixels && ty < frames->tilesY; ++ty) {
+        for (int tx = 0; tx < frames->tilesX; ++tx) {
+            int tile = ty * frames->tilesX + tx;
+            if (SDL_AtomicCAS(&snapshot->state[tile], SNAPSHOT_PINNED, SNAPSHOT_READING)) {
+                copySnapshotTile(snapshot, snapshot->source[tile], tx, ty, pixels);
+                SDL_AtomicSet(&snapshot->state[tile], SNAPSHOT_DONE);
+                continue;
+            }
+
+            // the presenter copies the tile, which takes as long as copying it here
+            while (SDL_AtomicGet(&snapshot->state[tile]) == SNAPSHOT_COPYING)
+                ;
+            copySnapshotTile(snapshot, snapshot->source[tile], tx, ty, pixels);
+        }
+    }
+    SDL_AtomicSet(&snapshot->finished, 1);
+}
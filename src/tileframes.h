@@ -0,0 +1,119 @@
+/** @file        tileframes.h
+ *
+ *  @brief       Hands the drawn pixels of the screen to the presenter, tile by tile.
+ *
+ *               Every tile of the screen has three frames of pixels: the threads
+ *               draw to the back one, the presenter copies the front one to the
+ *               window and the middle one is exchanged between them. A drawn tile
+ *               swaps its back frame with the middle one and the presenter its
+ *               front frame with the middle one, each with one atomic exchange,
+ *               so neither ever waits for the other. A snapshot of the screen
+ *               keeps the front frames until it was copied.
+ *
+ *  @version     1.0
+ *  @date        10/17/2026
+ *  Revision:    -
+ *
+ *  @author      mandex contributors
+ *  @copyright   Copyright (c) 2026 mandex contributors. All rights reserved.
+ *               This work is licensed under the terms of the MIT license.
+ */
+
+#ifndef TILEFRAMES_H
+#define TILEFRAMES_H
+
+#include <stdint.h>
+#include "mandelbrot.h"
+
+// Width and height of a tile, also the number of pixels from one row of its frames to the next
+#define FRAME_TILE_SIZE 32
+
+typedef struct TileFrames TileFrames;
+
+typedef struct FrameSnapshot FrameSnapshot;
+
+/** @brief Creates the frames of a screen, all pixels are 0
+ *
+ *  @param width  Width of the screen in pixels
+ *  @param height Height of the screen in pixels
+ *  @return Pointer to the frames, NULL if allocation failed. Must be freed with freeTileFrames().
+ */
+
+TileFrames* createTileFrames(int width, int height);
+
+/** @brief Frees the frames created with createTileFrames()
+ *
+ *  @param frames May be NULL.
+ */
+
+void freeTileFrames(TileFrames* frames);
+
+/** @brief Returns the frame a tile is drawn to
+ *
+ *         It has the pixels the tile was drawn with last, so only a part of it
+ *         needs to be drawn. Only one thread may draw a tile at a time, until
+ *         it calls publishTileFrame().
+ *
+ *  @param frames
+ *  @param tileX  Column of the tile, x / FRAME_TILE_SIZE
+ *  @param tileY  Row of the tile
+ *  @return The pixels of the tile, rows are FRAME_TILE_SIZE pixels apart
+ */
+
+uint32_t* drawTileFrame(TileFrames* frames, int tileX, int tileY);
+
+/** @brief Hands the frame drawn since drawTileFrame() to the presenter
+ *
+ *  @param frames
+ *  @param tileX  Column of the tile
+ *  @param tileY  Row of the tile
+ */
+
+void publishTileFrame(TileFrames* frames, int tileX, int tileY);
+
+/** @brief Takes the tiles published since the last call for presenting
+ *
+ *         Only the presenter may call this and copyTileFrames().
+ *
+ *  @param frames
+ *  @param rects  Receives the parts of the screen which changed, valid until the next call
+ *  @return Number of parts, 0 if no tile was published
+ */
+
+int takeTileFrames(TileFrames* frames, const struct MandelTile** rects);
+
+/** @brief Copies the pixels of the tiles taken for presenting
+ *
+ *  @param frames
+ *  @param rect   Part of the screen
+ *  @param pixels The pixel of the top left of rect
+ *  @param pitch  Pixels from one row to the next
+ */
+
+void copyTileFrames(const TileFrames* frames, const struct MandelTile* rect, uint32_t* pixels, int pitch);
+
+/** @brief Takes a snapshot of the presented pixels without copying them
+ *
+ *         The snapshot keeps the front frames as they are. A frame is only
+ *         copied for the snapshot if the presenter takes another one for its
+ *         tile before the snapshot was copied. Only the presenter may call this.
+ *
+ *  @param frames
+ *  @return The snapshot, NULL if allocation failed. Must be passed to
+ *          copyFrameSnapshot() once, before the frames are freed.
+ */
+
+FrameSnapshot* snapshotTileFrames(TileFrames* frames);
+
+/** @brief Copies the pixels of a snapshot and releases it
+ *
+ *         Any thread may call this, the presenter frees the snapshot later.
+ *
+ *  @param snapshot
+ *  @param pixels   Receives the whole screen, rows are its width apart.
+ *                  May be NULL to only release the snapshot.
+ */
+
+void copyFrameSnapshot(FrameSnapshot* snapshot, uint32_t* pixels);
+
+#endif /* TILEFRAMES_H */
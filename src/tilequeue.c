@@ -0,0 +1,573 @@
+/*  Filename:  tilequeue.c
+ *
+ *  Author:    mandex contributors
+ *  Copyright: (c) 2026 mandex contributors. All rights reserved.
+ *             This work is licensed under the terms of the MIT license.
+ */
+
+#include <stdlib.h>
+#include <SDL2/SDL.h>
+#include "tilequeue.h"
+
+// A tile in the pool, linked into one of the queues while it waits
+struct TileNode {
+    struct MandelTile rect;
+    int priority;       // squared distance to the center of the screen
+    int started;        // was taken before
+    int stride;         // of the pass the tile is in
+    void* data;         // of a background tile
+    int next;           // index in the pool, -1 at the end
+    int prev;
+};
+
+// The queue of one thread. The thread takes tiles from the head,
+// returned tiles and stolen ones are at the tail.
+struct Deque {
+    SDL_mutex* lock;
+    int head;
+    int tail;
+    void* busy;         // data of the tile the thread works on
+    SDL_cond* idle;     // signalled when busy is cleared, with lock held
+};
+
+struct TileQueue {
+    struct Deque* deques;
+    int numDeques;
+
+    // Every tile of the screen in the order they are handed out,
+    // copied to the pool at every reset
+    struct TileNode* screenTiles;
+    int numScreenTiles;
+
+    // Split tiles are added to the pool, a tile of full size
+    // splits into this many of the minimum size at most
+    struct TileNode* nodes;
+    int maxNodes;
+    SDL_atomic_t numNodes;
+
+    // Only changed while all deques are locked
+    void* data;
+    SDL_atomic_t epoch;
+
+    // Background tiles are queued in their own deque and stored behind the
+    // nodes of the screen. They have their own epoch.
+    struct Deque background;
+    int maxBackground;
+    int numBackground;
+    SDL_atomic_t backgroundEpoch;
+    SDL_atomic_t backgroundQueued;
+
+    // Index in screenTiles of the next tile to draw, numScreenTiles or more if none
+    SDL_atomic_t nextDraw;
+
+    SDL_atomic_t queued;    // tiles in the queues
+    SDL_atomic_t pending;   // tiles which are not done
+
+    // Ticks of the last reset, only changed while all deques are locked,
+    // and the milliseconds until pending reached 0, -1 before
+    uint32_t resetTicks;
+    SDL_atomic_t doneTime;
+
+    // Threads without tiles sleep until tiles are queued
+    SDL_mutex* sleepLock;
+    SDL_cond* wake;
+    SDL_atomic_t sleeping;
+    SDL_atomic_t stop;
+};
+
+static int comparePriority(const void* a, const void* b)
+{
+    const struct TileNode* ta = a;
+    const struct TileNode* tb = b;
+    if (ta->priority != tb->priority)
+        return ta->priority < tb->priority ? -1 : 1;
+    if (ta->rect.y != tb->rect.y)
+        return ta->rect.y < tb->rect.y ? -1 : 1;
+    return ta->rect.x < tb->rect.x ? -1 : ta->rect.x > tb->rect.x;
+}
+
+// Squared distance of the center of a tile to the center of the screen,
+// in half pixels so it stays an integer
+static int tilePriority(const struct MandelTile* rect, int width, int height)
+{
+    int dx = 2 * rect->x + rect->width - width;
+    int dy = 2 * rect->y + rect->height - height;
+    return dx * dx + dy * dy;
+}
+
+static void initScreenTiles(TileQueue* queue, int width, int height)
+{
+    int n = 0;
+    for (int y = 0; y < height; y += TILE_SIZE) {
+        for (int x = 0; x < width; x += TILE_SIZE) {
+            struct TileNode* node = &queue->screenTiles[n++];
+            node->rect.x = x;
+            node->rect.y = y;
+            node->rect.width = width - x < TILE_SIZE ? width - x : TILE_SIZE;
+            node->rect.height = height - y < TILE_SIZE ? height - y : TILE_SIZE;
+            node->priority = tilePriority(&node->rect, width, height);
+            node->started = 0;
+            node->stride = MANDEL_COARSE_STRIDE;
+        }
+    }
+    qsort(queue->screenTiles, n, sizeof(struct TileNode), comparePriority);
+}
+
+TileQueue* createTileQueue(int numQueues, int width, int height)
+{
+    TileQueue* queue = calloc(1, sizeof(TileQueue));
+    if (!queue)
+        return NULL;
+
+    int tilesX = (width + TILE_SIZE - 1) / TILE_SIZE;
+    int tilesY = (height + TILE_SIZE - 1) / TILE_SIZE;
+    int splits = (TILE_SIZE / MIN_TILE_SIZE) * (TILE_SIZE / MIN_TILE_SIZE);
+    queue->numScreenTiles = tilesX * tilesY;
+    queue->maxNodes = queue->numScreenTiles * splits;
+    queue->maxBackground = 2 * queue->numScreenTiles;
+    queue->numDeques = numQueues;
+    queue->screenTiles = malloc(queue->numScreenTiles * sizeof(struct TileNode));
+    queue->nodes = malloc((queue->maxNodes + queue->maxBackground) * sizeof(struct TileNode));
+    queue->deques = calloc(numQueues, sizeof(struct Deque));
+    queue->sleepLock = SDL_CreateMutex();
+    queue->wake = SDL_CreateCond();
+    queue->background.head = -1;
+    queue->background.tail = -1;
+    queue->background.lock = SDL_CreateMutex();
+    if (!queue->screenTiles || !queue->nodes || !queue->deques || !queue->sleepLock || !queue->wake
+        || !queue->background.lock) {
+        freeTileQueue(queue);
+        return NULL;
+    }
+
+    for (int i = 0; i < numQueues; ++i) {
+        queue->deques[i].head = -1;
+        queue->deques[i].tail = -1;
+        queue->deques[i].lock = SDL_CreateMutex();
+        queue->deques[i].idle = SDL_CreateCond();
+        if (!queue->deques[i].lock || !queue->deques[i].idle) {
+            freeTileQueue(queue);
+            return NULL;
+        }
+    }
+
+    initScreenTiles(queue, width, height);
+    SDL_AtomicSet(&queue->nextDraw, queue->numScreenTiles);
+    return queue;
+}
+
+void freeTileQueue(TileQueue* queue)
+{
+    if (!queue)
+        return;
+    if (queue->deques) {
+        for (int i = 0; i < queue->numDeques; ++i) {
+            SDL_DestroyMutex(queue->deques[i].lock);
+            SDL_DestroyCond(queue->deques[i].idle);
+        }
+    }
+    SDL_DestroyMutex(queue->sleepLock);
+    SDL_DestroyCond(queue->wake);
+    SDL_DestroyMutex(queue->background.lock);
+    free(queue->deques);
+    free(queue->nodes);
+    free(queue->screenTiles);
+    free(queue);
+}
+
+// The deque must be locked for all of the following
+static void pushBack(TileQueue* queue, struct Deque* deque, int slot)
+{
+    struct TileNode* node = &queue->nodes[slot];
+    node->next = -1;
+    node->prev = deque->tail;
+    if (deque->tail >= 0)
+        queue->nodes[deque->tail].next = slot;
+    else
+        deque->head = slot;
+    deque->tail = slot;
+}
+
+static void unlinkTile(TileQueue* queue, struct Deque* deque, int slot)
+{
+    struct TileNode* node = &queue->nodes[slot];
+    if (node->prev >= 0)
+        queue->nodes[node->prev].next = node->next;
+    else
+        deque->head = node->next;
+    if (node->next >= 0)
+        queue->nodes[node->next].prev = node->prev;
+    else
+        deque->tail = node->prev;
+}
+
+// The thread of the deque is done with its tile
+static void releaseTile(struct Deque* deque)
+{
+    SDL_AtomicSetPtr(&deque->busy, NULL);
+    SDL_CondBroadcast(deque->idle);
+}
+
+static void wakeThreads(TileQueue* queue)
+{
+    if (SDL_AtomicGet(&queue->sleeping)) {
+        SDL_LockMutex(queue->sleepLock);
+        SDL_CondBroadcast(queue->wake);
+        SDL_UnlockMutex(queue->sleepLock);
+    }
+}
+
+static int isInside(const struct MandelTile* a, const struct MandelTile* b)
+{
+    return a->x >= b->x && a->y >= b->y
+        && a->x + a->width <= b->x + b->width
+        && a->y + a->height <= b->y + b->height;
+}
+
+// Tells if a tile lies inside one of the rectangles
+static int isDone(const struct MandelTile* rect, const struct MandelTile* done, int numDone)
+{
+    for (int i = 0; i < numDone; ++i) {
+        if (isInside(rect, &done[i]))
+            return 1;
+    }
+    return 0;
+}
+
+void resetTileQueue(TileQueue* queue, void* data, const struct MandelTile* done, int numDone)
+{
+    for (int i = 0; i < queue->numDeques; ++i)
+        SDL_LockMutex(queue->deques[i].lock);
+
+    queue->data = data;
+    SDL_AtomicAdd(&queue->epoch, 1);
+    for (int i = 0; i < queue->numDeques; ++i) {
+        queue->deques[i].head = -1;
+        queue->deques[i].tail = -1;
+    }
+
+    // dealt out in turn, so every thread starts in the center
+    int numTiles = 0;
+    for (int i = 0; i < queue->numScreenTiles; ++i) {
+        if (isDone(&queue->screenTiles[i].rect, done, numDone))
+            continue;
+        queue->nodes[numTiles] = queue->screenTiles[i];
+        pushBack(queue, &queue->deques[numTiles % queue->numDeques], numTiles);
+        ++numTiles;
+    }
+    SDL_AtomicSet(&queue->numNodes, numTiles);
+    SDL_AtomicSet(&queue->pending, numTiles);
+    queue->resetTicks = SDL_GetTicks();
+    SDL_AtomicSet(&queue->doneTime, numTiles ? -1 : 0);
+    SDL_AtomicSet(&queue->queued, numTiles);
+
+    for (int i = queue->numDeques; i--;)
+        SDL_UnlockMutex(queue->deques[i].lock);
+    wakeThreads(queue);
+}
+
+void clearTiles(TileQueue* queue)
+{
+    for (int i = 0; i < queue->numDeques; ++i)
+        SDL_LockMutex(queue->deques[i].lock);
+
+    SDL_AtomicAdd(&queue->epoch, 1);
+    for (int i = 0; i < queue->numDeques; ++i) {
+        queue->deques[i].head = -1;
+        queue->deques[i].tail = -1;
+    }
+    SDL_AtomicSet(&queue->queued, 0);
+    SDL_AtomicSet(&queue->nextDraw, queue->numScreenTiles);
+
+    for (int i = queue->numDeques; i--;)
+        SDL_UnlockMutex(queue->deques[i].lock);
+}
+
+static int takeTile(TileQueue* queue, int self, int from, struct Tile* tile)
+{
+    struct Deque* deque = &queue->deques[from];
+    SDL_LockMutex(deque->lock);
+    int slot = from == self ? deque->head : deque->tail;
+    if (slot >= 0) {
+        unlinkTile(queue, deque, slot);
+        SDL_AtomicAdd(&queue->queued, -1);
+        tile->rect = queue->nodes[slot].rect;
+        tile->data = queue->data;
+        tile->epoch = SDL_AtomicGet(&queue->epoch);
+        tile->started = queue->nodes[slot].started;
+        tile->stride = queue->nodes[slot].stride;
+        tile->background = 0;
+        tile->draw = 0;
+        tile->slot = slot;
+        SDL_AtomicSetPtr(&queue->deques[self].busy, queue->data);
+    }
+    SDL_UnlockMutex(deque->lock);
+    return slot >= 0;
+}
+
+static int hasDrawTiles(TileQueue* queue)
+{
+    return SDL_AtomicGet(&queue->nextDraw) < queue->numScreenTiles;
+}
+
+// The own deque is locked, so the data and epoch belong to one reset
+static int takeDrawTile(TileQueue* queue, int self, struct Tile* tile)
+{
+    if (!hasDrawTiles(queue))
+        return 0;
+    struct Deque* deque = &queue->deques[self];
+    SDL_LockMutex(deque->lock);
+    int next = SDL_AtomicAdd(&queue->nextDraw, 1);
+    if (next < queue->numScreenTiles) {
+        tile->rect = queue->screenTiles[next].rect;
+        tile->data = queue->data;
+        tile->epoch = SDL_AtomicGet(&queue->epoch);
+        tile->started = 1;
+        tile->stride = 1;
+        tile->background = 0;
+        tile->draw = 1;
+        tile->slot = -1;
+        SDL_AtomicSetPtr(&deque->busy, queue->data);
+    }
+    SDL_UnlockMutex(deque->lock);
+    return next < queue->numScreenTiles;
+}
+
+void redrawTiles(TileQueue* queue)
+{
+    SDL_AtomicSet(&queue->nextDraw, 0);
+    wakeThreads(queue);
+}
+
+static int takeBackgroundTile(TileQueue* queue, int self, struct Tile* tile)
+{
+    struct Deque* deque = &queue->background;
+    SDL_LockMutex(deque->lock);
+    int slot = deque->head;
+    if (slot >= 0) {
+        unlinkTile(queue, deque, slot);
+        SDL_AtomicAdd(&queue->backgroundQueued, -1);
+        tile->rect = queue->nodes[slot].rect;
+        tile->data = queue->nodes[slot].data;
+        tile->epoch = SDL_AtomicGet(&queue->backgroundEpoch);
+        tile->started = queue->nodes[slot].started;
+        tile->stride = 1;
+        tile->background = 1;
+        tile->draw = 0;
+        tile->slot = slot;
+        SDL_AtomicSetPtr(&queue->deques[self].busy, tile->data);
+    }
+    SDL_UnlockMutex(deque->lock);
+    return slot >= 0;
+}
+
+int addBackgroundTiles(TileQueue* queue, void* data, int width, int height)
+{
+    struct Deque* deque = &queue->background;
+    int added = 0;
+    SDL_LockMutex(deque->lock);
+    for (int y = 0; y < height; y += TILE_SIZE) {
+        for (int x = 0; x < width && queue->numBackground < queue->maxBackground; x += TILE_SIZE) {
+            int slot = queue->maxNodes + queue->numBackground++;
+            struct TileNode* node = &queue->nodes[slot];
+            node->rect.x = x;
+            node->rect.y = y;
+            node->rect.width = width - x < TILE_SIZE ? width - x : TILE_SIZE;
+            node->rect.height = height - y < TILE_SIZE ? height - y : TILE_SIZE;
+            node->started = 0;
+            node->stride = 1;
+            node->data = data;
+            pushBack(queue, deque, slot);
+            ++added;
+        }
+    }
+    SDL_AtomicAdd(&queue->backgroundQueued, added);
+    SDL_UnlockMutex(deque->lock);
+
+    if (added)
+        wakeThreads(queue);
+    return added;
+}
+
+void clearBackgroundTiles(TileQueue* queue)
+{
+    struct Deque* deque = &queue->background;
+    SDL_LockMutex(deque->lock);
+    SDL_AtomicAdd(&queue->backgroundEpoch, 1);
+    deque->head = -1;
+    deque->tail = -1;
+    queue->numBackground = 0;
+    SDL_AtomicSet(&queue->backgroundQueued, 0);
+    SDL_UnlockMutex(deque->lock);
+}
+
+int hasQueuedTiles(TileQueue* queue)
+{
+    return SDL_AtomicGet(&queue->queued) > 0 || hasDrawTiles(queue);
+}
+
+int popTile(TileQueue* queue, int self, struct Tile* tile)
+{
+    while (!SDL_AtomicGet(&queue->stop)) {
+        if (takeDrawTile(queue, self, tile))
+            return 1;
+        if (takeTile(queue, self, self, tile))
+            return 1;
+        for (int i = 1; i < queue->numDeques; ++i) {
+            if (takeTile(queue, self, (self + i) % queue->numDeques, tile))
+                return 1;
+        }
+        if (takeBackgroundTile(queue, self, tile))
+            return 1;
+
+        // Sleeping is counted before queued is checked and tiles are queued before
+        // sleeping is checked, so either this thread or the one queueing sees the other.
+        SDL_LockMutex(queue->sleepLock);
+        SDL_AtomicAdd(&queue->sleeping, 1);
+        while (!SDL_AtomicGet(&queue->stop) && !SDL_AtomicGet(&queue->queued)
+               && !SDL_AtomicGet(&queue->backgroundQueued) && !hasDrawTiles(queue))
+            SDL_CondWait(queue->wake, queue->sleepLock);
+        SDL_AtomicAdd(&queue->sleeping, -1);
+        SDL_UnlockMutex(queue->sleepLock);
+    }
+    return 0;
+}
+
+// Splits a tile into quarters, the first one keeps the slot.
+// Returns the number of tiles in slots.
+static int splitTile(TileQueue* queue, int slot, int* slots)
+{
+    struct MandelTile rect = queue->nodes[slot].rect;
+    slots[0] = slot;
+    if (rect.width <= MIN_TILE_SIZE && rect.height <= MIN_TILE_SIZE)
+        return 1;
+    int first = SDL_AtomicAdd(&queue->numNodes, 3);
+    if (first + 3 > queue->maxNodes) {
+        SDL_AtomicAdd(&queue->numNodes, -3);
+        return 1;
+    }
+
+    int halfWidth = (rect.width + 1) / 2;
+    int halfHeight = (rect.height + 1) / 2;
+    for (int i = 1; i < 4; ++i)
+        slots[i] = first + i - 1;
+    for (int i = 0; i < 4; ++i) {
+        struct MandelTile* part = &queue->nodes[slots[i]].rect;
+        part->x = rect.x + (i & 1 ? halfWidth : 0);
+        part->y = rect.y + (i & 2 ? halfHeight : 0);
+        part->width = i & 1 ? rect.width - halfWidth : halfWidth;
+        part->height = i & 2 ? rect.height - halfHeight : halfHeight;
+        queue->nodes[slots[i]].priority = queue->nodes[slot].priority;
+        queue->nodes[slots[i]].stride = queue->nodes[slot].stride;
+    }
+    return 4;
+}
+
+// Background tiles go back to the background deque
+static void requeueBackground(TileQueue* queue, int self, const struct Tile* tile)
+{
+    struct Deque* deque = &queue->background;
+    int returned = 0;
+    SDL_LockMutex(deque->lock);
+    if (!isTileStale(queue, tile)) {
+        queue->nodes[tile->slot].started = 1;
+        pushBack(queue, deque, tile->slot);
+        SDL_AtomicAdd(&queue->backgroundQueued, 1);
+        returned = 1;
+    }
+    SDL_UnlockMutex(deque->lock);
+
+    SDL_LockMutex(queue->deques[self].lock);
+    releaseTile(&queue->deques[self]);
+    SDL_UnlockMutex(queue->deques[self].lock);
+
+    if (returned)
+        wakeThreads(queue);
+}
+
+// Puts a tile back for the pass with the given stride
+static void requeueTile(TileQueue* queue, int self, const struct Tile* tile, int split, int stride)
+{
+    if (tile->background) {
+        requeueBackground(queue, self, tile);
+        return;
+    }
+
+    struct Deque* deque = &queue->deques[self];
+    int slots[4] = {tile->slot};
+    int returned = 0;
+    SDL_LockMutex(deque->lock);
+    if (!isTileStale(queue, tile)) {
+        queue->nodes[tile->slot].stride = stride;
+        returned = split ? splitTile(queue, tile->slot, slots) : 1;
+        for (int i = 0; i < returned; ++i) {
+            queue->nodes[slots[i]].started = 1;
+            pushBack(queue, deque, slots[i]);
+        }
+        SDL_AtomicAdd(&queue->pending, returned - 1);
+        SDL_AtomicAdd(&queue->queued, returned);
+    }
+    releaseTile(deque);
+    SDL_UnlockMutex(deque->lock);
+
+    if (returned)
+        wakeThreads(queue);
+}
+
+void returnTile(TileQueue* queue, int self, const struct Tile* tile, int split)
+{
+    requeueTile(queue, self, tile, split, tile->stride);
+}
+
+void refineTile(TileQueue* queue, int self, const struct Tile* tile)
+{
+    requeueTile(queue, self, tile, 0, tile->stride / 2);
+}
+
+void finishTile(TileQueue* queue, int self, const struct Tile* tile)
+{
+    struct Deque* deque = &queue->deques[self];
+    SDL_LockMutex(deque->lock);
+    if (!tile->background && !tile->draw && !isTileStale(queue, tile)
+        && SDL_AtomicAdd(&queue->pending, -1) == 1)
+        SDL_AtomicSet(&queue->doneTime, SDL_GetTicks() - queue->resetTicks);
+    releaseTile(deque);
+    SDL_UnlockMutex(deque->lock);
+}
+
+int isTileStale(TileQueue* queue, const struct Tile* tile)
+{
+    if (tile->background)
+        return tile->epoch != SDL_AtomicGet(&queue->backgroundEpoch);
+    return tile->epoch != SDL_AtomicGet(&queue->epoch);
+}
+
+int isTileQueueDone(TileQueue* queue)
+{
+    return SDL_AtomicGet(&queue->pending) == 0 && !hasDrawTiles(queue);
+}
+
+uint32_t getTileQueueTime(TileQueue* queue)
+{
+    int time = SDL_AtomicGet(&queue->doneTime);
+    return time >= 0 ? (uint32_t)time : SDL_GetTicks() - queue->resetTicks;
+}
+
+void waitForTiles(TileQueue* queue, const void* data)
+{
+    for (int i = 0; i < queue->numDeques; ++i) {
+        struct Deque* deque = &queue->deques[i];
+        SDL_LockMutex(deque->lock);
+        while (SDL_AtomicGetPtr(&deque->busy) == data)
+            SDL_CondWait(deque->idle, deque->lock);
+        SDL_UnlockMutex(deque->lock);
+    }
+}
+
+void stopTileQueue(TileQueue* queue)
+{
+    SDL_LockMutex(queue->sleepLock);
+    SDL_AtomicSet(&queue->stop, 1);
+    SDL_CondBroadcast(queue->wake);
+    SDL_UnlockMutex(queue->sleepLock);
+}
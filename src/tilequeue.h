@@ -0,0 +1,241 @@
+/** @file        tilequeue.h
+ *
+ *  @brief       Hands out the tiles of the screen to the threads.
+ *
+ *               Every thread has its own queue of tiles, sorted so the tiles in
+ *               the center of the screen come first. A thread whose queue is empty
+ *               steals tiles from the end of the other queues. Tiles which are not
+ *               done after a while go back to the end of the queue, expensive ones
+ *               are split so several threads can share them.
+ *
+ *               The screen is calculated in progressive passes. At first every
+ *               tile only calculates a few of its points, once done it goes back
+ *               to the queue to calculate more of them, until all are done.
+ *
+ *               Background tiles are only handed out while there are no other
+ *               tiles, e.g. to calculate views the user will likely change to.
+ *               Draw tiles are handed out before all others, every tile of the
+ *               screen once, so the threads draw the whole screen together.
+ *
+ *  @version     1.0
+ *  @date        10/17/2026
+ *  Revision:    -
+ *
+ *  @author      mandex contributors
+ *  @copyright   Copyright (c) 2026 mandex contributors. All rights reserved.
+ *               This work is licensed under the terms of the MIT license.
+ */
+
+#ifndef TILEQUEUE_H
+#define TILEQUEUE_H
+
+#include "mandelbrot.h"
+
+// Width and height of a tile, the points of one fit into the L2 cache
+#define TILE_SIZE 32
+
+// Tiles are split down to this size
+#define MIN_TILE_SIZE 8
+
+typedef struct TileQueue TileQueue;
+
+/** @brief A tile a thread took from the queue.
+ */
+
+struct Tile {
+    struct MandelTile rect;
+    void* data;         // what the tiles belong to, passed to resetTileQueue()
+    int epoch;          // tiles of an older reset are stale and dropped when they are returned
+    int started;        // 0 the first time the tile is taken after a reset
+    int stride;         // only every stride-th row and column is calculated in this pass
+    int background;     // added with addBackgroundTiles()
+    int draw;           // added with redrawTiles(), only drawn
+    int slot;
+};
+
+/** @brief Creates the queues for the tiles of a screen
+ *
+ *         The queues are empty until resetTileQueue() is called.
+ *
+ *  @param numQueues Number of queues, one for each thread
+ *  @param width     Width of the screen in pixels
+ *  @param height    Height of the screen in pixels
+ *  @return Pointer to the queues, NULL if allocation failed. Must be freed with freeTileQueue().
+ */
+
+TileQueue* createTileQueue(int numQueues, int width, int height);
+
+/** @brief Frees the queues created with createTileQueue()
+ *
+ *  @param queue May be NULL.
+ */
+
+void freeTileQueue(TileQueue* queue);
+
+/** @brief Replaces all tiles with the tiles of the whole screen
+ *
+ *         Starts a new epoch, tiles taken before are stale from now on.
+ *         Threads waiting for tiles are woken.
+ *
+ *  @param queue
+ *  @param data     Passed on with every tile, e.g. the points the tiles belong to
+ *  @param done     Tiles which lie completely inside one of these are done already
+ *  @param numDone  Number of rectangles in done, may be 0
+ */
+
+void resetTileQueue(TileQueue* queue, void* data, const struct MandelTile* done, int numDone);
+
+/** @brief Removes all tiles of the screen, also those to draw
+ *
+ *         Starts a new epoch like resetTileQueue(), tiles taken before are
+ *         stale from now on. No tiles are handed out until the next reset.
+ *
+ *  @param queue
+ */
+
+void clearTiles(TileQueue* queue);
+
+/** @brief Adds background tiles which cover an area
+ *
+ *         Background tiles are always calculated completely, they are neither
+ *         split nor calculated in passes.
+ *
+ *  @param queue
+ *  @param data   Passed on with every tile of the area
+ *  @param width  Width of the area in pixels
+ *  @param height Height of the area in pixels
+ *  @return Number of added tiles, less than needed if there is no room for more
+ */
+
+int addBackgroundTiles(TileQueue* queue, void* data, int width, int height);
+
+/** @brief Removes all background tiles
+ *
+ *         Background tiles taken before are stale from now on.
+ *
+ *  @param queue
+ */
+
+void clearBackgroundTiles(TileQueue* queue);
+
+/** @brief Hands out every tile of the screen once more to draw it
+ *
+ *         Draw tiles come before all other tiles, those of the center first.
+ *         They have the data and epoch of the last reset and don't count as
+ *         tiles which are not done. Draw tiles which were not taken yet are
+ *         handed out only once.
+ *
+ *  @param queue
+ */
+
+void redrawTiles(TileQueue* queue);
+
+/** @brief Tells if there are tiles other than background tiles to take
+ *
+ *         Threads working on a background tile should return it if so.
+ *
+ *  @param queue
+ *  @return 1 if tiles are queued, else 0
+ */
+
+int hasQueuedTiles(TileQueue* queue);
+
+/** @brief Takes the next tile for a thread
+ *
+ *         Takes a draw tile, or the first tile of the own queue, or steals the
+ *         last tile of another queue, or takes a background tile. Sleeps if there are no
+ *         tiles until there are new ones.
+ *         The thread must return the tile with returnTile() or finishTile().
+ *
+ *  @param queue
+ *  @param self  Index of the queue of the thread
+ *  @param tile  Receives the tile
+ *  @return 1 if there is a tile, 0 if the queue was stopped
+ */
+
+int popTile(TileQueue* queue, int self, struct Tile* tile);
+
+/** @brief Puts a tile which is not done back to the end of the queue of the thread
+ *
+ *  @param queue
+ *  @param self  Index of the queue of the thread
+ *  @param tile  The tile taken with popTile()
+ *  @param split If true and the tile is large enough, it is split into four tiles.
+ *               Background tiles are not split.
+ */
+
+void returnTile(TileQueue* queue, int self, const struct Tile* tile, int split);
+
+/** @brief Puts a tile whose pass is done back to the end of the queue for the next pass
+ *
+ *         The next pass calculates the points between those of this one.
+ *
+ *  @param queue
+ *  @param self  Index of the queue of the thread
+ *  @param tile  The tile taken with popTile(), with a stride greater than 1
+ */
+
+void refineTile(TileQueue* queue, int self, const struct Tile* tile);
+
+/** @brief Marks a tile as done
+ *
+ *         Stale tiles are only dropped.
+ *
+ *  @param queue
+ *  @param self  Index of the queue of the thread
+ *  @param tile  The tile taken with popTile()
+ */
+
+void finishTile(TileQueue* queue, int self, const struct Tile* tile);
+
+/** @brief Tells if a tile belongs to an older reset
+ *
+ *         Threads should stop working on stale tiles as soon as possible.
+ *
+ *  @param queue
+ *  @param tile  The tile taken with popTile()
+ *  @return 1 if the queue was reset since the tile was taken, else 0
+ */
+
+int isTileStale(TileQueue* queue, const struct Tile* tile);
+
+/** @brief Tells if all tiles since the last reset are done
+ *
+ *         Background tiles don't count. Tiles to draw are done once they
+ *         were all taken, tiles which are done from the start are drawn then.
+ *
+ *  @param queue
+ *  @return 1 if all tiles are done, else 0
+ */
+
+int isTileQueueDone(TileQueue* queue);
+
+/** @brief Tells how long the tiles since the last reset took
+ *
+ *  @param queue
+ *  @return Milliseconds from the last reset until all tiles were done,
+ *          until now if they are not done yet
+ */
+
+uint32_t getTileQueueTime(TileQueue* queue);
+
+/** @brief Waits until no thread works on tiles with this data
+ *
+ *         Tiles taken after the last reset have other data, so this only
+ *         waits for tiles which were taken before. Tiles of the last reset
+ *         are waited for after clearTiles(), then no more are taken.
+ *
+ *  @param queue
+ *  @param data  The data of the last reset but one, or of the last one after clearTiles()
+ */
+
+void waitForTiles(TileQueue* queue, const void* data);
+
+/** @brief Wakes all threads waiting in popTile() and lets it return 0 from now on
+ *
+ *  @param queue
+ */
+
+void stopTileQueue(TileQueue* queue);
+
+#endif /* TILEQUEUE_H */
@@ -0,0 +1,504 @@
+/*  Filename:  tilestore.c
+ *
+ *  Author:    mandex contributors
+ *  Copyright: (c) 2026 mandex contributors. All rights reserved.
+ *             This work is licensed under the terms of the MIT license.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <SDL2/SDL.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include "tilestore.h"
+
+#define STORE_MAGIC "MDXTILES"
+#define STORE_VERSION 3
+#define RECORD_MAGIC 0x54584D4Du
+
+// Start of the file, files of other versions or byte orders are not used
+struct StoreHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t tileSize;
+    uint32_t recordSize;
+    uint32_t reserved;
+};
+
+// A tile as it is in the file, it is ignored unless magic is set
+struct StoreRecord {
+    uint32_t magic;
+    uint32_t checksum;  // of the key and the values
+    struct TileKey key;
+    uint32_t values[CACHE_TILE_SIZE * CACHE_TILE_SIZE];
+    uint8_t smooth[CACHE_TILE_SIZE * CACHE_TILE_SIZE];
+};
+
+struct StoreEntry;
+
+// A tile waiting to be appended, it is read from here until it is mapped
+struct PendingTile {
+    struct PendingTile* next;
+    struct StoreEntry* entry;
+    long offset;                // in the file once written, -1 until then or if it failed
+    struct StoreRecord record;
+};
+
+struct StoreEntry {
+    struct TileKey key;
+    struct StoreEntry* next;    // in the same bucket
+    size_t offset;              // of the record in the file
+    struct PendingTile* pending;
+};
+
+struct FileMapping {
+    const unsigned char* base;
+    size_t size;
+#ifdef _WIN32
+    HANDLE file;
+#else
+    int fd;
+#endif
+};
+
+struct TileStore {
+    FILE* file;                 // appends, used by the writer only
+    struct FileMapping map;
+
+    // used by the main thread only
+    struct StoreEntry** buckets;
+    size_t numBuckets;          // power of two
+    size_t numEntries;
+    uint64_t read;
+
+    // shared with the writer
+    SDL_Thread* writer;
+    SDL_mutex* lock;
+    SDL_cond* wake;
+    struct PendingTile* queue;
+    struct PendingTile** queueEnd;
+    struct PendingTile* written;
+    uint64_t numWritten;
+    int failed;
+    int closing;
+};
+
+#ifdef _WIN32
+
+static void initMapping(struct FileMapping* map)
+{
+    map->base = NULL;
+    map->size = 0;
+    map->file = INVALID_HANDLE_VALUE;
+}
+
+static int openMapping(struct FileMapping* map, const char* path)
+{
+    map->file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                            NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    return map->file != INVALID_HANDLE_VALUE;
+}
+
+static void unmap(struct FileMapping* map)
+{
+    if (map->base)
+        UnmapViewOfFile(map->base);
+    map->base = NULL;
+    map->size = 0;
+}
+
+// Maps the file again if it grew
+static void updateMapping(struct FileMapping* map)
+{
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(map->file, &size) || (size_t)size.QuadPart == map->size)
+        return;
+    unmap(map);
+    HANDLE mapping = CreateFileMappingA(map->file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (!mapping)
+        return;
+    map->base = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    if (map->base)
+        map->size = (size_t)size.QuadPart;
+}
+
+static void closeMapping(struct FileMapping* map)
+{
+    unmap(map);
+    if (map->file != INVALID_HANDLE_VALUE)
+        CloseHandle(map->file);
+}
+
+#else
+
+static void initMapping(struct FileMapping* map)
+{
+    map->base = NULL;
+    map->size = 0;
+    map->fd = -1;
+}
+
+static int openMapping(struct FileMapping* map, const char* path)
+{
+    map->fd = open(path, O_RDONLY);
+    return map->fd >= 0;
+}
+
+static void unmap(struct FileMapping* map)
+{
+    if (map->base)
+        munmap((void*)map->base, map->size);
+    map->base = NULL;
+    map->size = 0;
+}
+
+// Maps the file again if it grew
+static void updateMapping(struct FileMapping* map)
+{
+    struct stat status;
+    if (fstat(map->fd, &status) || (size_t)status.st_size == map->size)
+        return;
+    unmap(map);
+    void* base = mmap(NULL, (size_t)status.st_size, PROT_READ, MAP_SHARED, map->fd, 0);
+    if (base == MAP_FAILED)
+        return;
+    map->base = base;
+    map->size = (size_t)status.st_size;
+}
+
+static void closeMapping(struct FileMapping* map)
+{
+    unmap(map);
+    if (map->fd >= 0)
+        close(map->fd);
+}
+
+#endif
+
+size_t hashTileKey(const struct TileKey* key)
+{
+    uint64_t hash = key->levelX * 0x9E3779B97F4A7C15u;
+    hash ^= key->levelY + 0x9E3779B97F4A7C15u + (hash << 6) + (hash >> 2);
+    hash ^= (uint64_t)key->x * 0xC2B2AE3D27D4EB4Fu;
+    hash ^= (uint64_t)key->y * 0x165667B19E3779F9u;
+    hash ^= key->regionX ^ (key->regionY << 1 | key->regionY >> 63);
+    hash ^= ((uint64_t)key->maxIterations << 8) ^ (uint64_t)key->precision;
+    hash ^= hash >> 29;
+    return (size_t)hash;
+}
+
+int sameTileKey(const struct TileKey* a, const struct TileKey* b)
+{
+    return a->x == b->x && a->y == b->y && a->levelX == b->levelX && a->levelY == b->levelY
+        && a->regionX == b->regionX && a->regionY == b->regionY
+        && a->precision == b->precision && a->maxIterations == b->maxIterations;
+}
+
+// FNV-1a of the words after the checksum
+static uint32_t checksumRecord(const struct StoreRecord* record)
+{
+    const uint32_t* words = (const uint32_t*)&record->key;
+    size_t numWords = (sizeof(struct StoreRecord) - 2 * sizeof(uint32_t)) / sizeof(uint32_t);
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < numWords; ++i)
+        hash = (hash ^ words[i]) * 16777619u;
+    return hash;
+}
+
+static const struct StoreRecord* mappedRecord(const TileStore* store, size_t offset)
+{
+    if (offset + sizeof(struct StoreRecord) > store->map.size)
+        return NULL;
+    return (const struct StoreRecord*)(store->map.base + offset);
+}
+
+static struct StoreEntry** findEntry(TileStore* store, const struct TileKey* key)
+{
+    struct StoreEntry** slot = &store->buckets[hashTileKey(key) & (store->numBuckets - 1)];
+    while (*slot && !sameTileKey(&(*slot)->key, key))
+        slot = &(*slot)->next;
+    return slot;
+}
+
+static void growIndex(TileStore* store)
+{
+    if (store->numEntries <= store->numBuckets)
+        return;
+    struct StoreEntry** buckets = calloc(store->numBuckets * 2, sizeof(struct StoreEntry*));
+    if (!buckets)
+        return;
+    struct StoreEntry** old = store->buckets;
+    size_t numOld = store->numBuckets;
+    store->buckets = buckets;
+    store->numBuckets *= 2;
+    for (size_t i = 0; i < numOld; ++i) {
+        while (old[i]) {
+            struct StoreEntry* entry = old[i];
+            old[i] = entry->next;
+            struct StoreEntry** slot = findEntry(store, &entry->key);
+            entry->next = NULL;
+            *slot = entry;
+        }
+    }
+    free(old);
+}
+
+static int addEntry(TileStore* store, struct StoreEntry** slot, const struct TileKey* key,
+                    size_t offset, struct PendingTile* pending)
+{
+    struct StoreEntry* entry = malloc(sizeof(struct StoreEntry));
+    if (!entry)
+        return 1;
+    entry->key = *key;
+    entry->next = NULL;
+    entry->offset = offset;
+    entry->pending = pending;
+    if (pending)
+        pending->entry = entry;
+    *slot = entry;
+    ++store->numEntries;
+    growIndex(store);
+    return 0;
+}
+
+// Writes the header of a new file, continues a file after the last whole tile
+static int prepareFile(TileStore* store)
+{
+    const struct FileMapping* map = &store->map;
+    if (fseek(store->file, 0, SEEK_END) || ftell(store->file) < 0)
+        return 1;
+    if (ftell(store->file) == 0) {
+        struct StoreHeader header = {STORE_MAGIC, STORE_VERSION, CACHE_TILE_SIZE, sizeof(struct StoreRecord), 0};
+        if (fwrite(&header, sizeof(header), 1, store->file) != 1)
+            return 1;
+        updateMapping(&store->map);
+    }
+
+    const struct StoreHeader* header = (const struct StoreHeader*)map->base;
+    if (map->size < sizeof(struct StoreHeader) || memcmp(header->magic, STORE_MAGIC, sizeof(header->magic))
+        || header->version != STORE_VERSION || header->tileSize != CACHE_TILE_SIZE
+        || header->recordSize != sizeof(struct StoreRecord))
+        return 1;
+
+    // a tile which was cut off is filled up with zeros, it stays unused
+    size_t cut = (map->size - sizeof(struct StoreHeader)) % sizeof(struct StoreRecord);
+    struct StoreRecord empty = {0};
+    if (cut && fwrite(&empty, sizeof(struct StoreRecord) - cut, 1, store->file) != 1)
+        return 1;
+    return 0;
+}
+
+static int readIndex(TileStore* store)
+{
+    size_t count = (store->map.size - sizeof(struct StoreHeader)) / sizeof(struct StoreRecord);
+    store->numBuckets = 256;
+    while (store->numBuckets < count)
+        store->numBuckets *= 2;
+    store->buckets = calloc(store->numBuckets, sizeof(struct StoreEntry*));
+    if (!store->buckets)
+        return 1;
+
+    for (size_t i = 0; i < count; ++i) {
+        size_t offset = sizeof(struct StoreHeader) + i * sizeof(struct StoreRecord);
+        const struct StoreRecord* record = mappedRecord(store, offset);
+        if (record->magic != RECORD_MAGIC)
+            continue;
+        struct StoreEntry** slot = findEntry(store, &record->key);
+        if (!*slot && addEntry(store, slot, &record->key, offset, NULL))
+            return 1;
+    }
+    return 0;
+}
+
+static int writeTiles(void* data)
+{
+    TileStore* store = data;
+    SDL_LockMutex(store->lock);
+    for (;;) {
+        while (!store->queue && !store->closing)
+            SDL_CondWait(store->wake, store->lock);
+        struct PendingTile* tile = store->queue;
+        if (!tile)
+            break;
+        store->queue = tile->next;
+        if (!store->queue)
+            store->queueEnd = &store->queue;
+        SDL_UnlockMutex(store->lock);
+
+        // the file is unbuffered, so the tile is appended at once
+        long end = -1;
+        if (fwrite(&tile->record, sizeof(struct StoreRecord), 1, store->file) == 1)
+            end = ftell(store->file);
+
+        SDL_LockMutex(store->lock);
+        tile->offset = end < 0 ? -1 : end - (long)sizeof(struct StoreRecord);
+        tile->next = store->written;
+        store->written = tile;
+        if (end < 0)
+            store->failed = 1;
+        else
+            ++store->numWritten;
+    }
+    SDL_UnlockMutex(store->lock);
+    return 0;
+}
+
+// Tiles appended to the file are read from the mapping from now on
+static void collectWritten(TileStore* store)
+{
+    SDL_LockMutex(store->lock);
+    struct PendingTile* tile = store->written;
+    store->written = NULL;
+    SDL_UnlockMutex(store->lock);
+    if (!tile)
+        return;
+
+    updateMapping(&store->map);
+    while (tile) {
+        struct PendingTile* next = tile->next;
+        if (tile->offset >= 0 && mappedRecord(store, (size_t)tile->offset)) {
+            tile->entry->offset = (size_t)tile->offset;
+            tile->entry->pending = NULL;
+            free(tile);
+        }
+        tile = next;
+    }
+}
+
+TileStore* openTileStore(const char* path)
+{
+    TileStore* store = calloc(1, sizeof(TileStore));
+    if (!store)
+        return NULL;
+    initMapping(&store->map);
+    store->queueEnd = &store->queue;
+
+    store->file = fopen(path, "ab");
+    if (!store->file || setvbuf(store->file, NULL, _IONBF, 0) || !openMapping(&store->map, path)) {
+        closeTileStore(store);
+        return NULL;
+    }
+    updateMapping(&store->map);
+    if (prepareFile(store) || readIndex(store)) {
+        closeTileStore(store);
+        return NULL;
+    }
+
+    store->lock = SDL_CreateMutex();
+    store->wake = SDL_CreateCond();
+    if (store->lock && store->wake)
+        store->writer = SDL_CreateThread(writeTiles, "tilestore", store);
+    if (!store->writer) {
+        closeTileStore(store);
+        return NULL;
+    }
+    return store;
+}
+
+void closeTileStore(TileStore* store)
+{
+    if (!store)
+        return;
+    if (store->writer) {
+        SDL_LockMutex(store->lock);
+        store->closing = 1;
+        SDL_CondSignal(store->wake);
+        SDL_UnlockMutex(store->lock);
+        SDL_WaitThread(store->writer, NULL);
+    }
+
+    // every tile not freed yet belongs to an entry
+    for (size_t i = 0; store->buckets && i < store->numBuckets; ++i) {
+        struct StoreEntry* entry = store->buckets[i];
+        while (entry) {
+            struct StoreEntry* next = entry->next;
+            free(entry->pending);
+            free(entry);
+            entry = next;
+        }
+    }
+    free(store->buckets);
+    if (store->wake)
+        SDL_DestroyCond(store->wake);
+    if (store->lock)
+        SDL_DestroyMutex(store->lock);
+    if (store->file)
+        fclose(store->file);
+    closeMapping(&store->map);
+    free(store);
+}
+
+int readStoreTile(TileStore* store, const struct TileKey* key, uint32_t* values, uint8_t* smooth)
+{
+    collectWritten(store);
+    struct StoreEntry** slot = findEntry(store, key);
+    struct StoreEntry* entry = *slot;
+    if (!entry)
+        return 0;
+
+    const struct StoreRecord* record = entry->pending ? &entry->pending->record : mappedRecord(store, entry->offset);
+    if (!record)
+        return 0;
+    if (record->checksum != checksumRecord(record)) {
+        // damaged in the file, it is appended again when it was calculated
+        *slot = entry->next;
+        --store->numEntries;
+        free(entry);
+        return 0;
+    }
+    memcpy(values, record->values, sizeof(record->values));
+    memcpy(smooth, record->smooth, sizeof(record->smooth));
+    ++store->read;
+    return 1;
+}
+
+void writeStoreTile(TileStore* store, const struct TileKey* key, const uint32_t* values, const uint8_t* smooth)
+{
+    collectWritten(store);
+    struct StoreEntry** slot = findEntry(store, key);
+    if (*slot)
+        return;
+
+    SDL_LockMutex(store->lock);
+    int failed = store->failed;
+    SDL_UnlockMutex(store->lock);
+    if (failed)
+        return;
+
+    struct PendingTile* tile = malloc(sizeof(struct PendingTile));
+    if (!tile)
+        return;
+    tile->next = NULL;
+    tile->offset = -1;
+    tile->record.magic = RECORD_MAGIC;
+    tile->record.key = *key;
+    memcpy(tile->record.values, values, sizeof(tile->record.values));
+    memcpy(tile->record.smooth, smooth, sizeof(tile->record.smooth));
+    tile->record.checksum = checksumRecord(&tile->record);
+    if (addEntry(store, slot, key, 0, tile)) {
+        free(tile);
+        return;
+    }
+
+    SDL_LockMutex(store->lock);
+    *store->queueEnd = tile;
+    store->queueEnd = &tile->next;
+    SDL_CondSignal(store->wake);
+    SDL_UnlockMutex(store->lock);
+}
+
+void getTileStoreStats(TileStore* store, uint64_t* read, uint64_t* written)
+{
+    *read = store->read;
+    SDL_LockMutex(store->lock);
+    *written = store->numWritten;
+    SDL_UnlockMutex(store->lock);
+}
@@ -0,0 +1,101 @@
+/** @file        tilestore.h
+ *
+ *  @brief       Keeps the tiles of the cache in a file across sessions.
+ *
+ *               The file only grows: tiles are appended by a background thread
+ *               and read through a memory mapping of the file. Programs which
+ *               share the file append whole tiles, so they can use it at once.
+ *
+ *  @version     1.0
+ *  @date        10/17/2026
+ *  Revision:    -
+ *
+ *  @author      mandex contributors
+ *  @copyright   Copyright (c) 2026 mandex contributors. All rights reserved.
+ *               This work is licensed under the terms of the MIT license.
+ */
+
+#ifndef TILESTORE_H
+#define TILESTORE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Width and height of a tile of the cache in points
+#define CACHE_TILE_SIZE 32
+
+// Identifies a tile: the depth and budget of its grid and its position on it
+struct TileKey {
+    uint64_t levelX;
+    uint64_t levelY;
+    int32_t precision;
+    uint32_t maxIterations;
+    uint64_t regionX;   // region of the grid, see struct GridPosition
+    uint64_t regionY;
+    int64_t x;          // position in tiles in the region
+    int64_t y;
+};
+
+typedef struct TileStore TileStore;
+
+/** @brief Hash of a key for tables of tiles
+ *
+ *  @param key
+ *  @return hash
+ */
+
+size_t hashTileKey(const struct TileKey* key);
+
+/** @brief Compares two keys
+ *
+ *  @return 1 if they identify the same tile, else 0
+ */
+
+int sameTileKey(const struct TileKey* a, const struct TileKey* b);
+
+/** @brief Opens the file of a store, it is created if it doesn't exist
+ *
+ *  @param path
+ *  @return Pointer to the store, NULL if the file can't be used. Must be closed with closeTileStore().
+ */
+
+TileStore* openTileStore(const char* path);
+
+/** @brief Writes the tiles still waiting and closes the store
+ *
+ *  @param store May be NULL.
+ */
+
+void closeTileStore(TileStore* store);
+
+/** @brief Reads a tile from the store
+ *
+ *  @param store
+ *  @param key
+ *  @param values Receives CACHE_TILE_SIZE * CACHE_TILE_SIZE values of diverged
+ *  @param smooth Receives as many smooth values
+ *  @return 1 if the tile was found, else 0
+ */
+
+int readStoreTile(TileStore* store, const struct TileKey* key, uint32_t* values, uint8_t* smooth);
+
+/** @brief Appends a tile to the file in the background, if it isn't in the store
+ *
+ *  @param store
+ *  @param key
+ *  @param values CACHE_TILE_SIZE * CACHE_TILE_SIZE values of diverged, they are copied
+ *  @param smooth As many smooth values
+ */
+
+void writeStoreTile(TileStore* store, const struct TileKey* key, const uint32_t* values, const uint8_t* smooth);
+
+/** @brief Returns how many tiles were read from the store and written to it
+ *
+ *  @param store
+ *  @param read    Receives the number of tiles read
+ *  @param written Receives the number of tiles appended to the file
+ */
+
+void getTileStoreStats(TileStore* store, uint64_t* read, uint64_t* written);
+
+#endif /* TILESTORE_H */
@@ -18,6 +18,7 @@ struct window
     SDL_Renderer*   renderer;
     int             width;
     int             height;
+    SDL_atomic_t    redraw;     // all pixels are copied at the next update
 };
 
 // Points to string containg the last error message
@@ -38,6 +39,19 @@ static int initSDL() {
     return 0;
 }
 
+// Events are watched while they are queued, so the application needn't pass them on
+static int SDLCALL watchEvents(void* data, SDL_Event* event)
+{
+    Window* window = data;
+    if (event->type == SDL_RENDER_TARGETS_RESET || event->type == SDL_RENDER_DEVICE_RESET)
+        SDL_AtomicSet(&window->redraw, 1);
+    if (event->type == SDL_WINDOWEVENT
+        && (event->window.event == SDL_WINDOWEVENT_EXPOSED || event->window.event == SDL_WINDOWEVENT_RESTORED
+            || event->window.event == SDL_WINDOWEVENT_SIZE_CHANGED))
+        SDL_AtomicSet(&window->redraw, 1);
+    return 1;
+}
+
 // both window_create functions have to do this
 static int window_init(Window* window)
 {
@@ -62,6 +76,8 @@ static int window_init(Window* window)
         free(window);
         return 1;
     }
+    SDL_AtomicSet(&window->redraw, 1);
+    SDL_AddEventWatch(watchEvents, window);
     return 0;
 }
 
@@ -98,6 +114,7 @@ Window* window_create(const char* name)
 
 void window_destroy(Window* window)
 {
+    SDL_DelEventWatch(watchEvents, window);
     SDL_DestroyRenderer(window->renderer);
     SDL_DestroyWindow(window->sdlWindow);
     SDL_DestroyTexture(window->texture);
@@ -107,15 +124,29 @@ void window_destroy(Window* window)
         SDL_Quit();
 }
 
-int window_update(Window* window, const uint32_t* pixels)
+int window_update(Window* window, const struct WindowRect* rects, int numRects, WindowDraw draw, void* data)
 {
-    int check = SDL_UpdateTexture( window->texture,
-                                    NULL,
-                                    pixels,
-                                    window->width * sizeof(uint32_t));
-    if (check) {
-        errmsg = SDL_GetError();
-        return -1;
+    // the texture keeps what was copied before, unless the renderer lost it
+    int redraw = SDL_AtomicSet(&window->redraw, 0);
+    if (!redraw && numRects == 0)
+        return 0;
+    struct WindowRect all = {0, 0, window->width, window->height};
+    if (redraw) {
+        rects = &all;
+        numRects = 1;
+    }
+
+    // the pixels are drawn right into the memory of the texture
+    for (int i = 0; i < numRects; ++i) {
+        SDL_Rect rect = {rects[i].x, rects[i].y, rects[i].width, rects[i].height};
+        void* pixels;
+        int pitch;
+        if (SDL_LockTexture(window->texture, &rect, &pixels, &pitch)) {
+            errmsg = SDL_GetError();
+            return -1;
+        }
+        draw(data, &rects[i], pixels, pitch / (int)sizeof(uint32_t));
+        SDL_UnlockTexture(window->texture);
     }
     if (SDL_RenderClear(window->renderer)) {
         errmsg = SDL_GetError();
@@ -139,6 +170,11 @@ int window_getWidth(Window* window)
     return window->width;
 }
 
+void window_setTitle(Window* window, const char* title)
+{
+    SDL_SetWindowTitle(window->sdlWindow, title);
+}
+
 const char* window_getError()
 {
     return errmsg;
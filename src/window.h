@@ -23,6 +23,17 @@
 
 typedef struct window Window;
 
+/**
+ * A part of the window in pixels.
+ */
+
+struct WindowRect {
+    int x;
+    int y;
+    int width;
+    int height;
+};
+
 /** @brief Creates a window
  *
  *  Must be freed with window_destroy.
@@ -42,14 +53,31 @@ Window* window_create(const char* name);
 
 void window_destroy(Window* window);
 
-/** @brief Displays the pixels in buffer on the window
+/** @brief Draws a part of the window
+*
+*   @param data - Passed to window_update
+*   @param rect - The part
+*   @param pixels - The pixel of the top left of rect, all pixels of the part must be written
+*   @param pitch - Pixels from one row to the next
+*/
+
+typedef void (*WindowDraw)(void* data, const struct WindowRect* rect, uint32_t* pixels, int pitch);
+
+/** @brief Displays the parts of the window which changed
+*
+*   The parts are drawn right into the texture of the window. Without any the
+*   window is left as it is, unless it must be redrawn, e.g. after it was covered.
+*   Then all of it is drawn.
 *
 *   @param window
-*   @param pixels - Must at least have width*height elements
+*   @param rects - The parts which changed since the last update
+*   @param numRects - Number of rects, may be 0
+*   @param draw - Draws each part
+*   @param data - Passed to draw
 *   @return 0 on success
 */
 
-int window_update(Window* window, const uint32_t* pixels);
+int window_update(Window* window, const struct WindowRect* rects, int numRects, WindowDraw draw, void* data);
 
 /** @brief Returns the height of the window
 *
@@ -67,6 +95,14 @@ int window_getHeight(Window* window);
 
 int window_getWidth(Window* window);
 
+/** @brief Changes the title of the window
+*
+*   @param window
+*   @param title
+*/
+
+void window_setTitle(Window* window, const char* title);
+
 /** @brief Returns a string with a description of the last occured error.
 *
 *   @param void